@@ -0,0 +1,230 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <cstring>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+/** Size of a cache line, on which the children of a node are aligned. */
+static const uint32_t CACHE_LINE = 64;
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<DaryHeapScheduler> ()
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+  : m_keys (0),
+    m_end (ROOT),
+    m_capacity (0)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (ARITY * sizeof (Key) == CACHE_LINE);
+  Grow ();
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+inline bool
+DaryHeapScheduler::IsLess (const Key &a, const Key &b)
+{
+  return a.ts < b.ts || (a.ts == b.ts && a.uidCtx < b.uidCtx);
+}
+
+inline uint32_t
+DaryHeapScheduler::FirstChild (uint32_t i)
+{
+  return ARITY * (i - ROOT + 1);
+}
+
+inline uint32_t
+DaryHeapScheduler::Parent (uint32_t i)
+{
+  return i / ARITY + ROOT - 1;
+}
+
+void
+DaryHeapScheduler::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t capacity = m_capacity == 0 ? 64 * ARITY : 2 * m_capacity;
+  std::vector<uint8_t> storage (capacity * sizeof (Key) + CACHE_LINE);
+  uintptr_t address = reinterpret_cast<uintptr_t> (&storage[0]);
+  Key *keys = reinterpret_cast<Key *> ((address + CACHE_LINE - 1) & ~(uintptr_t)(CACHE_LINE - 1));
+  if (m_end > ROOT)
+    {
+      std::memcpy (keys + ROOT, m_keys + ROOT, (m_end - ROOT) * sizeof (Key));
+    }
+  m_keyStorage.swap (storage);
+  m_keys = keys;
+  m_impls.resize (capacity);
+  m_capacity = capacity;
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t i, const Key &key, EventImpl *impl)
+{
+  while (i > ROOT)
+    {
+      uint32_t parent = Parent (i);
+      if (!IsLess (key, m_keys[parent]))
+        {
+          break;
+        }
+      m_keys[i] = m_keys[parent];
+      m_impls[i] = m_impls[parent];
+      i = parent;
+    }
+  m_keys[i] = key;
+  m_impls[i] = impl;
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t i, const Key &key, EventImpl *impl)
+{
+  while (true)
+    {
+      uint32_t first = FirstChild (i);
+      if (first >= m_end)
+        {
+          break;
+        }
+      // the smallest child, all of them being in the same cache line
+      uint32_t last = first + ARITY < m_end ? first + ARITY : m_end;
+      uint32_t smallest = first;
+      for (uint32_t c = first + 1; c < last; c++)
+        {
+          if (IsLess (m_keys[c], m_keys[smallest]))
+            {
+              smallest = c;
+            }
+        }
+      if (!IsLess (m_keys[smallest], key))
+        {
+          break;
+        }
+      m_keys[i] = m_keys[smallest];
+      m_impls[i] = m_impls[smallest];
+      i = smallest;
+    }
+  m_keys[i] = key;
+  m_impls[i] = impl;
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (m_end == m_capacity)
+    {
+      Grow ();
+    }
+  Key key;
+  key.ts = ev.key.m_ts;
+  key.uidCtx = (static_cast<uint64_t> (ev.key.m_uid) << 32) | ev.key.m_context;
+  SiftUp (m_end++, key, ev.impl);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_end == ROOT;
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev;
+  ev.impl = m_impls[ROOT];
+  ev.key.m_ts = m_keys[ROOT].ts;
+  ev.key.m_uid = m_keys[ROOT].uidCtx >> 32;
+  ev.key.m_context = m_keys[ROOT].uidCtx & 0xffffffff;
+  return ev;
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  Scheduler::Event ev = PeekNext ();
+  m_end--;
+  if (m_end > ROOT)
+    {
+      SiftDown (ROOT, m_keys[m_end], m_impls[m_end]);
+    }
+  return ev;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  uint32_t uid = ev.key.m_uid;
+  for (uint32_t i = ROOT; i < m_end; i++)
+    {
+      if (m_keys[i].ts == ts && (m_keys[i].uidCtx >> 32) == uid)
+        {
+          NS_ASSERT (m_impls[i] == ev.impl);
+          m_end--;
+          if (i == m_end)
+            {
+              return;
+            }
+          // move the last event to the free slot, then up or down
+          Key key = m_keys[m_end];
+          EventImpl *impl = m_impls[m_end];
+          if (i > ROOT && IsLess (key, m_keys[Parent (i)]))
+            {
+              SiftUp (i, key, impl);
+            }
+          else
+            {
+              SiftDown (i, key, impl);
+            }
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a 4-ary heap event scheduler
+ *
+ * This event scheduler is a d-ary heap with ARITY (4) children per node.
+ * The keys are packed into 16 bytes, the timestamp followed by the uid
+ * and the context, so that comparing two keys is a 128-bit compare: as
+ * the uid is unique, the context never decides the order. The keys are
+ * stored in an array aligned on 64 bytes, in which the 4 children of a
+ * node share a cache line, and the EventImpl pointers are stored in a
+ * parallel array which is only touched when an event moves. Hence
+ * sifting an event down the heap reads one cache line per level, and the
+ * heap is half as deep as a binary heap.
+ *
+ * Removing an event which is not the next one (Simulator::Remove) is
+ * linear in the number of events.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  DaryHeapScheduler ();
+  /** Destructor. */
+  virtual ~DaryHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Number of children per node. */
+  static const uint32_t ARITY = 4;
+  /**
+   * Index of the root in the arrays. The slots before the root are
+   * unused, so that the children of every node start on a cache line.
+   */
+  static const uint32_t ROOT = ARITY - 1;
+
+  /** A packed event key. */
+  struct Key
+  {
+    uint64_t ts;       //!< Timestamp
+    uint64_t uidCtx;   //!< Uid in the upper 32 bits, context in the lower 32 bits
+  };
+
+  /**
+   * Compare (less than) two keys.
+   *
+   * \param [in] a The first key.
+   * \param [in] b The second key.
+   * \returns \c true if \p a < \p b
+   */
+  static bool IsLess (const Key &a, const Key &b);
+  /**
+   * Get the first child of a node.
+   *
+   * \param [in] i The index of the node.
+   * \returns The index of the first child.
+   */
+  static uint32_t FirstChild (uint32_t i);
+  /**
+   * Get the parent of a node.
+   *
+   * \param [in] i The index of the node, which is not the root.
+   * \returns The index of the parent.
+   */
+  static uint32_t Parent (uint32_t i);
+
+  /** Double the capacity of the arrays. */
+  void Grow (void);
+  /**
+   * Move an event up from a free slot to its place.
+   *
+   * \param [in] i The free slot.
+   * \param [in] key The key of the event.
+   * \param [in] impl The event.
+   */
+  void SiftUp (uint32_t i, const Key &key, EventImpl *impl);
+  /**
+   * Move an event down from a free slot to its place.
+   *
+   * \param [in] i The free slot.
+   * \param [in] key The key of the event.
+   * \param [in] impl The event.
+   */
+  void SiftDown (uint32_t i, const Key &key, EventImpl *impl);
+
+  /** Storage of the keys, of which m_keys is the part aligned on a cache line. */
+  std::vector<uint8_t> m_keyStorage;
+  /** The keys, the root being at index ROOT. */
+  Key *m_keys;
+  /** The events, at the same indexes as their key. */
+  std::vector<EventImpl *> m_impls;
+  /** Index of the slot after the last event. */
+  uint32_t m_end;
+  /** Number of slots of m_keys. */
+  uint32_t m_capacity;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-allocator.h"
+#include "log.h"
+#include <new>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventAllocator implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventAllocator");
+
+namespace {
+
+/** A free block, linked in the free list of its size class. */
+struct FreeBlock
+{
+  FreeBlock *next;  //!< Next free block
+};
+
+/**
+ * The free lists and the counters of a thread. This is a POD, so that
+ * the thread_local instance is statically initialized.
+ */
+struct ThreadCache
+{
+  FreeBlock *free[EventAllocator::N_CLASSES];    //!< Free lists
+  uint32_t nFree[EventAllocator::N_CLASSES];     //!< Length of the free lists
+  EventAllocator::Stats stats;                   //!< Counters
+  bool registered;  //!< Whether the ThreadCacheReleaser of the thread exists
+  bool released;    //!< Whether the thread is exiting
+};
+
+/**
+ * The cache of the calling thread. The initial-exec TLS model avoids a
+ * call to __tls_get_addr on every access, which would cost as much as
+ * malloc itself; the cache is small enough to fit in the static TLS
+ * space reserved for the libraries loaded with dlopen (python bindings).
+ */
+__attribute__ ((tls_model ("initial-exec"))) thread_local ThreadCache g_cache;
+
+/** Release the blocks of the cache of a thread when the thread exits. */
+struct ThreadCacheReleaser
+{
+  ~ThreadCacheReleaser ()
+  {
+    for (uint32_t i = 0; i < EventAllocator::N_CLASSES; i++)
+      {
+        while (g_cache.free[i] != 0)
+          {
+            FreeBlock *block = g_cache.free[i];
+            g_cache.free[i] = block->next;
+            ::operator delete (block);
+          }
+        g_cache.nFree[i] = 0;
+      }
+    g_cache.stats.cached = 0;
+    // events freed later on (e.g., by static destructors) bypass the cache
+    g_cache.released = true;
+  }
+};
+
+/** Create the ThreadCacheReleaser of the calling thread. */
+void
+RegisterThreadCache (void)
+{
+  static thread_local ThreadCacheReleaser releaser;
+  (void) &releaser;
+  g_cache.registered = true;
+}
+
+} // unnamed namespace
+
+void *
+EventAllocator::Allocate (std::size_t size)
+{
+  ThreadCache &cache = g_cache;
+  cache.stats.allocations++;
+  if (size > MAX_SIZE)
+    {
+      cache.stats.oversized++;
+      return ::operator new (size);
+    }
+  uint32_t sizeClass = (size - 1) / GRANULARITY;
+  if (cache.released)
+    {
+      // the block may still be freed by a thread whose cache is alive and
+      // reused there: give it the whole size class too
+      return ::operator new ((sizeClass + 1) * GRANULARITY);
+    }
+  FreeBlock *block = cache.free[sizeClass];
+  if (block != 0)
+    {
+      cache.free[sizeClass] = block->next;
+      cache.nFree[sizeClass]--;
+      cache.stats.cached--;
+      cache.stats.hits++;
+      return block;
+    }
+  if (!cache.registered)
+    {
+      RegisterThreadCache ();
+    }
+  // allocate the whole size class, so that the block fits any object of
+  // the class when it is reused
+  return ::operator new ((sizeClass + 1) * GRANULARITY);
+}
+
+void
+EventAllocator::Deallocate (void *p, std::size_t size)
+{
+  ThreadCache &cache = g_cache;
+  cache.stats.frees++;
+  if (size > MAX_SIZE || cache.released)
+    {
+      ::operator delete (p);
+      return;
+    }
+  uint32_t sizeClass = (size - 1) / GRANULARITY;
+  if (cache.nFree[sizeClass] == MAX_CACHED)
+    {
+      ::operator delete (p);
+      return;
+    }
+  if (!cache.registered)
+    {
+      RegisterThreadCache ();
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = cache.free[sizeClass];
+  cache.free[sizeClass] = block;
+  cache.nFree[sizeClass]++;
+  cache.stats.cached++;
+}
+
+EventAllocator::Stats
+EventAllocator::GetStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_cache.stats;
+}
+
+double
+EventAllocator::GetHitRate (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  const Stats &stats = g_cache.stats;
+  if (stats.allocations == 0)
+    {
+      return 0;
+    }
+  return static_cast<double> (stats.hits) / stats.allocations;
+}
+
+void
+EventAllocator::ResetStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Stats &stats = g_cache.stats;
+  stats.allocations = 0;
+  stats.hits = 0;
+  stats.oversized = 0;
+  stats.frees = 0;
+}
+
+void
+EventAllocator::PrintStats (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  const Stats &stats = g_cache.stats;
+  os << "event allocations: " << stats.allocations
+     << ", free list hits: " << stats.hits
+     << " (" << 100 * GetHitRate () << "%)"
+     << ", oversized: " << stats.oversized
+     << ", frees: " << stats.frees
+     << ", cached blocks: " << stats.cached;
+}
+
+} // namespace ns3
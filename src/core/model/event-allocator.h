@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_ALLOCATOR_H
+#define EVENT_ALLOCATOR_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventAllocator declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief The memory allocator of the EventImpl objects.
+ *
+ * Every Simulator::Schedule allocates an EventImpl (which holds the
+ * bound arguments of the event) and frees it once the event has run.
+ * This allocator serves these allocations from per-thread free lists,
+ * one per size class of GRANULARITY bytes up to MAX_SIZE bytes, so
+ * that once the event population has been reached scheduling an event
+ * neither calls malloc nor takes a lock. Larger objects are handed to
+ * the global operator new.
+ *
+ * A free list keeps at most MAX_CACHED blocks, so that the blocks
+ * allocated by a thread and freed by another one (e.g., the events
+ * scheduled by the reader thread of a realtime simulation) do not
+ * accumulate. The blocks cached by a thread are released when the
+ * thread exits.
+ */
+class EventAllocator
+{
+public:
+  static const uint32_t GRANULARITY = 16;   //!< Size step between size classes, in bytes
+  static const uint32_t N_CLASSES = 16;     //!< Number of size classes
+  static const uint32_t MAX_SIZE = GRANULARITY * N_CLASSES; //!< Largest pooled size, in bytes
+  static const uint32_t MAX_CACHED = 65536; //!< Maximum number of free blocks per size class
+
+  /** Allocator statistics, for the calling thread. */
+  struct Stats
+  {
+    uint64_t allocations;  //!< Number of allocations
+    uint64_t hits;         //!< Number of allocations served from a free list
+    uint64_t oversized;    //!< Number of allocations larger than MAX_SIZE
+    uint64_t frees;        //!< Number of deallocations
+    uint64_t cached;       //!< Number of blocks currently in the free lists
+  };
+
+  /**
+   * Allocate memory for an EventImpl.
+   *
+   * \param [in] size The size of the object.
+   * \returns The memory.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * Free memory obtained from Allocate().
+   *
+   * \param [in] p The memory.
+   * \param [in] size The size of the object.
+   */
+  static void Deallocate (void *p, std::size_t size);
+
+  /**
+   * Get the statistics of the calling thread.
+   *
+   * \returns The statistics.
+   */
+  static Stats GetStats (void);
+  /**
+   * Get the fraction of the allocations of the calling thread served
+   * from a free list.
+   *
+   * \returns The hit rate, in [0, 1], or zero if nothing was allocated.
+   */
+  static double GetHitRate (void);
+  /**
+   * Reset the counters of the calling thread (the free lists are kept).
+   */
+  static void ResetStats (void);
+  /**
+   * Print the statistics of the calling thread.
+   *
+   * \param [in,out] os The output stream.
+   */
+  static void PrintStats (std::ostream &os);
+};
+
+} // namespace ns3
+
+#endif /* EVENT_ALLOCATOR_H */
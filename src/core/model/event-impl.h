@@ -21,7 +21,9 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
+#include "event-allocator.h"
 
 /**
  * \file
@@ -66,6 +68,30 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate an event (of any subclass) with the EventAllocator.
+   *
+   * \param [in] size The size of the event.
+   * \returns The memory.
+   */
+  static void * operator new (std::size_t size)
+  {
+    return EventAllocator::Allocate (size);
+  }
+  /**
+   * Free an event allocated with the EventAllocator.
+   *
+   * The destructor is virtual, hence \p size is the size of the
+   * most derived class.
+   *
+   * \param [in] p The memory.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *p, std::size_t size)
+  {
+    EventAllocator::Deallocate (p, size);
+  }
+
 protected:
   /**
    * Implementation for Invoke().
@@ -0,0 +1,362 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+#include <limits>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (std::numeric_limits<uint64_t>::max ()),
+    m_topMax (0),
+    m_topStart (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  NS_LOG_FUNCTION (this << ts);
+  // the rungs are nested: the first rung whose current bucket does not
+  // start after the event holds it. A rung whose buckets have all been
+  // consumed (but whose last bucket was split) holds nothing.
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      const Rung &rung = m_rungs[i];
+      if (rung.currentBucket < rung.nBuckets && ts >= rung.current)
+        {
+          return i;
+        }
+    }
+  return m_nRungs;
+}
+
+uint32_t
+LadderScheduler::FindBucket (const Rung &rung, uint64_t ts) const
+{
+  NS_LOG_FUNCTION (this << ts);
+  uint64_t bucket = (ts - rung.start) / rung.width;
+  // an inner rung may end before the bucket of the outer rung it was split
+  // from: the events after its end are kept, in order, in its last bucket
+  return bucket < rung.nBuckets ? bucket : rung.nBuckets - 1;
+}
+
+uint64_t
+LadderScheduler::SpawnRung (const std::vector<Scheduler::Event> &events, uint32_t begin,
+                            uint64_t minTs, uint64_t maxTs)
+{
+  NS_LOG_FUNCTION (this << begin << minTs << maxTs);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  NS_ASSERT (events.size () > begin);
+
+  // about one event per bucket
+  uint32_t n = events.size () - begin;
+  Rung &rung = m_rungs[m_nRungs++];
+  rung.width = (maxTs - minTs) / n + 1;
+  rung.nBuckets = (maxTs - minTs) / rung.width + 1;
+  rung.start = minTs;
+  rung.current = minTs;
+  rung.currentBucket = 0;
+  if (rung.buckets.size () < rung.nBuckets)
+    {
+      // the buckets of a previous use of this rung keep their capacity
+      rung.buckets.resize (rung.nBuckets);
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = events.begin () + begin;
+       i != events.end (); i++)
+    {
+      rung.buckets[(i->key.m_ts - minTs) / rung.width].push_back (*i);
+    }
+  NS_LOG_DEBUG ("rung " << m_nRungs - 1 << ": " << n << " events, "
+                << rung.nBuckets << " buckets of width " << rung.width);
+  return minTs + rung.nBuckets * rung.width;
+}
+
+void
+LadderScheduler::SortIntoBottom (const std::vector<Scheduler::Event> &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottomHead == m_bottom.size ());
+  m_bottom.assign (events.begin (), events.end ());
+  m_bottomHead = 0;
+  std::sort (m_bottom.begin (), m_bottom.end ());
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottomHead == m_bottom.size ());
+
+  while (true)
+    {
+      // drop the innermost rungs whose buckets have all been consumed
+      while (m_nRungs > 0 && m_rungs[m_nRungs - 1].currentBucket == m_rungs[m_nRungs - 1].nBuckets)
+        {
+          m_nRungs--;
+        }
+
+      if (m_nRungs == 0)
+        {
+          if (m_top.empty ())
+            {
+              return;
+            }
+          if (m_top.size () <= THRESHOLD || m_topMin == m_topMax)
+            {
+              SortIntoBottom (m_top);
+              m_topStart = m_topMax + 1;
+            }
+          else
+            {
+              m_topStart = SpawnRung (m_top, 0, m_topMin, m_topMax);
+            }
+          m_top.clear ();
+          m_topMin = std::numeric_limits<uint64_t>::max ();
+          m_topMax = 0;
+          continue;
+        }
+
+      // find the next non-empty bucket of the innermost rung
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.currentBucket < rung.nBuckets && rung.buckets[rung.currentBucket].empty ())
+        {
+          rung.currentBucket++;
+        }
+      if (rung.currentBucket == rung.nBuckets)
+        {
+          continue;
+        }
+      Bucket &bucket = rung.buckets[rung.currentBucket];
+      rung.currentBucket++;
+      rung.current = rung.start + rung.currentBucket * rung.width;
+
+      uint64_t minTs = std::numeric_limits<uint64_t>::max ();
+      uint64_t maxTs = 0;
+      for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); i++)
+        {
+          minTs = std::min (minTs, i->key.m_ts);
+          maxTs = std::max (maxTs, i->key.m_ts);
+        }
+      if (bucket.size () <= THRESHOLD || minTs == maxTs || m_nRungs == MAX_RUNGS)
+        {
+          SortIntoBottom (bucket);
+          bucket.clear ();
+          return;
+        }
+      // too many events to sort: split the bucket into a finer rung
+      SpawnRung (bucket, 0, minTs, maxTs);
+      bucket.clear ();
+    }
+}
+
+void
+LadderScheduler::InsertBottom (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  std::vector<Scheduler::Event>::iterator pos =
+    std::upper_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+  if (pos == m_bottom.begin () + m_bottomHead && m_bottomHead > 0)
+    {
+      // the new next event takes the slot of the last dequeued one
+      m_bottom[--m_bottomHead] = ev;
+    }
+  else
+    {
+      m_bottom.insert (pos, ev);
+    }
+
+  // keep the Bottom short, so that inserting in it stays cheap
+  while (m_nRungs > 0 && m_rungs[m_nRungs - 1].currentBucket == m_rungs[m_nRungs - 1].nBuckets)
+    {
+      m_nRungs--;
+    }
+  uint64_t minTs = m_bottom[m_bottomHead].key.m_ts;
+  uint64_t maxTs = m_bottom.back ().key.m_ts;
+  if (m_bottom.size () - m_bottomHead > THRESHOLD && minTs != maxTs && m_nRungs < MAX_RUNGS)
+    {
+      NS_LOG_DEBUG ("split the bottom");
+      SpawnRung (m_bottom, m_bottomHead, minTs, maxTs);
+      m_bottom.clear ();
+      m_bottomHead = 0;
+      FillBottom ();
+    }
+}
+
+void
+LadderScheduler::DoInsert (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      return;
+    }
+  uint32_t i = FindRung (ts);
+  if (i < m_nRungs)
+    {
+      m_rungs[i].buckets[FindBucket (m_rungs[i], ts)].push_back (ev);
+      return;
+    }
+  InsertBottom (ev);
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  DoInsert (ev);
+  m_size++;
+  // the next event is always at the head of the Bottom
+  if (m_bottomHead == m_bottom.size ())
+    {
+      FillBottom ();
+    }
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom[m_bottomHead];
+}
+
+void
+LadderScheduler::Removed (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_size--;
+  if (m_size == 0)
+    {
+      // start afresh, so that the next events are spread from the Top
+      NS_ASSERT (m_top.empty () && m_bottomHead == m_bottom.size ());
+      m_bottom.clear ();
+      m_bottomHead = 0;
+      m_nRungs = 0;
+      m_topStart = 0;
+    }
+  else if (m_bottomHead == m_bottom.size ())
+    {
+      m_bottom.clear ();
+      m_bottomHead = 0;
+      FillBottom ();
+    }
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev = m_bottom[m_bottomHead++];
+  Removed ();
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  uint32_t uid = ev.key.m_uid;
+
+  std::vector<Scheduler::Event> *events;
+  if (ts >= m_topStart)
+    {
+      events = &m_top;
+    }
+  else
+    {
+      uint32_t i = FindRung (ts);
+      if (i < m_nRungs)
+        {
+          events = &m_rungs[i].buckets[FindBucket (m_rungs[i], ts)];
+        }
+      else
+        {
+          std::vector<Scheduler::Event>::iterator pos =
+            std::lower_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+          NS_ASSERT (pos != m_bottom.end () && pos->key.m_uid == uid);
+          NS_ASSERT (pos->impl == ev.impl);
+          m_bottom.erase (pos);
+          Removed ();
+          return;
+        }
+    }
+
+  // the Top and the buckets are not sorted
+  for (std::vector<Scheduler::Event>::iterator i = events->begin (); i != events->end (); i++)
+    {
+      if (i->key.m_uid == uid)
+        {
+          NS_ASSERT (i->impl == ev.impl);
+          *i = events->back ();
+          events->pop_back ();
+          Removed ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
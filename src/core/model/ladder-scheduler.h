@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue published in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by W. T. Tang, R. S. M. Goh and
+ * I. L.-J. Thng (ACM TOMACS, 2005). The events are kept in three tiers:
+ *  - Top: an unsorted array of the events far in the future,
+ *  - Ladder: up to MAX_RUNGS rungs of buckets, each rung splitting a
+ *    bucket of the previous rung into finer buckets,
+ *  - Bottom: a sorted array of the events about to be dequeued.
+ *
+ * When the Bottom is empty, the next non-empty bucket of the innermost
+ * rung is sorted into the Bottom if it holds at most THRESHOLD events,
+ * and is split into a new rung otherwise. When the Ladder is empty, the
+ * Top is spread over a new first rung with one bucket per event. Unlike
+ * the calendar queue, the bucket width adapts to the timestamp
+ * distribution locally, one bucket at a time, hence there is never a
+ * global resize and skewed distributions do not degrade the O(1)
+ * amortized cost.
+ *
+ * All the tiers are contiguous arrays. Buckets are std::vector objects
+ * that keep their capacity when the rung is reused, hence the structure
+ * stops allocating memory once it has grown to the event population,
+ * and growing only ever copies a single bucket.
+ *
+ * Removing an event which is not the next one (Simulator::Remove) is
+ * linear in the size of the tier holding it.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Maximum number of events sorted at once into the Bottom. */
+  static const uint32_t THRESHOLD = 50;
+  /** Maximum number of rungs of the Ladder. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /** Bucket type: an unsorted array of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the Ladder. */
+  struct Rung
+  {
+    uint64_t start;                  //!< Timestamp of the start of the first bucket
+    uint64_t width;                  //!< Width of a bucket, in dimensionless time units
+    uint64_t current;                //!< Timestamp of the start of the current bucket
+    uint32_t nBuckets;               //!< Number of buckets in use
+    uint32_t currentBucket;          //!< Index of the current bucket
+    std::vector<Bucket> buckets;     //!< The buckets (may be more than nBuckets)
+  };
+
+  /**
+   * Insert an event in the Top, the Ladder or the Bottom.
+   *
+   * \param [in] ev The event.
+   */
+  void DoInsert (const Scheduler::Event &ev);
+  /**
+   * Insert an event in the Bottom, keeping it sorted.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Get the index of the rung where an event is stored.
+   *
+   * \param [in] ts The timestamp of the event, which must be below m_topStart.
+   * \returns The index of the rung, or m_nRungs if the event belongs to the Bottom.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Get the index of the bucket of a rung where an event is stored.
+   *
+   * \param [in] rung The rung.
+   * \param [in] ts The timestamp of the event.
+   * \returns The index of the bucket.
+   */
+  uint32_t FindBucket (const Rung &rung, uint64_t ts) const;
+  /**
+   * Add a rung and spread a set of events over its buckets.
+   *
+   * \param [in] events The events.
+   * \param [in] begin The index of the first event to spread.
+   * \param [in] minTs The smallest timestamp of the events.
+   * \param [in] maxTs The largest timestamp of the events.
+   * \returns The timestamp of the end of the new rung.
+   */
+  uint64_t SpawnRung (const std::vector<Scheduler::Event> &events, uint32_t begin,
+                      uint64_t minTs, uint64_t maxTs);
+  /**
+   * Sort a set of events into the empty Bottom.
+   *
+   * \param [in] events The events.
+   */
+  void SortIntoBottom (const std::vector<Scheduler::Event> &events);
+  /**
+   * Move events from the Ladder or the Top into the empty Bottom.
+   */
+  void FillBottom (void);
+  /**
+   * Account for the removal of an event, refilling the Bottom if needed.
+   */
+  void Removed (void);
+
+  /** The Top: unsorted events at or after m_topStart. */
+  std::vector<Scheduler::Event> m_top;
+  /** Smallest timestamp in the Top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in the Top. */
+  uint64_t m_topMax;
+  /** Timestamp from which events are inserted in the Top. */
+  uint64_t m_topStart;
+  /** The rungs, m_rungs[0] being the coarsest; only m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** The Bottom: sorted events, from index m_bottomHead. */
+  std::vector<Scheduler::Event> m_bottom;
+  /** Index of the next event in the Bottom. */
+  uint32_t m_bottomHead;
+  /** Number of events in the scheduler. */
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+
+/**
+ * \file
+ * \ingroup thread
+ * ns3::MpscQueue declaration and implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ * \brief A lock-free queue with many producer threads and one consumer
+ * thread.
+ *
+ * The producers push their items on a shared stack with a
+ * compare-and-swap. The consumer takes the whole stack at once with an
+ * atomic exchange, when it runs out of items, and reverses it into a
+ * private batch; so the items come out in the order in which they were
+ * pushed, and the consumer pays for one atomic operation per batch
+ * rather than per item. IsEmpty() is a plain load, cheap enough to be
+ * called after every simulation event.
+ *
+ * Push() can be called from any thread; Pop() and IsEmpty() only from
+ * the consumer thread.
+ *
+ * \tparam T \explicit The type of the items, which must be copyable.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  /** Constructor. */
+  MpscQueue ();
+  /** Destructor: the items left in the queue are destroyed. */
+  ~MpscQueue ();
+
+  /**
+   * Add an item at the end of the queue.
+   *
+   * \param [in] item The item.
+   */
+  void Push (const T &item);
+  /**
+   * Remove the item at the front of the queue.
+   *
+   * \param [out] item The item.
+   * \returns \c true if there was an item.
+   */
+  bool Pop (T &item);
+  /**
+   * \returns \c true if the queue is empty.
+   */
+  bool IsEmpty (void) const;
+
+private:
+  /** A queued item. */
+  struct Node
+  {
+    T item;        //!< The item
+    Node *next;    //!< The next node, in the stack or in the batch
+  };
+
+  /**
+   * Copy constructor, disabled.
+   * \param [in] o The other queue.
+   */
+  MpscQueue (const MpscQueue &o);
+  /**
+   * Assignment, disabled.
+   * \param [in] o The other queue.
+   * \returns This queue.
+   */
+  MpscQueue &operator = (const MpscQueue &o);
+
+  std::atomic<Node *> m_stack;   //!< Items pushed since the last batch, the latest first
+  Node *m_batch;                 //!< Items taken by the consumer, the earliest first
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::MpscQueue ()
+  : m_stack (0),
+    m_batch (0)
+{
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue ()
+{
+  T item;
+  while (Pop (item))
+    {
+    }
+}
+
+template <typename T>
+void
+MpscQueue<T>::Push (const T &item)
+{
+  Node *node = new Node;
+  node->item = item;
+  node->next = m_stack.load (std::memory_order_relaxed);
+  while (!m_stack.compare_exchange_weak (node->next, node,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed))
+    {
+    }
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Pop (T &item)
+{
+  if (m_batch == 0)
+    {
+      if (m_stack.load (std::memory_order_relaxed) == 0)
+        {
+          return false;
+        }
+      // take all the pushed items, and put them back in order
+      Node *stack = m_stack.exchange (0, std::memory_order_acquire);
+      while (stack != 0)
+        {
+          Node *next = stack->next;
+          stack->next = m_batch;
+          m_batch = stack;
+          stack = next;
+        }
+    }
+  Node *node = m_batch;
+  m_batch = node->next;
+  item = node->item;
+  delete node;
+  return true;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  return m_batch == 0 && m_stack.load (std::memory_order_relaxed) == 0;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
@@ -34,6 +34,7 @@
 
 
 #include <cmath>
+#include <algorithm>
 
 
 /**
@@ -107,6 +108,10 @@ void
 RealtimeSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  {
+    CriticalSection cs (m_mutex);
+    ProcessEventsWithContext ();
+  }
   while (!m_events->IsEmpty ())
     {
       Scheduler::Event next = m_events->RemoveNext ();
@@ -208,6 +213,16 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
       { 
         CriticalSection cs (m_mutex);
+        //
+        // This resets the synchronizer so that any future event will cause
+        // it to interrupt.  This must come before the events scheduled by
+        // the other threads are moved to the event list: an event queued
+        // after that will have done a synchronizer Signal() which sets the
+        // condition again.
+        //
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
+
         //
         // Since we are in realtime mode, the time to delay has got to be the 
         // difference between the current realtime and the timestamp of the next 
@@ -253,10 +268,9 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         // We've figured out how long we need to delay in order to pace the 
         // simulation time with the real time.  We're going to sleep, but need
         // to work with the synchronizer to make sure we're awakened if something 
-        // external happens (like a packet is received).  This next line resets
-        // the synchronizer so that any future event will cause it to interrupt.
+        // external happens (like a packet is received); the condition was
+        // reset above.
         //
-        m_synchronizer->SetCondition (false);
       }
 
       //
@@ -319,6 +333,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
   { 
     CriticalSection cs (m_mutex);
+    ProcessEventsWithContext ();
 
     // 
     // We do know we're waiting for an event, so there had better be an event on the 
@@ -405,6 +420,48 @@ RealtimeSimulatorImpl::IsFinished (void) const
   return rc;
 }
 
+void
+RealtimeSimulatorImpl::ScheduleFromThread (uint32_t context, uint64_t ts, EventImpl *impl)
+{
+  EventWithContext ev;
+  ev.context = context;
+  ev.timestamp = ts;
+  ev.event = impl;
+  m_eventsWithContext.Push (ev);
+  m_synchronizer->Signal ();
+}
+
+//
+// Moves the events scheduled by the other threads into the event list.
+// Should be called with critical section locked.
+//
+void
+RealtimeSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContext.IsEmpty ())
+    {
+      return;
+    }
+
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      //
+      // The main thread may have run an event later than the real time at
+      // which this one was scheduled, since it was queued; time can not move
+      // backward.
+      //
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = std::max (event.timestamp, m_currentTs);
+      ev.key.m_context = event.context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+    }
+}
+
 //
 // Peeks into event list.  Should be called with critical section locked.
 //
@@ -429,8 +486,9 @@ RealtimeSimulatorImpl::Run (void)
   m_main = SystemThread::Self();
 
   m_stop = false;
-  m_running = true;
+  // the origin must be set before the other threads see that we run
   m_synchronizer->SetOrigin (m_currentTs);
+  m_running = true;
 
   // Sleep until signalled
   uint64_t tsNow;
@@ -441,6 +499,7 @@ RealtimeSimulatorImpl::Run (void)
       bool process = false;
       {
         CriticalSection cs (m_mutex);
+        ProcessEventsWithContext ();
 
         if (!m_events->IsEmpty ())
           {
@@ -543,23 +602,29 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
 {
   NS_LOG_FUNCTION (this << context << delay << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      //
+      // If the simulator is running, we're pacing and have a meaningful 
+      // realtime clock.  If we're not, then m_currentTs is where we stopped.
+      // 
+      uint64_t ts;
+      if (m_running)
+        {
+          ts = m_synchronizer->GetCurrentRealtime ();
+        }
+      else
+        {
+          CriticalSection cs (m_mutex);
+          ts = m_currentTs;
+        }
+      ScheduleFromThread (context, ts + delay.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
-    uint64_t ts;
-
-    if (SystemThread::Equals (m_main))
-      {
-        ts = m_currentTs + delay.GetTimeStep ();
-      }
-    else
-      {
-        //
-        // If the simulator is running, we're pacing and have a meaningful 
-        // realtime clock.  If we're not, then m_currentTs is where we stopped.
-        // 
-        ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
-        ts += delay.GetTimeStep ();
-      }
+    uint64_t ts = m_currentTs + delay.GetTimeStep ();
 
     NS_ASSERT_MSG (ts >= m_currentTs, "RealtimeSimulatorImpl::ScheduleRealtime(): schedule for time < m_currentTs");
     Scheduler::Event ev;
@@ -609,6 +674,12 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
 {
   NS_LOG_FUNCTION (this << context << time << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      ScheduleFromThread (context, m_synchronizer->GetCurrentRealtime () + time.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -617,6 +688,7 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
     Scheduler::Event ev;
     ev.impl = impl;
     ev.key.m_ts = ts;
+    ev.key.m_context = context;
     ev.key.m_uid = m_uid;
     m_uid++;
     m_unscheduledEvents++;
@@ -636,6 +708,23 @@ void
 RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext (uint32_t context, EventImpl *impl)
 {
   NS_LOG_FUNCTION (this << context << impl);
+
+  if (!SystemThread::Equals (m_main))
+    {
+      uint64_t ts;
+      if (m_running)
+        {
+          ts = m_synchronizer->GetCurrentRealtime ();
+        }
+      else
+        {
+          CriticalSection cs (m_mutex);
+          ts = m_currentTs;
+        }
+      ScheduleFromThread (context, ts, impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
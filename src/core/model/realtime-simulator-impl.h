@@ -30,7 +30,9 @@
 #include "assert.h"
 #include "log.h"
 #include "system-mutex.h"
+#include "mpsc-queue.h"
 
+#include <atomic>
 #include <list>
 
 /**
@@ -172,17 +174,47 @@ private:
   uint64_t NextTs (void) const;
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /**
+   * Queue an event scheduled by another thread than the main one, and
+   * wake up the main thread.
+   *
+   * \param [in] context The event context.
+   * \param [in] ts The event timestamp.
+   * \param [in] event The event implementation.
+   */
+  void ScheduleFromThread (uint32_t context, uint64_t ts, EventImpl *event);
+  /**
+   * Move the events scheduled by other threads into the event list.
+   * This is called by the main thread, with #m_mutex locked.
+   */
+  void ProcessEventsWithContext (void);
   /** Destructor implementation. */
   virtual void DoDispose (void);
 
+  /** Wrap an event scheduled by another thread with its execution context. */
+  struct EventWithContext
+  {
+    /** The event context. */
+    uint32_t context;
+    /** Event timestamp. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /**
+   * The events scheduled by other threads (such as the reader threads
+   * of the emulation devices), which do not take #m_mutex.
+   */
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
+
   /** Container type for events to be run at destroy time. */
   typedef std::list<EventId> DestroyEvents;
   /** Container for events to be run at destroy time. */
   DestroyEvents m_destroyEvents;
   /** Has the stopping condition been reached? */
   bool m_stop;
-  /** Is the simulator currently running. */
-  bool m_running;
+  /** Is the simulator currently running (read by the other threads). */
+  std::atomic<bool> m_running;
 
   /**
    * \name Mutex-protected variables.
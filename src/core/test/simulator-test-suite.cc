@@ -23,6 +23,10 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
+#include "ns3/event-allocator.h"
+#include <set>
 
 using namespace ns3;
 
@@ -459,6 +463,260 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check that a scheduler returns the events in (timestamp, uid) order, with
+ * a mix of timestamp distributions that exercises the resizing and the
+ * splitting of the bucket based schedulers: clustered timestamps, bursts of
+ * equal timestamps, far future events, a hold model phase and Remove of
+ * arbitrary events. The events are checked against a std::set.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory, uint32_t population);
+  virtual void DoRun (void);
+private:
+  /** 
+eturns a pseudo-random number (xorshift) */
+  uint32_t Random (void);
+  /**
+   * Get a timestamp after the current time.
+   * \param now the current time
+   * 
+eturns the timestamp
+   */
+  uint64_t GetTimestamp (uint64_t now);
+  /**
+   * Insert an event in the scheduler and in the reference set.
+   * \param ts the timestamp of the event
+   */
+  void Insert (uint64_t ts);
+  /**
+   * Remove the next event from the scheduler and the reference set.
+   * 
+eturns the timestamp of the event
+   */
+  uint64_t RemoveNext (void);
+
+  ObjectFactory m_schedulerFactory;          //!< Factory of the tested scheduler
+  uint32_t m_population;                     //!< Number of pending events
+  Ptr<Scheduler> m_scheduler;                //!< The tested scheduler
+  std::set<Scheduler::EventKey> m_reference; //!< The pending events
+  uint32_t m_uid;                            //!< Uid of the next event
+  uint32_t m_random;                         //!< State of the random number generator
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory, uint32_t population)
+  : TestCase ("Check the order of the events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_population (population),
+    m_uid (0),
+    m_random (2463534242u)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Random (void)
+{
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  return m_random;
+}
+
+uint64_t
+SchedulerOrderTestCase::GetTimestamp (uint64_t now)
+{
+  uint32_t kind = Random () % 10;
+  if (kind < 5)
+    {
+      return now + Random () % 100;
+    }
+  else if (kind < 8)
+    {
+      // bursts of events at the same time
+      return now - now % 1000 + 1000;
+    }
+  return now + Random () % 1000000000;
+}
+
+void
+SchedulerOrderTestCase::Insert (uint64_t ts)
+{
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_ts = ts;
+  ev.key.m_uid = m_uid++;
+  ev.key.m_context = 0;
+  m_scheduler->Insert (ev);
+  m_reference.insert (ev.key);
+}
+
+uint64_t
+SchedulerOrderTestCase::RemoveNext (void)
+{
+  Scheduler::Event ev = m_scheduler->RemoveNext ();
+  Scheduler::EventKey expected = *m_reference.begin ();
+  m_reference.erase (m_reference.begin ());
+  NS_TEST_EXPECT_MSG_EQ (ev.key.m_ts, expected.m_ts, "Wrong timestamp");
+  NS_TEST_EXPECT_MSG_EQ (ev.key.m_uid, expected.m_uid, "Wrong uid");
+  return ev.key.m_ts;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  m_scheduler = m_schedulerFactory.Create<Scheduler> ();
+  uint64_t now = 0;
+
+  for (uint32_t i = 0; i < m_population; i++)
+    {
+      Insert (GetTimestamp (now));
+    }
+
+  // hold model, removing an arbitrary event from time to time
+  for (uint32_t i = 0; i < 4 * m_population; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), false, "The scheduler is empty");
+      NS_TEST_EXPECT_MSG_EQ (m_scheduler->PeekNext ().key.m_uid, m_reference.begin ()->m_uid,
+                             "Wrong next event");
+      now = RemoveNext ();
+      Insert (GetTimestamp (now));
+      if (i % 7 == 0)
+        {
+          Scheduler::EventKey key;
+          key.m_ts = GetTimestamp (now);
+          key.m_uid = 0;
+          std::set<Scheduler::EventKey>::iterator it = m_reference.lower_bound (key);
+          if (it != m_reference.end ())
+            {
+              Scheduler::Event ev;
+              ev.impl = 0;
+              ev.key = *it;
+              m_scheduler->Remove (ev);
+              m_reference.erase (it);
+              Insert (GetTimestamp (now));
+            }
+        }
+    }
+
+  while (!m_reference.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), false, "The scheduler is empty");
+      RemoveNext ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_scheduler->IsEmpty (), true, "The scheduler is not empty");
+
+  // the scheduler is usable again once emptied
+  Insert (now + 10);
+  Insert (now + 5);
+  RemoveNext ();
+  RemoveNext ();
+  NS_TEST_EXPECT_MSG_EQ (m_scheduler->IsEmpty (), true, "The scheduler is not empty");
+  m_scheduler = 0;
+}
+
+/**
+ * Check that the events are recycled by the EventAllocator, including
+ * events of different sizes, and that events too large to be pooled
+ * keep their bound arguments.
+ */
+class EventAllocatorTestCase : public TestCase
+{
+public:
+  EventAllocatorTestCase ();
+  virtual void DoRun (void);
+private:
+  /** An argument too large for the pooled size classes. */
+  struct Large
+  {
+    uint8_t data[2 * EventAllocator::MAX_SIZE];  //!< Payload
+  };
+  /**
+   * Reschedule itself until the count is reached.
+   * \param a unused
+   */
+  void Small (uint32_t a);
+  /**
+   * Reschedule itself until the count is reached.
+   * \param a unused
+   * \param b unused
+   * \param c unused
+   */
+  void Medium (uint64_t a, uint64_t b, uint64_t c);
+  /**
+   * Check the payload.
+   * \param large the argument
+   */
+  void CheckLarge (Large large);
+  uint32_t m_count;     //!< Number of events run
+  bool m_largeOk;       //!< Whether the large argument was intact
+};
+
+EventAllocatorTestCase::EventAllocatorTestCase ()
+  : TestCase ("Check that the events are recycled by the EventAllocator"),
+    m_count (0),
+    m_largeOk (false)
+{
+}
+
+void
+EventAllocatorTestCase::Small (uint32_t a)
+{
+  if (++m_count < 10000)
+    {
+      Simulator::Schedule (NanoSeconds (1 + m_count % 7), &EventAllocatorTestCase::Small, this, a);
+    }
+}
+
+void
+EventAllocatorTestCase::Medium (uint64_t a, uint64_t b, uint64_t c)
+{
+  if (++m_count < 10000)
+    {
+      Simulator::Schedule (NanoSeconds (1 + m_count % 5), &EventAllocatorTestCase::Medium, this, a, b, c);
+    }
+}
+
+void
+EventAllocatorTestCase::CheckLarge (Large large)
+{
+  m_largeOk = true;
+  for (uint32_t i = 0; i < sizeof (large.data); i++)
+    {
+      m_largeOk = m_largeOk && large.data[i] == (uint8_t) i;
+    }
+}
+
+void
+EventAllocatorTestCase::DoRun (void)
+{
+  // the free lists are filled by the events of the previous test cases
+  EventAllocator::ResetStats ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (NanoSeconds (i), &EventAllocatorTestCase::Small, this, i);
+      Simulator::Schedule (NanoSeconds (i), &EventAllocatorTestCase::Medium, this, i, i, i);
+    }
+  Large large;
+  for (uint32_t i = 0; i < sizeof (large.data); i++)
+    {
+      large.data[i] = i;
+    }
+  Simulator::Schedule (MicroSeconds (1), &EventAllocatorTestCase::CheckLarge, this, large);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  EventAllocator::Stats stats = EventAllocator::GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (m_largeOk, true, "The large argument was corrupted");
+  NS_TEST_EXPECT_MSG_GT (stats.allocations, 10000, "Too few allocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.oversized, 1, "The large event was not counted");
+  NS_TEST_EXPECT_MSG_GT (EventAllocator::GetHitRate (), 0.95, "The events were not recycled");
+  NS_TEST_EXPECT_MSG_LT (stats.cached, EventAllocator::N_CLASSES * EventAllocator::MAX_CACHED + 1,
+                         "Too many cached blocks");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +733,24 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, 1000), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, 20000), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, 20000), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, 20000), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, 20000), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, 20000), TestCase::QUICK);
+
+    AddTestCase (new EventAllocatorTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -26,10 +26,12 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/mpsc-queue.h"
 
 #include <ctime>
 #include <list>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -225,6 +227,69 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+class MpscQueueTestCase : public TestCase
+{
+public:
+  MpscQueueTestCase (unsigned int threads);
+  void Produce (unsigned int threadno);
+
+  /** Number of items pushed by each producer thread. */
+  static const uint32_t N_ITEMS = 20000;
+  unsigned int m_threads;
+  MpscQueue<std::pair<unsigned int, uint32_t> > m_queue;
+
+private:
+  virtual void DoRun (void);
+};
+
+MpscQueueTestCase::MpscQueueTestCase (unsigned int threads)
+  : TestCase ("Check that the multi-producer single-consumer queue keeps the order of each producer, with " +
+              std::to_string (threads) + " producers"),
+    m_threads (threads)
+{
+}
+
+void
+MpscQueueTestCase::Produce (unsigned int threadno)
+{
+  for (uint32_t i = 0; i < N_ITEMS; ++i)
+    {
+      m_queue.Push (std::make_pair (threadno, i));
+    }
+}
+
+void
+MpscQueueTestCase::DoRun (void)
+{
+  std::pair<unsigned int, uint32_t> item;
+  NS_TEST_ASSERT_MSG_EQ (m_queue.IsEmpty (), true, "A new queue is empty");
+  NS_TEST_ASSERT_MSG_EQ (m_queue.Pop (item), false, "A new queue is empty");
+
+  std::list<Ptr<SystemThread> > threads;
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeCallback (&MpscQueueTestCase::Produce, this).Bind (i)));
+      threads.back ()->Start ();
+    }
+  std::vector<uint32_t> next (m_threads, 0);
+  uint64_t received = 0;
+  while (received < (uint64_t) m_threads * N_ITEMS)
+    {
+      if (m_queue.Pop (item))
+        {
+          NS_TEST_ASSERT_MSG_LT (item.first, m_threads, "Bad producer");
+          NS_TEST_ASSERT_MSG_EQ (item.second, next[item.first], "Bad order for producer " << item.first);
+          ++next[item.first];
+          ++received;
+        }
+    }
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), true, "All the items were received");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -262,5 +327,7 @@ public:
               }
           }
       }
+    AddTestCase (new MpscQueueTestCase (1), TestCase::QUICK);
+    AddTestCase (new MpscQueueTestCase (4), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
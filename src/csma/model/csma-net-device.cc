@@ -33,6 +33,7 @@
 #include "csma-net-device.h"
 #include "csma-channel.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-item.h"
 
 namespace ns3 {
 
@@ -999,6 +1000,53 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
 
   Mac48Address destination = Mac48Address::ConvertFrom (dest);
   Mac48Address source = Mac48Address::ConvertFrom (src);
+  return EnqueueAndTransmit (packet, source, destination, protocolNumber);
+}
+
+uint32_t
+CsmaNetDevice::SendBurst (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  NS_ASSERT (IsLinkUp ());
+
+  bool sendEnabled = IsSendEnabled ();
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+    {
+      txq = m_queueInterface->GetTxQueue (0);
+    }
+
+  uint32_t sent = 0;
+  for (; sent < items.size (); sent++)
+    {
+      //
+      // Stop as soon as the device queue is full, the caller requeues the
+      // remaining packets
+      //
+      if (txq && txq->IsStopped ())
+        {
+          break;
+        }
+
+      Ptr<Packet> packet = items[sent]->GetPacket ();
+      if (sendEnabled == false)
+        {
+          m_macTxDropTrace (packet);
+          continue;
+        }
+      EnqueueAndTransmit (packet, m_address, Mac48Address::ConvertFrom (items[sent]->GetAddress ()),
+                          items[sent]->GetProtocol ());
+    }
+  return sent;
+}
+
+bool
+CsmaNetDevice::EnqueueAndTransmit (Ptr<Packet> packet, Mac48Address source, Mac48Address destination,
+                                   uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (packet << source << destination << protocolNumber);
+
   AddHeader (packet, source, destination, protocolNumber);
 
   m_macTxTrace (packet);
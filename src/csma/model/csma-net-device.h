@@ -285,6 +285,14 @@ public:
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, 
                          uint16_t protocolNumber);
 
+  /**
+   * Start sending a burst of packets down the channel. The packets are sent
+   * in order until the device queue gets stopped.
+   * \param items the items storing the packets to send and their destinations
+   * \return the number of items consumed by the device
+   */
+  virtual uint32_t SendBurst (const std::vector<Ptr<QueueDiscItem> > &items);
+
   /**
    * Get the node to which this device is attached.
    *
@@ -357,6 +365,19 @@ protected:
    */
   void AddHeader (Ptr<Packet> p, Mac48Address source, Mac48Address dest, uint16_t protocolNumber);
 
+  /**
+   * Add the headers to a packet, place it on the send queue and start its
+   * transmission if the device is idle. The send side must be enabled.
+   *
+   * \param packet the packet to send
+   * \param source MAC source address from which packet should be sent
+   * \param destination MAC destination address to which packet should be sent
+   * \param protocolNumber the protocol number of the packet
+   * \return true if successfull, false otherwise (drop, ...)
+   */
+  bool EnqueueAndTransmit (Ptr<Packet> packet, Mac48Address source, Mac48Address destination,
+                           uint16_t protocolNumber);
+
   virtual void DoInitialize (void);
   virtual void NotifyNewAggregate (void);
 
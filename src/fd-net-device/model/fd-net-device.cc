@@ -174,6 +174,7 @@ FdNetDevice::FdNetDevice ()
     m_fdReader (0),
     m_isBroadcast (true),
     m_isMulticast (false),
+    m_pendingReads (0),
     m_startEvent (),
     m_stopEvent ()
 {
@@ -189,17 +190,11 @@ FdNetDevice::~FdNetDevice ()
 {
   NS_LOG_FUNCTION (this);
 
-  {
-    CriticalSection cs (m_pendingReadMutex);
-
-    while (!m_pendingQueue.empty ())
-      {
-        std::pair<uint8_t *, ssize_t> next = m_pendingQueue.front ();
-        m_pendingQueue.pop ();
-
-        free (next.first);
-      }
-  }
+  std::pair<uint8_t *, ssize_t> next;
+  while (m_pendingQueue.Pop (next))
+    {
+      free (next.first);
+    }
 }
 
 void
@@ -291,18 +286,17 @@ FdNetDevice::ReceiveCallback (uint8_t *buf, ssize_t len)
   NS_LOG_FUNCTION (this << buf << len);
   bool skip = false;
 
-  {
-    CriticalSection cs (m_pendingReadMutex);
-    if (m_pendingQueue.size () >= m_maxPendingReads)
-      {
-        NS_LOG_WARN ("Packet dropped");
-        skip = true;
-      }
-    else
-      {
-        m_pendingQueue.push (std::make_pair (buf, len));
-      }
-  }
+  // this is the only thread which adds to the pending reads
+  if (m_pendingReads.load (std::memory_order_relaxed) >= m_maxPendingReads)
+    {
+      NS_LOG_WARN ("Packet dropped");
+      skip = true;
+    }
+  else
+    {
+      m_pendingReads.fetch_add (1, std::memory_order_relaxed);
+      m_pendingQueue.Push (std::make_pair (buf, len));
+    }
 
   if (skip)
     {
@@ -388,14 +382,13 @@ FdNetDevice::ForwardUp (void)
   uint8_t *buf = 0; 
   ssize_t len = 0;
 
-  {
-    CriticalSection cs (m_pendingReadMutex);
-    std::pair<uint8_t *, ssize_t> next = m_pendingQueue.front ();
-    m_pendingQueue.pop ();
-
-    buf = next.first;
-    len = next.second;
-  }
+  // one event is scheduled per pending read
+  std::pair<uint8_t *, ssize_t> next;
+  bool pending = m_pendingQueue.Pop (next);
+  NS_ABORT_MSG_UNLESS (pending, "FdNetDevice::ForwardUp(): no pending read");
+  m_pendingReads.fetch_sub (1, std::memory_order_relaxed);
+  buf = next.first;
+  len = next.second;
 
   NS_LOG_FUNCTION (this << buf << len);
 
@@ -34,10 +34,10 @@
 #include "ns3/system-condition.h"
 #include "ns3/traced-callback.h"
 #include "ns3/unix-fd-reader.h"
-#include "ns3/system-mutex.h"
+#include "ns3/mpsc-queue.h"
 
+#include <atomic>
 #include <utility>
-#include <queue>
 
 namespace ns3 {
 
@@ -297,19 +297,20 @@ private:
   bool m_isMulticast;
 
   /**
-   * Number of packets that were received and scheduled for read but not yeat read.
+   * Packets that were received and scheduled for read but not yet read,
+   * queued by the reader thread without locking.
    */
-  std::queue< std::pair<uint8_t *, ssize_t> > m_pendingQueue;
+  MpscQueue< std::pair<uint8_t *, ssize_t> > m_pendingQueue;
 
   /**
-   * Maximum number of packets that can be received and scheduled for read but not yeat read.
+   * Number of packets in m_pendingQueue.
    */
-  uint32_t m_maxPendingReads;
+  std::atomic<uint32_t> m_pendingReads;
 
   /**
-   * Mutex to increase pending read counter.
+   * Maximum number of packets that can be received and scheduled for read but not yeat read.
    */
-  SystemMutex m_pendingReadMutex;
+  uint32_t m_maxPendingReads;
 
   /**
    * Time to start spinning up the device
@@ -89,6 +89,18 @@ public:
   virtual bool IsL4S (void);
 
 private:
+  /**
+   * \brief Compute the hash of the 5-tuple of the packet
+   *
+   * The source and destination addresses, the protocol and, for TCP and UDP,
+   * the source and destination ports are serialized along with the perturbation
+   * and hashed with murmur3 (Linux uses the jenkins hash).
+   *
+   * \param perturbation the salt used as an additional input to the hash function
+   * \return the hash of the 5-tuple of the packet
+   */
+  virtual uint32_t DoHash (uint32_t perturbation) const;
+
   /**
    * \brief Default constructor
    *
@@ -24,8 +24,6 @@
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
-#include "ns3/tcp-header.h"
-#include "ns3/udp-header.h"
 #include "ipv6-queue-disc-item.h"
 #include "ipv6-packet-filter.h"
 
@@ -100,47 +98,8 @@ FqCoDelIpv6PacketFilter::DoClassify (Ptr< QueueDiscItem > item) const
 
   NS_ASSERT (ipv6Item != 0);
 
-  Ipv6Header hdr = ipv6Item->GetHeader ();
-  Ipv6Address src = hdr.GetSourceAddress ();
-  Ipv6Address dest = hdr.GetDestinationAddress ();
-  uint8_t prot = hdr.GetNextHeader ();
-
-  TcpHeader tcpHdr;
-  UdpHeader udpHdr;
-  uint16_t srcPort = 0;
-  uint16_t destPort = 0;
-
-  Ptr<Packet> pkt = ipv6Item->GetPacket ();
-
-  if (prot == 6) // TCP
-    {
-      pkt->PeekHeader (tcpHdr);
-      srcPort = tcpHdr.GetSourcePort ();
-      destPort = tcpHdr.GetDestinationPort ();
-    }
-  else if (prot == 17) // UDP
-    {
-      pkt->PeekHeader (udpHdr);
-      srcPort = udpHdr.GetSourcePort ();
-      destPort = udpHdr.GetDestinationPort ();
-    }
-
-  /* serialize the 5-tuple and the perturbation in buf */
-  uint8_t buf[41];
-  src.Serialize (buf);
-  dest.Serialize (buf + 16);
-  buf[32] = prot;
-  buf[33] = (srcPort >> 8) & 0xff;
-  buf[34] = srcPort & 0xff;
-  buf[35] = (destPort >> 8) & 0xff;
-  buf[36] = destPort & 0xff;
-  buf[37] = (m_perturbation >> 24) & 0xff;
-  buf[38] = (m_perturbation >> 16) & 0xff;
-  buf[39] = (m_perturbation >> 8) & 0xff;
-  buf[40] = m_perturbation & 0xff;
-
-  /* Linux calculates the jhash2 (jenkins hash), we calculate the murmur3 */
-  uint32_t hash = Hash32 ((char*) buf, 41);
+  /* the hash of the 5-tuple is computed by the item and cached */
+  uint32_t hash = ipv6Item->Hash (m_perturbation);
 
   NS_LOG_DEBUG ("Found Ipv6 packet; hash of the five tuple " << hash);
 
@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** Network topology
+ *
+ *  nLeaf senders                                    nLeaf receivers
+ *        \        10Mb/s, 1ms          10Mb/s, 1ms        /
+ *   l(i) ----------- r0 ---------------------- r1 ----------- r(i)
+ *        /              bottleneckRate, 10ms        \
+ *                  DualQCoupledCurvyRed
+ *
+ * Every sender runs a bulk TCP flow to its receiver through the
+ * bottleneck. With --threads=0 the simulation runs on the
+ * DefaultSimulatorImpl; otherwise, it runs on the
+ * MultithreadedSimulatorImpl with at most this number of threads. The
+ * number of bytes received is the same, unless simultaneous events run
+ * in another order (see the limitations of MultithreadedSimulatorImpl).
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/point-to-point-layout-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/mtp-module.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nLeaf = 16;
+  uint32_t threads = 2;
+  double stopTime = 10.0;
+  std::string bottleneckRate = "100Mbps";
+
+  CommandLine cmd;
+  cmd.AddValue ("nLeaf", "Number of senders and of receivers", nLeaf);
+  cmd.AddValue ("threads", "Maximum number of threads (0 for the default simulator)", threads);
+  cmd.AddValue ("stopTime", "Duration of the simulation, in seconds", stopTime);
+  cmd.AddValue ("bottleneckRate", "Rate of the bottleneck link", bottleneckRate);
+  cmd.Parse (argc, argv);
+
+  if (threads > 0)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (threads));
+    }
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1000));
+  Config::SetDefault ("ns3::TcpSocketBase::UseEcn", BooleanValue (true));
+  Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::Mode", StringValue ("QUEUE_DISC_MODE_PACKETS"));
+  Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::QueueLimit", UintegerValue (1000));
+
+  PointToPointHelper bottleneckLink;
+  bottleneckLink.SetDeviceAttribute ("DataRate", StringValue (bottleneckRate));
+  bottleneckLink.SetChannelAttribute ("Delay", StringValue ("10ms"));
+
+  PointToPointHelper leafLink;
+  leafLink.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  leafLink.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  PointToPointDumbbellHelper d (nLeaf, leafLink, nLeaf, leafLink, bottleneckLink);
+
+  InternetStackHelper stack;
+  d.InstallStack (stack);
+
+  TrafficControlHelper tchBottleneck;
+  uint16_t handle = tchBottleneck.SetRootQueueDisc ("ns3::DualQCoupledCurvyRedQueueDisc");
+  tchBottleneck.AddInternalQueues (handle, 2, "ns3::DropTailQueue", "MaxPackets", UintegerValue (1000));
+  tchBottleneck.Install (d.GetLeft ()->GetDevice (0));
+
+  d.AssignIpv4Addresses (Ipv4AddressHelper ("10.1.1.0", "255.255.255.0"),
+                         Ipv4AddressHelper ("10.2.1.0", "255.255.255.0"),
+                         Ipv4AddressHelper ("10.3.1.0", "255.255.255.0"));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 5001;
+  PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps;
+  BulkSendHelper sourceHelper ("ns3::TcpSocketFactory", Address ());
+  ApplicationContainer sourceApps;
+  for (uint32_t i = 0; i < nLeaf; i++)
+    {
+      sinkApps.Add (sinkHelper.Install (d.GetRight (i)));
+      sourceHelper.SetAttribute ("Remote", AddressValue (InetSocketAddress (d.GetRightIpv4Address (i), port)));
+      sourceApps.Add (sourceHelper.Install (d.GetLeft (i)));
+    }
+  sinkApps.Start (Seconds (0.0));
+  sourceApps.Start (Seconds (0.1));
+
+  Simulator::Stop (Seconds (stopTime));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+
+  uint64_t totalRx = 0;
+  for (uint32_t i = 0; i < sinkApps.GetN (); i++)
+    {
+      totalRx += DynamicCast<PacketSink> (sinkApps.Get (i))->GetTotalRx ();
+    }
+  std::cout << "Bytes received: " << totalRx << std::endl;
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0 && impl->GetPartitionCount () > 1)
+    {
+      std::cout << "Partitions: " << impl->GetPartitionCount ()
+                << ", lookahead: " << impl->GetLookahead ().As (Time::MS)
+                << ", windows: " << impl->GetWindowCount () << std::endl;
+    }
+  std::cout << "Wall clock time: " << elapsed << " ms" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
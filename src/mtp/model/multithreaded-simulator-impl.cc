@@ -0,0 +1,845 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/system-thread.h"
+#include "ns3/uinteger.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/packet-metadata.h"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup mtp
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in the event processing functions is avoided, as in
+// the DefaultSimulatorImpl, due to the number of calls.
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+/** Largest timestamp. */
+static const uint64_t MAX_TS = 0x7fffffffffffffffULL;
+
+/* The initial-exec TLS model makes Now () and Schedule () as cheap as in
+ * the DefaultSimulatorImpl. */
+__attribute__ ((tls_model ("initial-exec")))
+thread_local MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::g_current = 0;
+
+namespace {
+
+/**
+ * Find the representative of a set of nodes.
+ *
+ * \param [in,out] parent The parent of each node in its set.
+ * \param [in] node The node.
+ * \returns The representative of the set of \p node.
+ */
+uint32_t
+FindSet (std::vector<uint32_t> &parent, uint32_t node)
+{
+  while (parent[node] != node)
+    {
+      parent[node] = parent[parent[node]];
+      node = parent[node];
+    }
+  return node;
+}
+
+/** A link between two nodes which can be cut by the partitioning. */
+struct CutLink
+{
+  uint32_t a;       //!< First node
+  uint32_t b;       //!< Second node
+  uint64_t delay;   //!< Delay of the channel, in time steps
+};
+
+} // unnamed namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mtp")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "The maximum number of threads (that is, of partitions), "
+                   "0 for the number of cores. Unused if the nodes have system ids.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_maxThreads (0),
+    m_lookahead (MAX_TS),
+    m_windowEnd (0),
+    m_windowCount (0),
+    m_barrier (0),
+    m_finished (false),
+    m_stop (false),
+    m_stopTs (MAX_TS)
+{
+  NS_LOG_FUNCTION (this);
+  // uids are allocated from 4, as in the DefaultSimulatorImpl
+  m_global.currentTs = 0;
+  m_global.currentUid = 0;
+  m_global.currentContext = Simulator::NO_CONTEXT;
+  m_global.uid = 4;
+  m_global.eventCount = 0;
+  m_global.index = 0;
+  // the thread which creates the simulator is the main thread
+  g_current = &m_global;
+  // the partitions share the packets which they exchange
+  PacketMetadata::EnableMultithreading ();
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ProcessIncoming (&m_global);
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *p = m_partitions[i];
+      ProcessIncoming (p);
+      while (!p->events->IsEmpty ())
+        {
+          Scheduler::Event next = p->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      for (uint32_t j = 0; j < p->incoming.size (); j++)
+        {
+          delete p->incoming[j];
+        }
+      delete p;
+    }
+  m_partitions.clear ();
+  m_nodePartition.clear ();
+  for (uint32_t j = 0; j < m_global.incoming.size (); j++)
+    {
+      delete m_global.incoming[j];
+    }
+  m_global.incoming.clear ();
+  while (!m_global.events->IsEmpty ())
+    {
+      Scheduler::Event next = m_global.events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_global.events = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (g_current == &m_global, "SetScheduler must be called from the main thread");
+  m_schedulerFactory = schedulerFactory;
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  if (m_global.events != 0)
+    {
+      while (!m_global.events->IsEmpty ())
+        {
+          scheduler->Insert (m_global.events->RemoveNext ());
+        }
+    }
+  m_global.events = scheduler;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *p = m_partitions[i];
+      scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!p->events->IsEmpty ())
+        {
+          scheduler->Insert (p->events->RemoveNext ());
+        }
+      p->events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+
+  // Gather the nodes which can not be separated into sets, and the links
+  // which can be cut.
+  std::vector<uint32_t> parent (nNodes);
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      parent[i] = i;
+    }
+  std::vector<CutLink> links;
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); i++)
+    {
+      Ptr<Channel> channel = *i;
+      std::vector<uint32_t> nodes;
+      bool pointToPoint = true;
+      for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+        {
+          Ptr<NetDevice> device = channel->GetDevice (j);
+          if (device == 0 || device->GetNode () == 0)
+            {
+              continue;
+            }
+          nodes.push_back (device->GetNode ()->GetId ());
+          pointToPoint = pointToPoint && device->IsPointToPoint ();
+        }
+      TimeValue delay;
+      if (pointToPoint &&
+          channel->GetAttributeFailSafe ("Delay", delay) &&
+          delay.Get ().IsStrictlyPositive ())
+        {
+          for (uint32_t a = 0; a < nodes.size (); a++)
+            {
+              for (uint32_t b = a + 1; b < nodes.size (); b++)
+                {
+                  CutLink link = { nodes[a], nodes[b], (uint64_t) delay.Get ().GetTimeStep () };
+                  links.push_back (link);
+                }
+            }
+        }
+      else
+        {
+          for (uint32_t a = 1; a < nodes.size (); a++)
+            {
+              parent[FindSet (parent, nodes[a])] = FindSet (parent, nodes[0]);
+            }
+        }
+    }
+
+  // Assign the sets to the partitions.
+  std::vector<uint32_t> setPartition (nNodes, 0);
+  uint32_t nPartitions = 1;
+  bool systemIds = false;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      systemIds = systemIds || NodeList::GetNode (i)->GetSystemId () != 0;
+    }
+  if (systemIds)
+    {
+      std::vector<bool> assigned (nNodes, false);
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          uint32_t systemId = NodeList::GetNode (i)->GetSystemId ();
+          uint32_t set = FindSet (parent, i);
+          NS_ABORT_MSG_IF (assigned[set] && setPartition[set] != systemId,
+                           "Nodes connected by a channel which can not be cut (not point-to-point, "
+                           "or without delay) must have the same system id");
+          assigned[set] = true;
+          setPartition[set] = systemId;
+          nPartitions = std::max (nPartitions, systemId + 1);
+        }
+    }
+  else
+    {
+      uint32_t maxThreads = m_maxThreads;
+      if (maxThreads == 0)
+        {
+          maxThreads = std::max (std::thread::hardware_concurrency (), 1U);
+        }
+      // the neighbours of each set
+      std::vector<uint32_t> setSize (nNodes, 0);
+      std::vector<std::vector<uint32_t> > neighbours (nNodes);
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          setSize[FindSet (parent, i)]++;
+        }
+      for (uint32_t i = 0; i < links.size (); i++)
+        {
+          uint32_t a = FindSet (parent, links[i].a);
+          uint32_t b = FindSet (parent, links[i].b);
+          if (a != b)
+            {
+              neighbours[a].push_back (b);
+              neighbours[b].push_back (a);
+            }
+        }
+      // number the sets in breadth-first order, so that the neighbours
+      // mostly end up in the same partition, and cut the order into
+      // partitions of about nNodes / maxThreads nodes
+      std::vector<bool> visited (nNodes, false);
+      std::vector<uint32_t> order;
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          uint32_t root = FindSet (parent, i);
+          if (visited[root])
+            {
+              continue;
+            }
+          visited[root] = true;
+          order.push_back (root);
+          for (uint32_t next = order.size () - 1; next < order.size (); next++)
+            {
+              const std::vector<uint32_t> &n = neighbours[order[next]];
+              for (uint32_t j = 0; j < n.size (); j++)
+                {
+                  if (!visited[n[j]])
+                    {
+                      visited[n[j]] = true;
+                      order.push_back (n[j]);
+                    }
+                }
+            }
+        }
+      uint32_t partition = 0;
+      uint64_t count = 0;
+      for (uint32_t i = 0; i < order.size (); i++)
+        {
+          if (count * maxThreads >= (uint64_t)(partition + 1) * nNodes)
+            {
+              partition++;
+            }
+          setPartition[order[i]] = partition;
+          count += setSize[order[i]];
+        }
+      nPartitions = partition + 1;
+    }
+
+  for (uint32_t i = 0; i < nPartitions; i++)
+    {
+      Partition *p = new Partition ();
+      p->events = m_schedulerFactory.Create<Scheduler> ();
+      p->currentTs = m_global.currentTs;
+      p->currentUid = 0;
+      p->currentContext = Simulator::NO_CONTEXT;
+      p->eventCount = 0;
+      p->index = i;
+      p->incoming.resize (nPartitions, 0);
+      for (uint32_t j = 0; j < nPartitions; j++)
+        {
+          if (j != i)
+            {
+              p->incoming[j] = new SpscQueue<RemoteEvent> ();
+            }
+        }
+      m_partitions.push_back (p);
+      m_global.incoming.push_back (new SpscQueue<RemoteEvent> ());
+    }
+  m_global.index = nPartitions;
+  m_nodePartition.resize (nNodes);
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      m_nodePartition[i] = m_partitions[setPartition[FindSet (parent, i)]];
+    }
+
+  m_lookahead = MAX_TS;
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      if (m_nodePartition[links[i].a] != m_nodePartition[links[i].b])
+        {
+          m_lookahead = std::min (m_lookahead, links[i].delay);
+        }
+    }
+
+  // Move the events of the nodes to their partition, keeping their uid.
+  std::vector<Scheduler::Event> events;
+  while (!m_global.events->IsEmpty ())
+    {
+      events.push_back (m_global.events->RemoveNext ());
+    }
+  for (uint32_t i = 0; i < events.size (); i++)
+    {
+      GetPartitionOf (events[i].key.m_context)->events->Insert (events[i]);
+    }
+  for (uint32_t i = 0; i < nPartitions; i++)
+    {
+      m_partitions[i]->uid = m_global.uid;
+    }
+
+  NS_LOG_INFO (nNodes << " nodes in " << nPartitions << " partitions, lookahead " << TimeStep (m_lookahead));
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartitionOf (uint32_t context) const
+{
+  if (context == Simulator::NO_CONTEXT || m_partitions.empty ())
+    {
+      return const_cast<Partition *> (&m_global);
+    }
+  if (context < m_nodePartition.size ())
+    {
+      return m_nodePartition[context];
+    }
+  // not a node
+  return m_partitions[0];
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = p->uid;
+  p->uid++;
+  p->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (g_current == &m_global, "Simulator::Run must be called from the main thread");
+  if (m_partitions.empty ())
+    {
+      CreatePartitions ();
+    }
+  m_stop = false;
+  m_finished = false;
+  uint32_t n = m_partitions.size ();
+  m_barrier = new SpinBarrier (n);
+
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Callback<void, uint32_t> run = MakeCallback (&MultithreadedSimulatorImpl::RunPartition, this);
+      Ptr<SystemThread> thread = Create<SystemThread> (run.Bind (i));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  // the main thread runs the first partition
+  RunPartition (0);
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i]->Join ();
+    }
+  delete m_barrier;
+  m_barrier = 0;
+  g_current = &m_global;
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (uint32_t index)
+{
+  Partition *p = m_partitions[index];
+  g_current = p;
+  while (true)
+    {
+      if (m_barrier->Arrive ())
+        {
+          Synchronize ();
+          m_barrier->Release ();
+        }
+      if (m_finished)
+        {
+          break;
+        }
+      ProcessWindow (p);
+      m_barrier->Wait ();
+      ProcessIncoming (p);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (Partition *p)
+{
+  while (!p->events->IsEmpty ())
+    {
+      Scheduler::Event next = p->events->PeekNext ();
+      if (next.key.m_ts >= m_windowEnd)
+        {
+          break;
+        }
+      p->events->RemoveNext ();
+      NS_ASSERT (next.key.m_ts >= p->currentTs);
+      p->currentTs = next.key.m_ts;
+      p->currentContext = next.key.m_context;
+      p->currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+      p->eventCount++;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessIncoming (Partition *p)
+{
+  for (uint32_t i = 0; i < p->incoming.size (); i++)
+    {
+      SpscQueue<RemoteEvent> *queue = p->incoming[i];
+      if (queue == 0)
+        {
+          continue;
+        }
+      RemoteEvent ev;
+      while (queue->Pop (ev))
+        {
+          Insert (p, ev.ts, ev.context, ev.impl);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Synchronize (void)
+{
+  Partition *self = g_current;
+  g_current = &m_global;
+  ProcessIncoming (&m_global);
+
+  // run the global events up to the earliest node event
+  uint64_t stopTs = m_stopTs.load ();
+  uint64_t lbts;
+  while (true)
+    {
+      lbts = MAX_TS;
+      for (uint32_t i = 0; i < m_partitions.size (); i++)
+        {
+          if (!m_partitions[i]->events->IsEmpty ())
+            {
+              lbts = std::min (lbts, m_partitions[i]->events->PeekNext ().key.m_ts);
+            }
+        }
+      if (m_stop || m_global.events->IsEmpty ())
+        {
+          break;
+        }
+      Scheduler::Event next = m_global.events->PeekNext ();
+      if (next.key.m_ts > lbts || next.key.m_ts >= stopTs)
+        {
+          break;
+        }
+      m_global.events->RemoveNext ();
+      NS_ASSERT (next.key.m_ts >= m_global.currentTs);
+      m_global.currentTs = next.key.m_ts;
+      m_global.currentContext = next.key.m_context;
+      m_global.currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+      m_global.eventCount++;
+      stopTs = m_stopTs.load ();
+    }
+  uint64_t globalNext = m_global.events->IsEmpty () ? MAX_TS : m_global.events->PeekNext ().key.m_ts;
+  uint64_t next = std::min (lbts, globalNext);
+
+  // as with the stop event of the DefaultSimulatorImpl, which is usually
+  // scheduled first, the events at the stop time do not run
+  if (m_stop || next == MAX_TS || next >= stopTs)
+    {
+      m_finished = true;
+      uint64_t now = m_global.currentTs;
+      for (uint32_t i = 0; i < m_partitions.size (); i++)
+        {
+          now = std::max (now, m_partitions[i]->currentTs);
+        }
+      if (!m_stop && next != MAX_TS)
+        {
+          // stopped by Stop (delay): all the clocks move to the stop time
+          now = std::max (now, stopTs);
+          for (uint32_t i = 0; i < m_partitions.size (); i++)
+            {
+              m_partitions[i]->currentTs = now;
+            }
+          m_stopTs = MAX_TS;
+        }
+      m_global.currentTs = now;
+      g_current = self;
+      return;
+    }
+
+  m_windowEnd = std::min (lbts + std::min (m_lookahead, MAX_TS - lbts), std::min (globalNext, stopTs));
+  m_windowCount++;
+  g_current = self;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop || !m_global.events->IsEmpty ())
+    {
+      return m_stop;
+    }
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      if (!m_partitions[i]->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  NS_ASSERT (delay.IsPositive ());
+  uint64_t ts = g_current->currentTs + delay.GetTimeStep ();
+  uint64_t stopTs = m_stopTs.load ();
+  while (ts < stopTs && !m_stopTs.compare_exchange_weak (stopTs, ts))
+    {
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  Partition *p = g_current;
+  NS_ASSERT_MSG (p != 0, "Simulator::Schedule from a thread which does not run a partition");
+  Time tAbsolute = delay + TimeStep (p->currentTs);
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (p->currentTs));
+  uint64_t ts = (uint64_t) tAbsolute.GetTimeStep ();
+  uint32_t uid = Insert (p, ts, p->currentContext, event);
+  return EventId (event, ts, p->currentContext, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  Partition *p = g_current;
+  NS_ASSERT_MSG (p != 0, "Simulator::ScheduleWithContext from a thread which does not run a partition");
+  NS_ASSERT (delay.IsPositive ());
+  uint64_t ts = p->currentTs + delay.GetTimeStep ();
+  Partition *dst = GetPartitionOf (context);
+  if (dst == p || p == &m_global)
+    {
+      // the global events run while the partitions wait
+      Insert (dst, ts, context, event);
+      return;
+    }
+  if (ts < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event for context " << context << " scheduled at " << TimeStep (ts)
+                      << " by context " << p->currentContext << " at " << TimeStep (p->currentTs)
+                      << ": the delay between two partitions must not be shorter than the lookahead "
+                      << TimeStep (m_lookahead));
+    }
+  RemoteEvent ev;
+  ev.ts = ts;
+  ev.context = context;
+  ev.impl = event;
+  dst->incoming[p->index]->Push (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  Partition *p = g_current;
+  NS_ASSERT_MSG (p != 0, "Simulator::ScheduleNow from a thread which does not run a partition");
+  uint32_t uid = Insert (p, p->currentTs, p->currentContext, event);
+  return EventId (event, p->currentTs, p->currentContext, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), g_current->currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (g_current->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - g_current->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *p = GetPartitionOf (id.GetContext ());
+  NS_ASSERT_MSG (p == g_current || g_current == &m_global,
+                 "Simulator::Remove of an event of another partition, use Simulator::Cancel instead");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  p->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  Partition *p = GetPartitionOf (id.GetContext ());
+  if (id.PeekEventImpl () == 0 ||
+      id.GetTs () < p->currentTs ||
+      (id.GetTs () == p->currentTs &&
+       id.GetUid () <= p->currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (MAX_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return g_current->currentContext;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t node) const
+{
+  NS_ASSERT (node < m_nodePartition.size ());
+  return m_nodePartition[node]->index;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return TimeStep (m_lookahead);
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount (uint32_t partition) const
+{
+  NS_ASSERT (partition < m_partitions.size ());
+  return m_partitions[partition]->eventCount;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetWindowCount (void) const
+{
+  return m_windowCount;
+}
+
+} // namespace ns3
@@ -0,0 +1,282 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "spsc-queue.h"
+#include "spin-barrier.h"
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-mutex.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mtp
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \defgroup mtp Multithreaded Simulation
+ *
+ * Conservative parallel simulation of the nodes of one process on
+ * several threads sharing memory.
+ */
+
+/**
+ * \ingroup mtp
+ * \brief A conservative multithreaded simulator implementation.
+ *
+ * When Simulator::Run() is first called, the nodes are split into
+ * partitions, one per thread. Only the links whose devices are
+ * point-to-point (NetDevice::IsPointToPoint) and whose channel has a
+ * non-zero "Delay" attribute, such as the PointToPointChannel, are cut
+ * by the partitioning: the nodes connected by any other channel end up
+ * in the same partition. If some node has a non-zero system id (see
+ * Node::GetSystemId), the system ids are the partitions, as with the
+ * DistributedSimulatorImpl; otherwise the nodes are numbered in
+ * breadth-first order over the links and the order is cut into
+ * partitions of the same number of nodes. The lookahead is the
+ * smallest delay of the links between two partitions.
+ *
+ * Each partition has its own scheduler, clock and thread, and the
+ * partitions advance in windows: every thread runs the events of its
+ * partition which are earlier than the end of the window, then all the
+ * threads meet at a lock-free barrier (SpinBarrier). An event
+ * scheduled for a node of another partition (that is, a packet sent on
+ * a cut link) is handed over in the SpscQueue from the sending thread
+ * to the receiving one, without copying or serializing the packet; the
+ * receivers insert these events in their scheduler after the barrier,
+ * in the order of the sending partitions, so that the simulation is
+ * deterministic. Such an event runs after the events with the same
+ * timestamp which its receiving partition scheduled before the end of
+ * the window in which it was sent, so that the order of simultaneous
+ * events may differ from the DefaultSimulatorImpl, which runs them in
+ * the order in which they were scheduled. Then the lower bound on the timestamp of the next
+ * events (LBTS) is the earliest event of all the partitions, and the
+ * next window ends one lookahead after the LBTS, as no event received
+ * from another partition can be earlier.
+ *
+ * The events without a node context (Simulator::NO_CONTEXT), such as
+ * the events scheduled from the main program with Simulator::Schedule,
+ * are global: they run between two windows, in the thread which arrived
+ * last at the barrier while the other threads wait, before any node
+ * event of the same timestamp.
+ *
+ * The following restrictions apply, and are checked when possible:
+ *   - an event scheduled for a node of another partition, or a global
+ *     event scheduled by a node, must be at least one lookahead in the
+ *     future;
+ *   - Simulator::Remove and Simulator::IsExpired only work for the events
+ *     of the calling partition (Simulator::Cancel works everywhere);
+ *   - objects shared by nodes of several partitions (e.g., a
+ *     FlowMonitor, or a trace sink counting the packets of all the
+ *     nodes) are not protected, and the nodes must not change after
+ *     the first Simulator::Run().
+ *   - Simulator::Stop (and Simulator::Stop with a delay shorter than
+ *     the lookahead) called by a node event takes effect at the end of
+ *     the current window.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * Get the number of partitions, which is zero before the first
+   * Simulator::Run().
+   *
+   * \returns The number of partitions.
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * Get the partition of a node.
+   *
+   * \param [in] node The node id.
+   * \returns The partition.
+   */
+  uint32_t GetPartition (uint32_t node) const;
+  /**
+   * Get the lookahead between the partitions.
+   *
+   * \returns The lookahead, or GetMaximumSimulationTime() if there is
+   * no link between two partitions.
+   */
+  Time GetLookahead (void) const;
+  /**
+   * Get the number of events run by a partition.
+   *
+   * \param [in] partition The partition.
+   * \returns The number of events.
+   */
+  uint64_t GetEventCount (uint32_t partition) const;
+  /**
+   * Get the number of windows of the simulation.
+   *
+   * \returns The number of windows.
+   */
+  uint64_t GetWindowCount (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event handed over to another partition. */
+  struct RemoteEvent
+  {
+    uint64_t ts;        //!< Timestamp
+    uint32_t context;   //!< Node context
+    EventImpl *impl;    //!< The event
+  };
+
+  /** The events and the clock of a partition. */
+  struct Partition
+  {
+    Ptr<Scheduler> events;      //!< The event priority queue
+    uint64_t currentTs;         //!< Timestamp of the current event
+    uint32_t currentUid;        //!< Unique id of the current event
+    uint32_t currentContext;    //!< Execution context of the current event
+    uint32_t uid;               //!< Next event unique id
+    uint64_t eventCount;        //!< Number of events run
+    uint32_t index;             //!< Index of the partition, used by the receivers to find the queue of the sender
+    /** Events from the other partitions, indexed by sending partition. */
+    std::vector<SpscQueue<RemoteEvent> *> incoming;
+  };
+
+  /**
+   * Split the nodes into partitions, and move their events from the
+   * global partition to their partition.
+   */
+  void CreatePartitions (void);
+  /**
+   * Get the partition which runs the events of a context.
+   *
+   * \param [in] context The context.
+   * \returns The partition.
+   */
+  Partition * GetPartitionOf (uint32_t context) const;
+  /**
+   * Insert an event in a partition.
+   *
+   * \param [in] p The partition.
+   * \param [in] ts The timestamp.
+   * \param [in] context The context.
+   * \param [in] event The event.
+   * \returns The unique id of the event.
+   */
+  uint32_t Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Run the events of a partition.
+   *
+   * \param [in] index The index of the partition.
+   */
+  void RunPartition (uint32_t index);
+  /**
+   * Run the events of a partition until the end of the current window.
+   *
+   * \param [in] p The partition.
+   */
+  void ProcessWindow (Partition *p);
+  /**
+   * Insert the events handed over to a partition in its scheduler.
+   *
+   * \param [in] p The partition.
+   */
+  void ProcessIncoming (Partition *p);
+  /**
+   * Run the global events which are due, then compute the end of the
+   * next window. This is called by one thread while the others wait.
+   */
+  void Synchronize (void);
+
+  /** Maximum number of threads (0 for the number of cores). */
+  uint32_t m_maxThreads;
+  /** The factory of the schedulers. */
+  ObjectFactory m_schedulerFactory;
+  /** The global events, and the events of the nodes before the first Run(). */
+  Partition m_global;
+  /** The partitions of the nodes. */
+  std::vector<Partition *> m_partitions;
+  /** The partition of each node, indexed by node id. */
+  std::vector<Partition *> m_nodePartition;
+  /** The lookahead, in time steps. */
+  uint64_t m_lookahead;
+  /** The end (excluded) of the current window, in time steps. */
+  uint64_t m_windowEnd;
+  /** Number of windows. */
+  uint64_t m_windowCount;
+  /** Synchronization of the partitions between two windows. */
+  SpinBarrier *m_barrier;
+  /** Set by Synchronize() when the simulation is over. */
+  bool m_finished;
+  /** Flag calling for the end of the simulation. */
+  std::atomic<bool> m_stop;
+  /** Time at which the simulation stops, in time steps. */
+  std::atomic<uint64_t> m_stopTs;
+
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** Mutex to control access to the list of destroy events. */
+  SystemMutex m_destroyEventsMutex;
+
+  /** The partition whose events the calling thread runs. */
+  static thread_local Partition *g_current;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "spin-barrier.h"
+#include "ns3/assert.h"
+#include <sched.h>
+
+/**
+ * \file
+ * \ingroup mtp
+ * ns3::SpinBarrier implementation.
+ */
+
+namespace ns3 {
+
+SpinBarrier::SpinBarrier (uint32_t n)
+  : m_n (n),
+    m_count (0),
+    m_generation (0)
+{
+  NS_ASSERT (n > 0);
+}
+
+bool
+SpinBarrier::Arrive (void)
+{
+  // the generation can not change before this thread arrived
+  uint32_t generation = m_generation.load (std::memory_order_acquire);
+  if (m_count.fetch_add (1, std::memory_order_acq_rel) + 1 == m_n)
+    {
+      // nobody arrives at the next barrier before Release ()
+      m_count.store (0, std::memory_order_relaxed);
+      return true;
+    }
+  uint32_t spins = 0;
+  while (m_generation.load (std::memory_order_acquire) == generation)
+    {
+      if (spins < SPIN_COUNT)
+        {
+          spins++;
+        }
+      else
+        {
+          sched_yield ();
+        }
+    }
+  return false;
+}
+
+void
+SpinBarrier::Release (void)
+{
+  m_generation.fetch_add (1, std::memory_order_release);
+}
+
+void
+SpinBarrier::Wait (void)
+{
+  if (Arrive ())
+    {
+      Release ();
+    }
+}
+
+} // namespace ns3
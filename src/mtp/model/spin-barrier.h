@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SPIN_BARRIER_H
+#define SPIN_BARRIER_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * \file
+ * \ingroup mtp
+ * ns3::SpinBarrier declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup mtp
+ * \brief A lock-free barrier for a fixed number of threads.
+ *
+ * The threads count their arrival with an atomic increment and wait for
+ * the generation number of the barrier to change. The last thread to
+ * arrive is told so by Arrive(): it can then run a serial section,
+ * while the other threads wait, before it calls Release() to let them
+ * go. The waiting threads spin for a while, then yield the processor,
+ * so that the barrier does not starve the other threads when there are
+ * more threads than cores.
+ *
+ * \code
+ *   if (barrier.Arrive ())
+ *     {
+ *       // serial section
+ *       barrier.Release ();
+ *     }
+ * \endcode
+ */
+class SpinBarrier
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] n The number of threads.
+   */
+  SpinBarrier (uint32_t n);
+
+  /**
+   * Wait for all the threads but the last one to arrive.
+   *
+   * \returns \c true in the last thread to arrive, which must call
+   * Release(), \c false in the other threads once Release() was called.
+   */
+  bool Arrive (void);
+  /** Release the threads waiting in Arrive(). */
+  void Release (void);
+  /** Wait for all the threads to arrive. */
+  void Wait (void);
+
+private:
+  /** Number of iterations a waiting thread spins before it yields. */
+  static const uint32_t SPIN_COUNT = 1000;
+
+  uint32_t m_n;                          //!< Number of threads
+  std::atomic<uint32_t> m_count;         //!< Number of threads arrived
+  std::atomic<uint32_t> m_generation;    //!< Incremented by each Release()
+};
+
+} // namespace ns3
+
+#endif /* SPIN_BARRIER_H */
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * \file
+ * \ingroup mtp
+ * ns3::SpscQueue declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup mtp
+ * \brief An unbounded lock-free single-producer single-consumer queue.
+ *
+ * The items are stored in a linked list of chunks of CHUNK_SIZE items.
+ * The producer publishes the number of items written in its chunk with
+ * a release store, which the consumer reads with an acquire load, so
+ * that neither side ever takes a lock or waits for the other one.
+ * Push() must only be called by one thread, and Pop() and IsEmpty() by
+ * one (possibly different) thread.
+ *
+ * \tparam T \explicit The type of the items, which is copied.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  /** Constructor. */
+  SpscQueue ();
+  /** Destructor. The remaining items are discarded. */
+  ~SpscQueue ();
+
+  /**
+   * Append an item (producer side).
+   *
+   * \param [in] item The item.
+   */
+  void Push (const T &item);
+  /**
+   * Remove the oldest item (consumer side).
+   *
+   * \param [out] item The item, if any.
+   * \returns \c true if an item was removed.
+   */
+  bool Pop (T &item);
+  /**
+   * Check for items (consumer side).
+   *
+   * \returns \c true if Pop() would fail.
+   */
+  bool IsEmpty (void) const;
+
+private:
+  /** Number of items per chunk. */
+  static const uint32_t CHUNK_SIZE = 255;
+
+  /** A chunk of items. */
+  struct Chunk
+  {
+    /** Constructor. */
+    Chunk () : written (0), next (0) {}
+    T items[CHUNK_SIZE];                //!< The items
+    std::atomic<uint32_t> written;      //!< Number of items published by the producer
+    std::atomic<Chunk *> next;          //!< Next chunk, set once this one is full
+  };
+
+  // consumer side
+  Chunk *m_head;        //!< Chunk read by the consumer
+  uint32_t m_read;      //!< Index of the next item to read in m_head
+  /** Padding between the consumer and producer sides. */
+  uint8_t m_padding[64 - sizeof (Chunk *) - sizeof (uint32_t)];
+  // producer side
+  Chunk *m_tail;        //!< Chunk written by the producer
+  uint32_t m_write;     //!< Index of the next item to write in m_tail
+
+  /**
+   * Copy constructor, disabled.
+   * \param [in] o Other queue.
+   */
+  SpscQueue (const SpscQueue &o);
+  /**
+   * Assignment, disabled.
+   * \param [in] o Other queue.
+   * \returns This queue.
+   */
+  SpscQueue & operator = (const SpscQueue &o);
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+SpscQueue<T>::SpscQueue ()
+  : m_head (new Chunk ()),
+    m_read (0),
+    m_write (0)
+{
+  m_tail = m_head;
+}
+
+template <typename T>
+SpscQueue<T>::~SpscQueue ()
+{
+  while (m_head != 0)
+    {
+      Chunk *next = m_head->next.load (std::memory_order_relaxed);
+      delete m_head;
+      m_head = next;
+    }
+}
+
+template <typename T>
+void
+SpscQueue<T>::Push (const T &item)
+{
+  if (m_write == CHUNK_SIZE)
+    {
+      Chunk *chunk = new Chunk ();
+      chunk->items[0] = item;
+      chunk->written.store (1, std::memory_order_relaxed);
+      // publishes the first item of the chunk too
+      m_tail->next.store (chunk, std::memory_order_release);
+      m_tail = chunk;
+      m_write = 1;
+      return;
+    }
+  m_tail->items[m_write] = item;
+  m_write++;
+  m_tail->written.store (m_write, std::memory_order_release);
+}
+
+template <typename T>
+bool
+SpscQueue<T>::Pop (T &item)
+{
+  while (true)
+    {
+      if (m_read < m_head->written.load (std::memory_order_acquire))
+        {
+          item = m_head->items[m_read];
+          m_read++;
+          return true;
+        }
+      if (m_read < CHUNK_SIZE)
+        {
+          return false;
+        }
+      Chunk *next = m_head->next.load (std::memory_order_acquire);
+      if (next == 0)
+        {
+          return false;
+        }
+      delete m_head;
+      m_head = next;
+      m_read = 0;
+    }
+}
+
+template <typename T>
+bool
+SpscQueue<T>::IsEmpty (void) const
+{
+  if (m_read < m_head->written.load (std::memory_order_acquire))
+    {
+      return false;
+    }
+  return m_read < CHUNK_SIZE || m_head->next.load (std::memory_order_acquire) == 0;
+}
+
+} // namespace ns3
+
+#endif /* SPSC_QUEUE_H */
@@ -0,0 +1,933 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/spsc-queue.h"
+#include "ns3/spin-barrier.h"
+#include "ns3/simulator.h"
+#include "ns3/system-thread.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/packet-metadata.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/tag.h"
+#include "ns3/llc-snap-header.h"
+#include "ns3/ethernet-trailer.h"
+
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup mtp
+ * \defgroup mtp-test Multithreaded simulation module tests
+ */
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief SpscQueue test: the items come out in order, within a thread
+ * and between a producer and a consumer thread.
+ */
+class SpscQueueTestCase : public TestCase
+{
+public:
+  SpscQueueTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /** Push N_ITEMS items, from the producer thread. */
+  void Produce (void);
+
+  /** Number of items pushed by the producer thread. */
+  static const uint32_t N_ITEMS = 100000;
+  SpscQueue<uint32_t> m_queue;   //!< The queue between the two threads
+};
+
+SpscQueueTestCase::SpscQueueTestCase ()
+  : TestCase ("Check the single-producer single-consumer queue")
+{
+}
+
+void
+SpscQueueTestCase::Produce (void)
+{
+  for (uint32_t i = 0; i < N_ITEMS; i++)
+    {
+      m_queue.Push (i);
+    }
+}
+
+void
+SpscQueueTestCase::DoRun (void)
+{
+  SpscQueue<uint32_t> queue;
+  uint32_t item = 0;
+  NS_TEST_ASSERT_MSG_EQ (queue.IsEmpty (), true, "A new queue is empty");
+  NS_TEST_ASSERT_MSG_EQ (queue.Pop (item), false, "A new queue is empty");
+  // fill and drain several chunks, interleaving the pushes and the pops
+  uint32_t pushed = 0;
+  uint32_t popped = 0;
+  for (uint32_t round = 1; round < 20; round++)
+    {
+      for (uint32_t i = 0; i < round * 67; i++)
+        {
+          queue.Push (pushed++);
+        }
+      for (uint32_t i = 0; i < round * 50; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (queue.Pop (item), true, "The queue is not empty");
+          NS_TEST_ASSERT_MSG_EQ (item, popped, "The items come out in order");
+          popped++;
+        }
+    }
+  while (queue.Pop (item))
+    {
+      NS_TEST_ASSERT_MSG_EQ (item, popped, "The items come out in order");
+      popped++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (popped, pushed, "All the items came out");
+  NS_TEST_ASSERT_MSG_EQ (queue.IsEmpty (), true, "The queue is empty");
+
+  Ptr<SystemThread> producer = Create<SystemThread> (MakeCallback (&SpscQueueTestCase::Produce, this));
+  producer->Start ();
+  uint32_t expected = 0;
+  while (expected < N_ITEMS)
+    {
+      if (m_queue.Pop (item))
+        {
+          NS_TEST_ASSERT_MSG_EQ (item, expected, "The items come out in order");
+          expected++;
+        }
+    }
+  producer->Join ();
+  NS_TEST_ASSERT_MSG_EQ (m_queue.IsEmpty (), true, "The queue is empty");
+}
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief SpinBarrier test: the serial section runs once per round, and
+ * no thread leaves a round before all the threads reached it.
+ */
+class SpinBarrierTestCase : public TestCase
+{
+public:
+  SpinBarrierTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the rounds of a thread.
+   *
+   * \param [in] thread The index of the thread.
+   */
+  void RunThread (uint32_t thread);
+
+  static const uint32_t N_THREADS = 4;    //!< Number of threads
+  static const uint32_t N_ROUNDS = 2000;  //!< Number of rounds
+  SpinBarrier m_barrier;                  //!< The barrier
+  uint32_t m_round;                       //!< Incremented by the serial section
+  uint32_t m_errors[N_THREADS];           //!< Number of errors seen by each thread
+};
+
+SpinBarrierTestCase::SpinBarrierTestCase ()
+  : TestCase ("Check the lock-free barrier"),
+    m_barrier (N_THREADS),
+    m_round (0)
+{
+}
+
+void
+SpinBarrierTestCase::RunThread (uint32_t thread)
+{
+  for (uint32_t round = 0; round < N_ROUNDS; round++)
+    {
+      if (m_barrier.Arrive ())
+        {
+          m_round++;
+          m_barrier.Release ();
+        }
+      if (m_round != round + 1)
+        {
+          m_errors[thread]++;
+        }
+      // nobody starts the next serial section before all threads checked
+      m_barrier.Wait ();
+    }
+}
+
+void
+SpinBarrierTestCase::DoRun (void)
+{
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      m_errors[i] = 0;
+    }
+  for (uint32_t i = 1; i < N_THREADS; i++)
+    {
+      Callback<void, uint32_t> run = MakeCallback (&SpinBarrierTestCase::RunThread, this);
+      threads.push_back (Create<SystemThread> (run.Bind (i)));
+      threads.back ()->Start ();
+    }
+  RunThread (0);
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i]->Join ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_round, N_ROUNDS, "One serial section per round");
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_errors[i], 0, "Thread " << i << " left a round too early");
+    }
+}
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief A packet tag carrying a value.
+ *
+ * \tparam N \explicit The tag number, so that a packet can carry several
+ * tags.
+ */
+template <int N>
+class MtpTestTag : public Tag
+{
+public:
+  /** Constructor. */
+  MtpTestTag () : m_value (0) {}
+  /**
+   * Constructor.
+   * \param [in] value The tag value.
+   */
+  MtpTestTag (uint32_t value) : m_value (value) {}
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    std::ostringstream oss;
+    oss << "anon::MtpTestTag<" << N << ">";
+    static TypeId tid = TypeId (oss.str ().c_str ())
+      .SetParent<Tag> ()
+      .SetGroupName ("Mtp")
+      .HideFromDocumentation ()
+      .AddConstructor<MtpTestTag<N> > ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 4;
+  }
+  virtual void Serialize (TagBuffer buf) const
+  {
+    buf.WriteU32 (m_value);
+  }
+  virtual void Deserialize (TagBuffer buf)
+  {
+    m_value = buf.ReadU32 ();
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "value=" << m_value;
+  }
+  uint32_t m_value;  //!< The tag value
+};
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief Packets shared between threads: each thread adds, replaces and
+ * removes packet tags on copies of the same packet, as the partitions
+ * of a multithreaded simulation do with the copies of a packet that
+ * they exchanged, and the tags of the other copies must not change.
+ */
+class PacketSharingTestCase : public TestCase
+{
+public:
+  PacketSharingTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the rounds of a thread.
+   *
+   * \param [in] thread The index of the thread.
+   */
+  void RunThread (uint32_t thread);
+
+  static const uint32_t N_THREADS = 2;     //!< Number of threads
+  static const uint32_t N_ROUNDS = 20000;  //!< Number of rounds
+  SpinBarrier m_barrier;                   //!< Starts the threads together
+  Ptr<Packet> m_packet;                    //!< The packet copied by the threads
+  uint32_t m_errors[N_THREADS];            //!< Number of errors seen by each thread
+};
+
+PacketSharingTestCase::PacketSharingTestCase ()
+  : TestCase ("Check packets shared between threads"),
+    m_barrier (N_THREADS)
+{
+}
+
+void
+PacketSharingTestCase::RunThread (uint32_t thread)
+{
+  if (m_barrier.Arrive ())
+    {
+      m_barrier.Release ();
+    }
+  Ptr<Packet> mine = m_packet->Copy ();
+  for (uint32_t round = 0; round < N_ROUNDS; round++)
+    {
+      // both threads copy on write the tags shared with the other thread
+      Ptr<Packet> p = mine->Copy ();
+      MtpTestTag<1> t1;
+      MtpTestTag<2> t2 (thread);
+      MtpTestTag<3> t3;
+      p->ReplacePacketTag (t2);
+      p->AddPacketTag (MtpTestTag<3> (round));
+      if (!p->RemovePacketTag (t1) || t1.m_value != 1)
+        {
+          m_errors[thread]++;
+        }
+      if (!p->PeekPacketTag (t3) || t3.m_value != round
+          || !p->PeekPacketTag (t2) || t2.m_value != thread)
+        {
+          m_errors[thread]++;
+        }
+      // and release the copies in turn
+      if (round % 2)
+        {
+          mine = p;
+          mine->AddPacketTag (MtpTestTag<1> (1));
+          mine->RemovePacketTag (t3);
+        }
+      else
+        {
+          p->RemoveAllPacketTags ();
+        }
+      if (!mine->PeekPacketTag (t1) || t1.m_value != 1
+          || !m_packet->PeekPacketTag (t2) || t2.m_value != 2)
+        {
+          m_errors[thread]++;
+        }
+    }
+}
+
+void
+PacketSharingTestCase::DoRun (void)
+{
+  m_packet = Create<Packet> (100);
+  m_packet->AddPacketTag (MtpTestTag<1> (1));
+  m_packet->AddPacketTag (MtpTestTag<2> (2));
+  // register the last tag type before the threads use it
+  MtpTestTag<3>::GetTypeId ();
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      m_errors[i] = 0;
+    }
+  for (uint32_t i = 1; i < N_THREADS; i++)
+    {
+      Callback<void, uint32_t> run = MakeCallback (&PacketSharingTestCase::RunThread, this);
+      threads.push_back (Create<SystemThread> (run.Bind (i)));
+      threads.back ()->Start ();
+    }
+  RunThread (0);
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i]->Join ();
+    }
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_errors[i], 0, "Thread " << i << " saw wrong packet tags");
+    }
+  m_packet = 0;
+}
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief Packets shared between threads: each thread adds headers and
+ * trailers to copies of the same packet, which all try to write in
+ * place in the shared buffer, and the bytes of the other copies must
+ * not change.
+ */
+class PacketBufferSharingTestCase : public TestCase
+{
+public:
+  PacketBufferSharingTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the rounds of a thread.
+   *
+   * \param [in] thread The index of the thread.
+   */
+  void RunThread (uint32_t thread);
+
+  static const uint32_t N_THREADS = 2;     //!< Number of threads
+  static const uint32_t N_ROUNDS = 20000;  //!< Number of rounds
+  static const uint32_t SIZE = 100;        //!< Size of the payload
+  SpinBarrier m_barrier;                   //!< Starts the threads together
+  Ptr<Packet> m_packet;                    //!< The packet copied by the threads
+  uint8_t m_payload[SIZE];                 //!< The payload of the packet
+  uint32_t m_errors[N_THREADS];            //!< Number of errors seen by each thread
+};
+
+PacketBufferSharingTestCase::PacketBufferSharingTestCase ()
+  : TestCase ("Check packet buffers shared between threads"),
+    m_barrier (N_THREADS)
+{
+}
+
+void
+PacketBufferSharingTestCase::RunThread (uint32_t thread)
+{
+  if (m_barrier.Arrive ())
+    {
+      m_barrier.Release ();
+    }
+  for (uint32_t round = 0; round < N_ROUNDS; round++)
+    {
+      uint16_t type = (thread << 15) | (round & 0x7fff);
+      Ptr<Packet> p = m_packet->Copy ();
+      LlcSnapHeader header;
+      header.SetType (type);
+      p->AddHeader (header);
+      EthernetTrailer trailer;
+      trailer.EnableFcs (true);
+      trailer.CalcFcs (p);
+      p->AddTrailer (trailer);
+      // a copy in this thread which writes after the first one
+      Ptr<Packet> q = p->Copy ();
+      q->AddHeader (header);
+
+      p->RemoveTrailer (trailer);
+      p->RemoveHeader (header);
+      if (!trailer.CheckFcs (q->CreateFragment (8, p->GetSize () + 8))
+          || header.GetType () != type)
+        {
+          m_errors[thread]++;
+        }
+      uint8_t payload[SIZE];
+      if (p->PeekHeader (header) != 8 || header.GetType () != 0x0800
+          || p->GetSize () != SIZE + 8)
+        {
+          m_errors[thread]++;
+        }
+      p->RemoveHeader (header);
+      p->CopyData (payload, SIZE);
+      if (memcmp (payload, m_payload, SIZE) != 0)
+        {
+          m_errors[thread]++;
+        }
+    }
+}
+
+void
+PacketBufferSharingTestCase::DoRun (void)
+{
+  // as the MultithreadedSimulatorImpl does
+  PacketMetadata::EnableMultithreading ();
+  for (uint32_t i = 0; i < SIZE; i++)
+    {
+      m_payload[i] = i;
+    }
+  m_packet = Create<Packet> (m_payload, SIZE);
+  LlcSnapHeader header;
+  header.SetType (0x0800);
+  m_packet->AddHeader (header);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      m_errors[i] = 0;
+    }
+  for (uint32_t i = 1; i < N_THREADS; i++)
+    {
+      Callback<void, uint32_t> run = MakeCallback (&PacketBufferSharingTestCase::RunThread, this);
+      threads.push_back (Create<SystemThread> (run.Bind (i)));
+      threads.back ()->Start ();
+    }
+  RunThread (0);
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i]->Join ();
+    }
+  for (uint32_t i = 0; i < N_THREADS; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_errors[i], 0, "Thread " << i << " saw wrong packet bytes");
+    }
+  m_packet = 0;
+}
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief Multithreaded simulation test.
+ *
+ * Tokens (packets) travel at random over a ring of nodes with a few
+ * chords, each node growing the packet, keeping a copy of it and
+ * scheduling a local event, and a global event samples the state of all
+ * the nodes. The ring links are point-to-point SimpleChannels with
+ * different delays, and two nodes are also connected by a broadcast
+ * SimpleChannel, so that they must be in the same partition. The
+ * statistics of each node and the samples must be the same with the
+ * DefaultSimulatorImpl and with the MultithreadedSimulatorImpl.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] threads The maximum number of threads.
+   * \param [in] systemIds Whether to partition with the node system ids.
+   */
+  MultithreadedSimulatorTestCase (uint32_t threads, bool systemIds);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /** The statistics of a node. */
+  struct NodeState
+  {
+    uint64_t received;        //!< Number of tokens received
+    uint64_t checksum;        //!< Sum of a hash of the received tokens
+    uint64_t local;           //!< Number of local events
+    Ptr<Packet> last;         //!< Copy of a token received
+  };
+  /** The results of a simulation. */
+  struct Results
+  {
+    std::vector<NodeState> nodes;   //!< The statistics of the nodes
+    std::vector<uint64_t> samples;  //!< The samples of the global event
+    Time end;                       //!< The time after Simulator::Run
+  };
+
+  /**
+   * Run the simulation.
+   *
+   * \param [in] simulatorType The simulator implementation.
+   * \returns The results.
+   */
+  Results RunSimulation (std::string simulatorType);
+  /**
+   * Receive a token.
+   *
+   * \param [in] node The node.
+   * \param [in] token The token.
+   * \param [in] hops The number of hops left.
+   */
+  void Receive (uint32_t node, Ptr<Packet> token, uint32_t hops);
+  /**
+   * A local event.
+   *
+   * \param [in] node The node.
+   */
+  void Local (uint32_t node);
+  /** The global event. */
+  void Sample (void);
+  /**
+   * Hash of the arrival of a token.
+   *
+   * \param [in] node The node.
+   * \param [in] hops The number of hops left.
+   * \returns The hash.
+   */
+  static uint64_t Hash (uint32_t node, uint32_t hops);
+
+  static const uint32_t N_NODES = 13;   //!< Number of nodes
+  uint32_t m_threads;                   //!< Maximum number of threads
+  bool m_systemIds;                     //!< Whether the nodes have system ids
+  std::vector<std::vector<uint32_t> > m_neighbours;  //!< The neighbours of each node
+  std::vector<std::vector<Time> > m_delays;          //!< The delays of the links to the neighbours
+  Results m_results;                    //!< The results of the current simulation
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase (uint32_t threads, bool systemIds)
+  : TestCase ("Check that the multithreaded simulator, with " + std::to_string (threads) + " threads"
+              + (systemIds ? " and system ids" : "") + ", gives the results of the default one"),
+    m_threads (threads),
+    m_systemIds (systemIds)
+{
+}
+
+uint64_t
+MultithreadedSimulatorTestCase::Hash (uint32_t node, uint32_t hops)
+{
+  uint64_t x = Simulator::Now ().GetTimeStep () * 0x9e3779b97f4a7c15ULL + node * 1000003ULL + hops;
+  x ^= x >> 29;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 32;
+  return x;
+}
+
+void
+MultithreadedSimulatorTestCase::Receive (uint32_t node, Ptr<Packet> token, uint32_t hops)
+{
+  NS_ASSERT (Simulator::GetContext () == node);
+  NodeState &state = m_results.nodes[node];
+  uint64_t hash = Hash (node, hops);
+  state.received++;
+  state.checksum += hash + token->GetSize ();
+  // the copy shares its buffer with the token, which goes on to another thread
+  token->AddPaddingAtEnd (1 + hash % 7);
+  if (token->GetSize () > 400)
+    {
+      token->RemoveAtStart (300);
+    }
+  state.last = token->Copy ();
+  Simulator::Schedule (MicroSeconds (1 + hash % 3), &MultithreadedSimulatorTestCase::Local, this, node);
+  if (hops == 0)
+    {
+      return;
+    }
+  uint32_t i = (hash >> 8) % m_neighbours[node].size ();
+  uint32_t next = m_neighbours[node][i];
+  Simulator::ScheduleWithContext (next, m_delays[node][i], &MultithreadedSimulatorTestCase::Receive,
+                                  this, next, token, hops - 1);
+}
+
+void
+MultithreadedSimulatorTestCase::Local (uint32_t node)
+{
+  m_results.nodes[node].local++;
+}
+
+void
+MultithreadedSimulatorTestCase::Sample (void)
+{
+  NS_ASSERT (Simulator::GetContext () == Simulator::NO_CONTEXT);
+  uint64_t sample = 0;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      sample = sample * 31 + m_results.nodes[i].received + m_results.nodes[i].local;
+    }
+  m_results.samples.push_back (sample);
+  // between two node events, which are on microseconds
+  Simulator::Schedule (MicroSeconds (50), &MultithreadedSimulatorTestCase::Sample, this);
+}
+
+MultithreadedSimulatorTestCase::Results
+MultithreadedSimulatorTestCase::RunSimulation (std::string simulatorType)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (m_threads));
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      // nodes 0 and 1 share a broadcast channel
+      uint32_t systemId = m_systemIds ? (i < 2 ? 0 : i % m_threads) : 0;
+      nodes.push_back (CreateObject<Node> (systemId));
+    }
+  m_neighbours.assign (N_NODES, std::vector<uint32_t> ());
+  m_delays.assign (N_NODES, std::vector<Time> ());
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      // the ring, and chords between the opposite nodes
+      uint32_t peers[2] = { (i + 1) % N_NODES, (i + N_NODES / 2) % N_NODES };
+      for (uint32_t j = 0; j < (i % 3 == 0 ? 2 : 1); j++)
+        {
+          Time delay = MicroSeconds (10 + (i * 7 + j * 5) % 13);
+          Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+          channel->SetAttribute ("Delay", TimeValue (delay));
+          uint32_t ends[2] = { i, peers[j] };
+          for (uint32_t k = 0; k < 2; k++)
+            {
+              Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+              device->SetAttribute ("PointToPointMode", BooleanValue (true));
+              device->SetChannel (channel);
+              nodes[ends[k]]->AddDevice (device);
+              m_neighbours[ends[k]].push_back (ends[1 - k]);
+              m_delays[ends[k]].push_back (delay);
+            }
+        }
+    }
+  Ptr<SimpleChannel> broadcast = CreateObject<SimpleChannel> ();
+  broadcast->SetAttribute ("Delay", TimeValue (MicroSeconds (1)));
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetChannel (broadcast);
+      nodes[k]->AddDevice (device);
+      m_neighbours[k].push_back (1 - k);
+      m_delays[k].push_back (MicroSeconds (1));
+    }
+
+  m_results.nodes.assign (N_NODES, NodeState ());
+  m_results.samples.clear ();
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < 3; j++)
+        {
+          Simulator::ScheduleWithContext (i, MicroSeconds (i + 20 * j), &MultithreadedSimulatorTestCase::Receive,
+                                          this, i, Create<Packet> (100), 200 + 10 * j);
+        }
+    }
+  Simulator::Schedule (NanoSeconds (500), &MultithreadedSimulatorTestCase::Sample, this);
+  Simulator::Stop (MicroSeconds (3000));
+  Simulator::Run ();
+
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      uint32_t partitions = m_systemIds ? m_threads : std::min (m_threads, N_NODES - 1);
+      NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), partitions, "Number of partitions");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetPartition (0), impl->GetPartition (1),
+                             "Nodes on a broadcast channel are in the same partition");
+      if (m_threads == 1)
+        {
+          NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), impl->GetMaximumSimulationTime (),
+                                 "No lookahead with one partition");
+        }
+      else
+        {
+          Time lookahead = impl->GetMaximumSimulationTime ();
+          for (uint32_t i = 0; i < N_NODES; i++)
+            {
+              for (uint32_t j = 0; j < m_neighbours[i].size (); j++)
+                {
+                  if (impl->GetPartition (i) != impl->GetPartition (m_neighbours[i][j]))
+                    {
+                      lookahead = std::min (lookahead, m_delays[i][j]);
+                    }
+                }
+            }
+          NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), lookahead, "The lookahead is the shortest cut link");
+          NS_TEST_EXPECT_MSG_GT (impl->GetWindowCount (), 1, "Several windows");
+        }
+      uint64_t events = 0;
+      for (uint32_t i = 0; i < impl->GetPartitionCount (); i++)
+        {
+          events += impl->GetEventCount (i);
+        }
+      NS_TEST_EXPECT_MSG_GT (events, 0, "Events run by the partitions");
+    }
+  m_results.end = Simulator::Now ();
+  Results results = m_results;
+  Simulator::Destroy ();
+  return results;
+}
+
+void
+MultithreadedSimulatorTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  // the tokens are fragmented and padded: check their metadata too
+  Packet::EnableChecking ();
+  Results reference = RunSimulation ("ns3::DefaultSimulatorImpl");
+  Results results = RunSimulation ("ns3::MultithreadedSimulatorImpl");
+
+  NS_TEST_ASSERT_MSG_EQ (results.end, reference.end, "Time at the end of the simulation");
+  NS_TEST_ASSERT_MSG_EQ (results.end, MicroSeconds (3000), "Time at the end of the simulation");
+  uint64_t received = 0;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      received += reference.nodes[i].received;
+      NS_TEST_EXPECT_MSG_EQ (results.nodes[i].received, reference.nodes[i].received,
+                             "Tokens received by node " << i);
+      NS_TEST_EXPECT_MSG_EQ (results.nodes[i].checksum, reference.nodes[i].checksum,
+                             "Checksum of the tokens received by node " << i);
+      NS_TEST_EXPECT_MSG_EQ (results.nodes[i].local, reference.nodes[i].local,
+                             "Local events of node " << i);
+    }
+  NS_TEST_ASSERT_MSG_GT (received, 1000, "The tokens travelled");
+  NS_TEST_ASSERT_MSG_EQ (results.samples.size (), reference.samples.size (), "Number of samples");
+  for (uint32_t i = 0; i < reference.samples.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (results.samples[i], reference.samples[i], "Sample " << i);
+    }
+}
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief Events with the same timestamp, scheduled for a node by its own
+ * partition and by another one.
+ *
+ * Node 0 schedules an event R for node 1 at 10 us, at time 0; node 1
+ * schedules a local event L at 10 us too, at time 5 us, and another one,
+ * L2, at 10 us, at time 10 us. The DefaultSimulatorImpl runs them in the
+ * order in which they were scheduled: R, L, L2. With one partition per
+ * node and a lookahead of 10 us, R is handed over at the end of the first
+ * window, after L was scheduled: it runs after L, but before L2.
+ */
+class SameTimestampTestCase : public TestCase
+{
+public:
+  SameTimestampTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Run the simulation.
+   *
+   * \param [in] simulatorType The simulator implementation.
+   * \returns The events, in the order in which they ran.
+   */
+  std::string RunSimulation (std::string simulatorType);
+  /** Schedule R, from node 0. */
+  void ScheduleRemote (void);
+  /** Schedule L, from node 1. */
+  void ScheduleLocal (void);
+  /**
+   * Record an event.
+   *
+   * \param [in] name The name of the event.
+   */
+  void Record (std::string name);
+
+  std::string m_order;    //!< The events, in the order in which they ran
+};
+
+SameTimestampTestCase::SameTimestampTestCase ()
+  : TestCase ("Check the order of the events with the same timestamp")
+{
+}
+
+void
+SameTimestampTestCase::ScheduleRemote (void)
+{
+  Simulator::ScheduleWithContext (1, MicroSeconds (10), &SameTimestampTestCase::Record, this, "R");
+}
+
+void
+SameTimestampTestCase::ScheduleLocal (void)
+{
+  Simulator::Schedule (MicroSeconds (5), &SameTimestampTestCase::Record, this, "L");
+}
+
+void
+SameTimestampTestCase::Record (std::string name)
+{
+  NS_ASSERT (Simulator::Now () == MicroSeconds (10));
+  m_order += name;
+  if (name == "L")
+    {
+      Simulator::ScheduleNow (&SameTimestampTestCase::Record, this, "L2");
+    }
+}
+
+std::string
+SameTimestampTestCase::RunSimulation (std::string simulatorType)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (2));
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MicroSeconds (10)));
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> (i);
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAttribute ("PointToPointMode", BooleanValue (true));
+      device->SetChannel (channel);
+      node->AddDevice (device);
+    }
+  m_order = "";
+  Simulator::ScheduleWithContext (0, Seconds (0), &SameTimestampTestCase::ScheduleRemote, this);
+  Simulator::ScheduleWithContext (1, MicroSeconds (5), &SameTimestampTestCase::ScheduleLocal, this);
+  Simulator::Run ();
+
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), 2, "One partition per node");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), MicroSeconds (10), "The lookahead is the link delay");
+    }
+  Simulator::Destroy ();
+  return m_order;
+}
+
+void
+SameTimestampTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+SameTimestampTestCase::DoRun (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (RunSimulation ("ns3::DefaultSimulatorImpl"), "RLL2",
+                         "The events run in the order in which they were scheduled");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (RunSimulation ("ns3::MultithreadedSimulatorImpl"), "LRL2",
+                             "The event from the other partition runs as if it was scheduled at the end of the window");
+    }
+}
+
+/**
+ * \ingroup mtp-test
+ * \ingroup tests
+ *
+ * \brief The multithreaded simulation TestSuite.
+ */
+class MtpTestSuite : public TestSuite
+{
+public:
+  MtpTestSuite ();
+};
+
+MtpTestSuite::MtpTestSuite ()
+  : TestSuite ("mtp", UNIT)
+{
+  AddTestCase (new SpscQueueTestCase, TestCase::QUICK);
+  AddTestCase (new SpinBarrierTestCase, TestCase::QUICK);
+  // first, so that the packet metadata can still be enabled
+  AddTestCase (new MultithreadedSimulatorTestCase (1, false), TestCase::QUICK);
+  AddTestCase (new MultithreadedSimulatorTestCase (2, false), TestCase::QUICK);
+  AddTestCase (new MultithreadedSimulatorTestCase (4, false), TestCase::QUICK);
+  AddTestCase (new MultithreadedSimulatorTestCase (3, true), TestCase::QUICK);
+  AddTestCase (new SameTimestampTestCase, TestCase::QUICK);
+  AddTestCase (new PacketBufferSharingTestCase, TestCase::QUICK);
+  AddTestCase (new PacketSharingTestCase, TestCase::QUICK);
+}
+
+static MtpTestSuite g_mtpTestSuite; //!< Static variable for test initialization
@@ -50,7 +50,7 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+thread_local uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -68,6 +68,8 @@ uint32_t Buffer::g_recommendedStart = 0;
  * which the compiler assigns to zero-memory which is initialized to _zero_
  * before the constructors run so this ensures perfect handling of crazy 
  * constructor orderings.
+ * Each thread has its own free list, which is destroyed when the thread
+ * exits (and, for the main thread, before the static destructors run).
  */
 #define MAGIC_DESTROYED (~(long) 0)
 #define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
@@ -75,9 +77,9 @@ uint32_t Buffer::g_recommendedStart = 0;
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
 #define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
 #define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+thread_local uint32_t Buffer::g_maxSize = 0;
+thread_local Buffer::FreeList *Buffer::g_freeList = 0;
+thread_local struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
@@ -123,6 +125,9 @@ Buffer::Create (uint32_t dataSize)
   if (IS_UNINITIALIZED (g_freeList))
     {
       g_freeList = new Buffer::FreeList ();
+      // a thread_local object is only constructed (and later destroyed)
+      // in the threads which use it
+      (void) &g_localStaticDestructor;
     }
   else if (IS_INITIALIZED (g_freeList))
     {
@@ -220,8 +225,8 @@ Buffer::CheckInternalState (void) const
     m_zeroAreaStart <= m_zeroAreaEnd &&
     m_zeroAreaEnd <= m_end;
   bool dirtyOk =
-    m_start >= m_data->m_dirtyStart &&
-    m_end <= m_data->m_dirtyEnd;
+    m_start >= __atomic_load_n (&m_data->m_dirtyStart, __ATOMIC_RELAXED) &&
+    m_end <= __atomic_load_n (&m_data->m_dirtyEnd, __ATOMIC_RELAXED);
   bool internalSizeOk = m_end - (m_zeroAreaEnd - m_zeroAreaStart) <= m_data->m_size &&
     m_start <= m_data->m_size &&
     m_zeroAreaStart <= m_data->m_size;
@@ -262,13 +267,12 @@ Buffer::operator = (Buffer const&o)
   if (m_data != o.m_data) 
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (__atomic_sub_fetch (&m_data->m_count, 1, __ATOMIC_ACQ_REL) == 0)
         {
           Recycle (m_data);
         }
       m_data = o.m_data;
-      m_data->m_count++;
+      __atomic_add_fetch (&m_data->m_count, 1, __ATOMIC_RELAXED);
     }
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
@@ -285,8 +289,7 @@ Buffer::~Buffer ()
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (__atomic_sub_fetch (&m_data->m_count, 1, __ATOMIC_ACQ_REL) == 0)
     {
       Recycle (m_data);
     }
@@ -310,26 +313,37 @@ Buffer::AddAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
-  bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
-  if (m_start >= start && !isDirty)
+  bool inPlace = m_start >= start;
+  if (inPlace && __atomic_load_n (&m_data->m_count, __ATOMIC_ACQUIRE) > 1)
+    {
+      /* The other buffers which share the data, maybe in other threads,
+       * may have used the space before m_start: claim it only if the
+       * dirty area still starts at m_start.
+       */
+      uint32_t dirtyStart = m_start;
+      inPlace = __atomic_compare_exchange_n (&m_data->m_dirtyStart, &dirtyStart, m_start - start,
+                                             false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+    }
+  else if (inPlace)
+    {
+      // update dirty area
+      m_data->m_dirtyStart = m_start - start;
+    }
+  if (inPlace)
     {
       /* enough space in the buffer and not dirty. 
        * To add: |..|
        * Before: |*****---------***|
        * After:  |***..---------***|
        */
-      NS_ASSERT (m_data->m_count == 1 || m_start == m_data->m_dirtyStart);
       m_start -= start;
-      // update dirty area
-      m_data->m_dirtyStart = m_start;
     } 
   else
     {
       uint32_t newSize = GetInternalSize () + start;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data + start, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0)
+      if (__atomic_sub_fetch (&m_data->m_count, 1, __ATOMIC_ACQ_REL) == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -355,26 +369,37 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
-  bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
-  if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
+  bool inPlace = GetInternalEnd () + end <= m_data->m_size;
+  if (inPlace && __atomic_load_n (&m_data->m_count, __ATOMIC_ACQUIRE) > 1)
+    {
+      /* The other buffers which share the data, maybe in other threads,
+       * may have used the space after m_end: claim it only if the
+       * dirty area still ends at m_end.
+       */
+      uint32_t dirtyEnd = m_end;
+      inPlace = __atomic_compare_exchange_n (&m_data->m_dirtyEnd, &dirtyEnd, m_end + end,
+                                             false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+    }
+  else if (inPlace)
+    {
+      // update dirty area.
+      m_data->m_dirtyEnd = m_end + end;
+    }
+  if (inPlace)
     {
       /* enough space in buffer and not dirty
        * Add:    |...|
        * Before: |**----*****|
        * After:  |**----...**|
        */
-      NS_ASSERT (m_data->m_count == 1 || m_end == m_data->m_dirtyEnd);
       m_end += end;
-      // update dirty area.
-      m_data->m_dirtyEnd = m_end;
     } 
   else
     {
       uint32_t newSize = GetInternalSize () + end;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (__atomic_sub_fetch (&m_data->m_count, 1, __ATOMIC_ACQ_REL) == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -400,7 +425,7 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
+  if (__atomic_load_n (&m_data->m_count, __ATOMIC_ACQUIRE) == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
       o.m_start == o.m_zeroAreaStart &&
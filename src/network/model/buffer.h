@@ -661,7 +661,9 @@ private:
   {
     /**
      * The reference count of an instance of this data structure.
-     * Each buffer which references an instance holds a count.
+     * Each buffer which references an instance holds a count. It is
+     * updated atomically, as the copies of a packet may be used by
+     * several threads.
      */
     uint32_t m_count;
     /**
@@ -671,11 +673,15 @@ private:
     /**
      * offset from the start of the m_data field below to the
      * start of the area in which user bytes were written.
+     * While the data is shared, it is only moved with an atomic
+     * compare-and-swap, by the buffer which claims the bytes before it.
      */
     uint32_t m_dirtyStart;
     /**
      * offset from the start of the m_data field below to the
      * end of the area in which user bytes were written.
+     * While the data is shared, it is only moved with an atomic
+     * compare-and-swap, by the buffer which claims the bytes after it.
      */
     uint32_t m_dirtyEnd;
     /**
@@ -765,9 +771,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. Each thread has its own.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -793,14 +799,14 @@ private:
 #ifdef BUFFER_FREE_LIST
   /// Container for buffer data
   typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
+  /// Local static destructor structure, which releases the free list of a thread when it exits
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  static thread_local uint32_t g_maxSize; //!< Max observed data size
+  static thread_local FreeList *g_freeList; //!< Buffer data container, one per thread
+  static thread_local struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
 
@@ -1055,7 +1061,7 @@ Buffer::Buffer (Buffer const&o)
     m_start (o.m_start),
     m_end (o.m_end)
 {
-  m_data->m_count++;
+  __atomic_add_fetch (&m_data->m_count, 1, __ATOMIC_RELAXED);
   NS_ASSERT (CheckInternalState ());
 }
 
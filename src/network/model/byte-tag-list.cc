@@ -40,7 +40,7 @@ NS_LOG_COMPONENT_DEFINE ("ByteTagList");
  */
 struct ByteTagListData {
   uint32_t size;   //!< size of the data
-  uint32_t count;  //!< use counter (for smart deallocation)
+  uint32_t count;  //!< use counter (for smart deallocation, updated atomically)
   uint32_t dirty;  //!< number of bytes actually in use
   uint8_t data[4]; //!< data
 };
@@ -51,14 +51,15 @@ struct ByteTagListData {
  *
  * \brief Container class for struct ByteTagListData
  *
- * Internal use only.
+ * Internal use only. Each thread has its own free list.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+static thread_local class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
   ~ByteTagListDataFreeList ();
 } g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+static thread_local uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+static thread_local bool g_freeListDestroyed = false; //!< Whether g_freeList was destroyed (thread exit)
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -69,6 +70,8 @@ ByteTagListDataFreeList::~ByteTagListDataFreeList ()
       uint8_t *buffer = (uint8_t *)(*i);
       delete [] buffer;
     }
+  clear ();
+  g_freeListDestroyed = true;
 }
 #endif /* USE_FREE_LIST */
 
@@ -157,7 +160,7 @@ ByteTagList::ByteTagList (const ByteTagList &o)
   NS_LOG_FUNCTION (this << &o);
   if (m_data != 0)
     {
-      m_data->count++;
+      __atomic_add_fetch (&m_data->count, 1, __ATOMIC_RELAXED);
     }
 }
 ByteTagList &
@@ -176,7 +179,7 @@ ByteTagList::operator = (const ByteTagList &o)
   m_used = o.m_used;
   if (m_data != 0)
     {
-      m_data->count++;
+      __atomic_add_fetch (&m_data->count, 1, __ATOMIC_RELAXED);
     }
   return *this;
 }
@@ -345,7 +348,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  while (!g_freeListDestroyed && !g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
       g_freeList.pop_back ();
@@ -376,10 +379,10 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
       return;
     }
   g_maxSize = std::max (g_maxSize, data->size);
-  data->count--;
-  if (data->count == 0)
+  if (__atomic_sub_fetch (&data->count, 1, __ATOMIC_ACQ_REL) == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
+      if (g_freeListDestroyed ||
+          g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
           uint8_t *buffer = (uint8_t *)data;
@@ -414,8 +417,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  data->count--;
-  if (data->count == 0)
+  if (__atomic_sub_fetch (&data->count, 1, __ATOMIC_ACQ_REL) == 0)
     {
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
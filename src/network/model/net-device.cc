@@ -20,6 +20,8 @@
 
 #include "ns3/log.h"
 #include "net-device.h"
+#include "ns3/queue-item.h"
+#include "ns3/net-device-queue-interface.h"
 
 namespace ns3 {
 
@@ -41,4 +43,23 @@ NetDevice::~NetDevice ()
   NS_LOG_FUNCTION (this);
 }
 
+uint32_t
+NetDevice::SendBurst (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+  Ptr<NetDeviceQueueInterface> ndqi = GetObject<NetDeviceQueueInterface> ();
+  uint32_t sent = 0;
+
+  for (; sent < items.size (); sent++)
+    {
+      Ptr<QueueDiscItem> item = items[sent];
+      if (ndqi && ndqi->GetTxQueue (item->GetTxQueueIndex ())->IsStopped ())
+        {
+          break;
+        }
+      Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ());
+    }
+  return sent;
+}
+
 } // namespace ns3
@@ -22,6 +22,7 @@
 #define NET_DEVICE_H
 
 #include <stdint.h>
+#include <vector>
 #include "ns3/callback.h"
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -34,6 +35,7 @@ namespace ns3 {
 
 class Node;
 class Channel;
+class QueueDiscItem;
 
 /**
  * \ingroup network
@@ -246,6 +248,19 @@ public:
    * \return whether the Send operation succeeded 
    */
   virtual bool Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) = 0;
+  /**
+   * \param items the items to send, whose packets already include the
+   *        network header and whose destination addresses are already resolved
+   *
+   *  Called from the traffic control layer to hand a burst of packets to the
+   *  Network Device at once. The packets are sent in order until the device
+   *  transmission queue the next packet is destined to is stopped. The default
+   *  implementation calls Send for each packet.
+   *
+   * \return the number of items consumed by the device (including those the
+   *         device dropped). The caller must requeue the items not consumed.
+   */
+  virtual uint32_t SendBurst (const std::vector<Ptr<QueueDiscItem> > &items);
   /**
    * \param packet packet sent from above down to Network Device
    * \param source source mac address (so called "MAC spoofing")
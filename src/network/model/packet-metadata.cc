@@ -33,10 +33,12 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+bool PacketMetadata::m_enableMultithreading = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
+thread_local uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+thread_local PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+thread_local bool PacketMetadata::m_freeListDestroyed = false;
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -45,7 +47,8 @@ PacketMetadata::DataFreeList::~DataFreeList ()
     {
       PacketMetadata::Deallocate (*i);
     }
-  PacketMetadata::m_enable = false;
+  clear ();
+  PacketMetadata::m_freeListDestroyed = true;
 }
 
 void 
@@ -70,6 +73,13 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void
+PacketMetadata::EnableMultithreading (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_enableMultithreading = true;
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -77,8 +87,7 @@ PacketMetadata::ReserveCopy (uint32_t size)
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
   memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (__atomic_sub_fetch (&m_data->m_count, 1, __ATOMIC_ACQ_REL) == 0)
     {
       PacketMetadata::Recycle (m_data);
     }
@@ -100,10 +109,7 @@ PacketMetadata::Reserve (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   NS_ASSERT (m_data != 0);
-  if (m_data->m_size >= m_used + size &&
-      (m_head == 0xffff ||
-       m_data->m_count == 1 ||
-       m_data->m_dirtyEnd == m_used))
+  if (m_data->m_size >= m_used + size && !IsDirty ())
     {
       /* enough room, not dirty. */
     }
@@ -122,6 +128,24 @@ PacketMetadata::IsSharedPointerOk (uint16_t pointer) const
   return ok;
 }
 bool
+PacketMetadata::IsDirty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (__atomic_load_n (&m_data->m_count, __ATOMIC_ACQUIRE) == 1)
+    {
+      return false;
+    }
+  if (m_enableMultithreading)
+    {
+      /* The other metadata may be in other threads, which add their
+       * items after m_used and link them to the shared tail or head
+       * without any synchronization.
+       */
+      return true;
+    }
+  return m_head != 0xffff && m_used != m_data->m_dirtyEnd;
+}
+bool
 PacketMetadata::IsPointerOk (uint16_t pointer) const
 {
   NS_LOG_FUNCTION (this << pointer);
@@ -379,10 +403,7 @@ PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+  if (m_used + n > m_data->m_size || IsDirty ())
     {
       ReserveCopy (n);
     }
@@ -417,10 +438,7 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+  if (m_used + n > m_data->m_size || IsDirty ())
     {
       ReserveCopy (n);
     }
@@ -463,6 +481,7 @@ PacketMetadata::ReplaceTail (PacketMetadata::SmallItem *item,
    * path below.
    */
   if (m_tail + available == m_used &&
+      __atomic_load_n (&m_data->m_count, __ATOMIC_ACQUIRE) == 1 &&
       m_used == m_data->m_dirtyEnd)
     {
       available = m_data->m_size - m_tail;
@@ -476,7 +495,7 @@ PacketMetadata::ReplaceTail (PacketMetadata::SmallItem *item,
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
   if (available >= n &&
-      m_data->m_count == 1)
+      __atomic_load_n (&m_data->m_count, __ATOMIC_ACQUIRE) == 1)
     {
       uint8_t *buffer = &m_data->m_data[m_tail];
       Append16 (item->next, buffer);
@@ -575,7 +594,7 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  while (!m_freeListDestroyed && !m_freeList.empty ()) 
     {
       struct PacketMetadata::Data *data = m_freeList.back ();
       m_freeList.pop_back ();
@@ -596,7 +615,7 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
+  if (!m_enable || m_freeListDestroyed)
     {
       PacketMetadata::Deallocate (data);
       return;
@@ -674,8 +693,7 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = __atomic_fetch_add (&m_chunkUid, 1, __ATOMIC_RELAXED);
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
@@ -730,24 +748,30 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  DoAddTrailer (uid, size);
+  NS_ASSERT (IsStateOk ());
+}
+void
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   if (!m_enable)
     {
       m_metadataSkipped = true;
       return;
     }
+
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = __atomic_fetch_add (&m_chunkUid, 1, __ATOMIC_RELAXED);
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
-  NS_ASSERT (IsStateOk ());
 }
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
@@ -879,11 +903,19 @@ void
 PacketMetadata::AddPaddingAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
+  NS_ASSERT (IsStateOk ());
   if (!m_enable)
     {
       m_metadataSkipped = true;
       return;
     }
+  // the padding is recorded as payload, so that the items still cover
+  // the whole packet when it is trimmed or fragmented later
+  if (end > 0)
+    {
+      DoAddTrailer (0, end);
+    }
+  NS_ASSERT (IsStateOk ());
 }
 void 
 PacketMetadata::RemoveAtStart (uint32_t start)
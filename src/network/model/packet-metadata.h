@@ -160,6 +160,13 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable the sharing of the packet metadata between threads
+   *
+   * The items are then never added in place to metadata shared by
+   * several packets, because these packets may be in other threads.
+   */
+  static void EnableMultithreading (void);
 
   /**
    * \brief Constructor
@@ -412,7 +419,7 @@ private:
    * Data structure
    */
   struct Data {
-    /** number of references to this struct Data instance. */
+    /** number of references to this struct Data instance (updated atomically). */
     uint32_t m_count;
     /** size (in bytes) of m_data buffer below */
     uint16_t m_size;
@@ -620,6 +627,12 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add a trailer
+   * \param uid trailer's uid to add
+   * \param size trailer serialized size
+   */
+  void DoAddTrailer (uint32_t uid, uint32_t size);
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -637,6 +650,12 @@ public:
    * \returns true if the position is valid
    */
   bool IsSharedPointerOk (uint16_t pointer) const;
+  /**
+   * \brief Check if the items can not be added in place
+   * \returns true if the data is shared with other metadata which may
+   *          have used the space after m_used
+   */
+  bool IsDirty (void) const;
 
   /**
    * \brief Recycle the buffer memory
@@ -661,9 +680,11 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  static thread_local DataFreeList m_freeList; //!< the metadata data storage, one per thread
+  static thread_local bool m_freeListDestroyed; //!< Whether m_freeList was destroyed (thread exit)
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_enableMultithreading; //!< Enable the sharing of the metadata between threads
 
   /**
    * Set to true when adding metadata to a packet is skipped because
@@ -672,7 +693,7 @@ public:
    */
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
+  static thread_local uint32_t m_maxSize; //!< maximum metadata size
   static uint16_t m_chunkUid; //!< Chunk Uid
 
   struct Data *m_data; //!< Metadata storage
@@ -713,7 +734,7 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
 {
   NS_ASSERT (m_data != 0);
   NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  __atomic_add_fetch (&m_data->m_count, 1, __ATOMIC_RELAXED);
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -722,14 +743,13 @@ PacketMetadata::operator = (PacketMetadata const& o)
     {
       // not self assignment
       NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (__atomic_sub_fetch (&m_data->m_count, 1, __ATOMIC_ACQ_REL) == 0)
         {
           PacketMetadata::Recycle (m_data);
         }
       m_data = o.m_data;
       NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      __atomic_add_fetch (&m_data->m_count, 1, __ATOMIC_RELAXED);
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -740,8 +760,7 @@ PacketMetadata::operator = (PacketMetadata const& o)
 PacketMetadata::~PacketMetadata ()
 {
   NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (__atomic_sub_fetch (&m_data->m_count, 1, __ATOMIC_ACQ_REL) == 0)
     {
       PacketMetadata::Recycle (m_data);
     }
@@ -44,7 +44,7 @@ PacketTagList::CreateTagData (size_t dataSize)
                  << std::numeric_limits<decltype(TagData::size)>::max () );
 
   void * p = std::malloc (sizeof (TagData) + dataSize - 1);
-  // The matching frees are in RemoveAll and RemoveWriter
+  // The matching frees are in ReleaseTagData and RemoveWriter
 
   TagData * tag = new (p) TagData;
   tag->size = dataSize;
@@ -73,7 +73,7 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
   // Search from the head of the list until we find tid or a merge
   while (cur != 0)
     {
-      if (cur->count > 1)
+      if (__atomic_load_n (&cur->count, __ATOMIC_ACQUIRE) > 1)
         {
           // found merge
           NS_LOG_INFO ("found initial merge before tid");
@@ -120,7 +120,6 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 
   // At this point cur is a merge, but untested for tid
   NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
 
   /*
      Walk the remainder of the list, copying, until we find tid
@@ -141,6 +140,13 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
                                                 pNext   cur
 
      When we reach tid, we link past it, decrement count, and we're done.
+
+     The other lists sharing the tail may belong to copies of the packet
+     in other threads, which can release their references at any time:
+     a node is only read while we hold a reference to it, the reference
+     to the next node is taken before the one to cur is released, and
+     if our release happens to be the last one, we free cur (a merge may
+     thus stop being one while we walk past it).
   */
 
   // Should normally check for null cur pointer,
@@ -148,23 +154,21 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
   while ( /* cur && */ cur->tid != tid)
     {
       NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
       struct TagData * copy = CreateTagData (cur->size);
       copy->tid = cur->tid;
       copy->count = 1;
       copy->size = cur->size;
       memcpy (copy->data, cur->data, copy->size);
       copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
+      __atomic_add_fetch (&copy->next->count, 1, __ATOMIC_RELAXED); // mark new merge
       *prevNext = copy;                   // point prior list at copy
       prevNext = &copy->next;             // advance
+      ReleaseTagData (cur);               // unmerge cur
       cur      =  copy->next;
     }
   // Sanity check:
   NS_ASSERT (cur != 0);                 // cur should be non-zero
   NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
 
   // link around tid, removing it from our list
   found = (this->*Writer)(tag, false, cur, prevNext);
@@ -199,14 +203,14 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
     }
   else
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
+      // cur is a merge (unless its other references were released
+      // meanwhile): make its next a merge, then unmerge cur, since we
+      // linked around it already
       if (cur->next != 0)
         {
-          // there's a next, so make it a merge
-          cur->next->count++;
+          __atomic_add_fetch (&cur->next->count, 1, __ATOMIC_RELAXED);
         }
+      ReleaseTagData (cur);
     }
   return found;
 }
@@ -239,9 +243,8 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
     }
   else
     {
-      // cur is always a merge at this point
+      // cur is a merge at this point (see RemoveWriter)
       // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
       struct TagData * copy = CreateTagData (tag.GetSerializedSize ());
       copy->tid = tag.GetInstanceTypeId ();
       copy->count = 1;
@@ -249,9 +252,10 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
       copy->next = cur->next;           // merge into tail
       if (copy->next != 0)
         {
-          copy->next->count++;          // mark new merge
+          __atomic_add_fetch (&copy->next->count, 1, __ATOMIC_RELAXED); // mark new merge
         }
       *prevNext = copy;                 // point prior list at copy
+      ReleaseTagData (cur);             // unmerge cur
     }
   return found;
 }
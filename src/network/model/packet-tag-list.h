@@ -141,7 +141,7 @@ public:
   struct TagData
   {
     struct TagData * next;      /**< Pointer to next in list */
-    uint32_t count;             /**< Number of incoming links */
+    uint32_t count;             /**< Number of incoming links (updated atomically) */
     TypeId tid;                 /**< Type of the tag serialized into #data */
     uint32_t size;              /**< Size of the \c data buffer */
     uint8_t data[1];            /**< Serialization buffer */
@@ -228,6 +228,18 @@ private:
    */
   static
   TagData * CreateTagData (size_t dataSize);
+  /**
+   * Release a reference to a TagData, freeing it if it was the last
+   * one, and then the TagData it links to in turn.
+   *
+   * The lists of several threads may share a tail: whichever drops the
+   * last reference to a TagData frees it, so the caller must not use
+   * \pname{data} afterwards.
+   *
+   * \param [in] data The TagData.
+   */
+  static inline
+  void ReleaseTagData (struct TagData *data);
   
   /**
    * Typedef of method function pointer for copy-on-write operations
@@ -302,7 +314,7 @@ PacketTagList::PacketTagList (PacketTagList const &o)
 {
   if (m_next != 0)
     {
-      m_next->count++;
+      __atomic_add_fetch (&m_next->count, 1, __ATOMIC_RELAXED);
     }
 }
 
@@ -318,7 +330,7 @@ PacketTagList::operator = (PacketTagList const &o)
   m_next = o.m_next;
   if (m_next != 0) 
     {
-      m_next->count++;
+      __atomic_add_fetch (&m_next->count, 1, __ATOMIC_RELAXED);
     }
   return *this;
 }
@@ -329,28 +341,26 @@ PacketTagList::~PacketTagList ()
 }
 
 void
-PacketTagList::RemoveAll (void)
+PacketTagList::ReleaseTagData (struct TagData *data)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  while (data != 0)
     {
-      cur->count--;
-      if (cur->count > 0) 
+      if (__atomic_sub_fetch (&data->count, 1, __ATOMIC_ACQ_REL) > 0)
         {
           break;
         }
-      if (prev != 0) 
-        {
-          prev->~TagData ();
-          std::free (prev);
-        }
-      prev = cur;
-    }
-  if (prev != 0) 
-    {
-      prev->~TagData ();
-      std::free (prev);
+      // this was the last reference, so data->next can still be read
+      struct TagData *next = data->next;
+      data->~TagData ();
+      std::free (data);
+      data = next;
     }
+}
+
+void
+PacketTagList::RemoveAll (void)
+{
+  ReleaseTagData (m_next);
   m_next = 0;
 }
 
@@ -731,7 +731,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static uint32_t m_globalUid; //!< Global counter of packets Uid (updated atomically)
 };
 
 /**
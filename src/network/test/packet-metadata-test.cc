@@ -586,6 +586,14 @@ PacketMetadataTest::DoRun (void)
   p->RemoveAtStart (8+10+8);
   CHECK_HISTORY (p, 1, 8);
 
+  // the padding is part of the history, so that it can be removed
+  p = Create<Packet> (10);
+  ADD_TRAILER (p, 8);
+  p->AddPaddingAtEnd (5);
+  CHECK_HISTORY (p, 3, 10, 8, 5);
+  p->RemoveAtStart (10+8+2);
+  CHECK_HISTORY (p, 1, 3);
+
   p = Create<Packet> (10);
   ADD_HEADER (p, 10);
   ADD_HEADER (p, 8);
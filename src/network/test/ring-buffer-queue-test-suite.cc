@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ring-buffer-queue.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * RingBufferQueue unit tests.
+ */
+class RingBufferQueueTestCase : public TestCase
+{
+public:
+  RingBufferQueueTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferQueueTestCase::RingBufferQueueTestCase ()
+  : TestCase ("Sanity check on the ring buffer queue implementation")
+{
+}
+void
+RingBufferQueueTestCase::DoRun (void)
+{
+  Ptr<RingBufferQueue<Packet> > queue = CreateObject<RingBufferQueue<Packet> > ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxPackets", UintegerValue (3)), true,
+                         "Verify that we can actually set the attribute");
+
+  Ptr<Packet> p[8];
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      p[i] = Create<Packet> (100 + i);
+    }
+
+  NS_TEST_EXPECT_MSG_EQ ((queue->Peek () == 0), true, "There should be no packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p[0]), true, "The first packet should be enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p[1]), true, "The second packet should be enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p[2]), true, "The third packet should be enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p[3]), false, "The fourth packet should be dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 3, "There should be three packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 303, "Wrong number of bytes in the queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCapacity (), 4, "The capacity should be the maximum number of packets rounded up to a power of 2");
+  NS_TEST_EXPECT_MSG_EQ (queue->Peek ()->GetUid (), p[0]->GetUid (), "The first packet should be at the head");
+
+  // wrap around the end of the ring buffer several times
+  for (uint32_t i = 3; i < 8; i++)
+    {
+      Ptr<Packet> packet = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (packet->GetUid (), p[i - 3]->GetUid (), "Packets should be dequeued in FIFO order");
+      NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p[i]), true, "There should be room for a packet");
+      NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 3, "There should be three packets in there");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCapacity (), 4, "The ring buffer should not grow in packet mode");
+
+  Ptr<Packet> packet = queue->Remove ();
+  NS_TEST_EXPECT_MSG_EQ (packet->GetUid (), p[5]->GetUid (), "The head packet should be removed");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPacketsAfterDequeue (), 1, "The removed packet should be counted as dropped");
+  queue->Dequeue ();
+  queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((queue->Dequeue () == 0), true, "There are really no packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 0, "There should be no bytes in there");
+
+  // in byte mode, the ring buffer grows while preserving the order of the packets
+  queue = CreateObject<RingBufferQueue<Packet> > ();
+  queue->SetAttribute ("Mode", EnumValue (QueueBase::QUEUE_MODE_BYTES));
+  queue->SetAttribute ("MaxBytes", UintegerValue (100000));
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<Packet> (i + 1)), true, "There should be room for a packet");
+      if (i % 3 == 0)
+        {
+          queue->Dequeue ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 133, "Wrong number of packets in the queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCapacity (), 256, "The ring buffer should have grown to 256 items");
+  uint32_t expected = 68;
+  while (!queue->IsEmpty ())
+    {
+      NS_TEST_EXPECT_MSG_EQ (queue->Dequeue ()->GetSize (), expected++, "Packets should be dequeued in FIFO order");
+    }
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief RingBuffer Queue TestSuite
+ */
+class RingBufferQueueTestSuite : public TestSuite
+{
+public:
+  RingBufferQueueTestSuite ()
+    : TestSuite ("ring-buffer-queue", UNIT)
+  {
+    AddTestCase (new RingBufferQueueTestCase (), TestCase::QUICK);
+  }
+};
+
+static RingBufferQueueTestSuite g_ringBufferQueueTestSuite; //!< Static variable for test initialization
@@ -77,7 +77,11 @@ QueueDiscItem::QueueDiscItem (Ptr<Packet> p, const Address& addr, uint16_t proto
   : QueueItem (p),
     m_address (addr),
     m_protocol (protocol),
-    m_txq (0)
+    m_txq (0),
+    m_tstamp (Seconds (0)),
+    m_hashValid (false),
+    m_hashPerturbation (0),
+    m_hash (0)
 {
   NS_LOG_FUNCTION (this << p << addr << protocol);
 }
@@ -115,6 +119,20 @@ QueueDiscItem::SetTxQueueIndex (uint8_t txq)
   m_txq = txq;
 }
 
+Time
+QueueDiscItem::GetTimeStamp (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_tstamp;
+}
+
+void
+QueueDiscItem::SetTimeStamp (Time t)
+{
+  NS_LOG_FUNCTION (this << t);
+  m_tstamp = t;
+}
+
 void
 QueueDiscItem::Print (std::ostream& os) const
 {
@@ -131,4 +149,23 @@ QueueDiscItem::IsL4S (void)
   return false;
 }
 
+uint32_t
+QueueDiscItem::Hash (uint32_t perturbation) const
+{
+  if (!m_hashValid || m_hashPerturbation != perturbation)
+    {
+      m_hash = DoHash (perturbation);
+      m_hashPerturbation = perturbation;
+      m_hashValid = true;
+    }
+  return m_hash;
+}
+
+uint32_t
+QueueDiscItem::DoHash (uint32_t perturbation) const
+{
+  NS_LOG_FUNCTION (this << perturbation);
+  return 0;
+}
+
 } // namespace ns3
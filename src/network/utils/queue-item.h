@@ -23,6 +23,7 @@
 #include "ns3/ptr.h"
 #include "ns3/simple-ref-count.h"
 #include <ns3/address.h>
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
@@ -180,6 +181,21 @@ public:
    */
   void SetTxQueueIndex (uint8_t txq);
 
+  /**
+   * \brief Get the time at which the item was enqueued in the queue disc
+   * \return the time at which the item was enqueued in the queue disc.
+   */
+  Time GetTimeStamp (void) const;
+
+  /**
+   * \brief Set the time at which the item was enqueued in the queue disc
+   * \param t the time at which the item was enqueued in the queue disc.
+   *
+   * This method is called by QueueDisc::Enqueue, so that queue discs can
+   * compute the sojourn time of an item without tagging its packet.
+   */
+  void SetTimeStamp (Time t);
+
   /**
    * \brief Add the header to the packet
    *
@@ -209,7 +225,32 @@ public:
    */
   virtual bool IsL4S (void);
 
+  /**
+   * \brief Get the hash of the 5-tuple of the packet
+   *
+   * The hash is computed by DoHash the first time it is requested with a
+   * given perturbation and cached in the item, so that the queue discs and
+   * the packet filters handling the item do not parse the packet again.
+   *
+   * \param perturbation the salt used as an additional input to the hash function
+   * \return the hash of the 5-tuple of the packet (0 if the item does not know
+   *         how to compute it)
+   */
+  uint32_t Hash (uint32_t perturbation = 0) const;
+
 private:
+  /**
+   * \brief Compute the hash of the 5-tuple of the packet
+   *
+   * Subclasses storing packets of a network protocol providing a 5-tuple
+   * (e.g., IPv4 and IPv6) redefine this method. The default implementation
+   * returns 0.
+   *
+   * \param perturbation the salt used as an additional input to the hash function
+   * \return the hash of the 5-tuple of the packet
+   */
+  virtual uint32_t DoHash (uint32_t perturbation) const;
+
   /**
    * \brief Default constructor
    *
@@ -233,6 +274,10 @@ private:
   Address m_address;      //!< MAC destination address
   uint16_t m_protocol;    //!< L3 Protocol number
   uint8_t m_txq;          //!< Transmission queue index
+  Time m_tstamp;          //!< Time at which the item was enqueued in the queue disc
+  mutable bool m_hashValid;              //!< True if m_hash has been computed
+  mutable uint32_t m_hashPerturbation;   //!< Perturbation used to compute m_hash
+  mutable uint32_t m_hash;               //!< Cached hash of the 5-tuple of the packet
 };
 
 } // namespace ns3
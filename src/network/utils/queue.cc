@@ -272,4 +272,10 @@ QueueBase::DoNsLog (const enum LogLevel level, std::string str) const
     NS_LOG (level, str);
 }
 
+bool
+QueueBase::IsNsLogEnabled (const enum LogLevel level) const
+{
+  return g_log.IsEnabled (level);
+}
+
 } // namespace ns3
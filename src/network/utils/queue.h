@@ -238,6 +238,14 @@ protected:
    */
   void DoNsLog (const enum LogLevel level, std::string str) const;
 
+  /**
+   * \brief Check whether the messages of the given level are logged
+   *
+   * \param level the log level
+   * \return true if the messages of the given level are logged
+   */
+  bool IsNsLogEnabled (const enum LogLevel level) const;
+
 private:
   TracedValue<uint32_t> m_nBytes;               //!< Number of bytes in the queue
   uint32_t m_nTotalReceivedBytes;               //!< Total received bytes
@@ -395,6 +403,34 @@ protected:
    */
   Ptr<const Item> DoPeek (ConstIterator pos) const;
 
+  /**
+   * \brief Check whether an item fits in the queue, dropping it otherwise
+   * \param item the item to enqueue
+   * \return true if the item can be stored, false if it has been dropped.
+   *
+   * Subclasses that do not store the items in the list of this class call
+   * this method, then NotifyEnqueue once the item has been stored.
+   */
+  bool CheckEnqueue (Ptr<Item> item);
+
+  /**
+   * \brief Update the counters and fire the trace source after an item is stored
+   * \param item the enqueued item
+   */
+  void NotifyEnqueue (Ptr<Item> item);
+
+  /**
+   * \brief Update the counters and fire the trace source after an item is dequeued
+   * \param item the dequeued item
+   */
+  void NotifyDequeue (Ptr<Item> item);
+
+  /**
+   * \brief Update the counters and drop an item after it has been removed
+   * \param item the removed item
+   */
+  void NotifyRemove (Ptr<Item> item);
+
   /**
    * \brief Drop a packet before enqueue
    * \param item item that was dropped
@@ -431,12 +467,24 @@ private:
 };
 
 
-#define QUEUE_LOG(level,params)              \
-  {                                          \
-    std::stringstream ss;                    \
-    ss << params;                            \
-    QueueBase::DoNsLog (level, ss.str ());   \
+/**
+ * Log a message through the log component of QueueBase. The message is only
+ * built if it is going to be logged, so that the enqueue, dequeue and drop
+ * paths do not allocate a string stream per call when logging is disabled.
+ */
+#ifdef NS3_LOG_ENABLE
+#define QUEUE_LOG(level,params)                     \
+  {                                                 \
+    if (QueueBase::IsNsLogEnabled (level))          \
+      {                                             \
+        std::stringstream ss;                       \
+        ss << params;                               \
+        QueueBase::DoNsLog (level, ss.str ());      \
+      }                                             \
   }
+#else
+#define QUEUE_LOG(level,params)
+#endif
 
 
 /**
@@ -486,6 +534,22 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
 {
   QUEUE_LOG (LOG_LOGIC, "Queue:DoEnqueue(" << this << ", " << item << ")");
 
+  if (!CheckEnqueue (item))
+    {
+      return false;
+    }
+
+  m_packets.insert (pos, item);
+
+  NotifyEnqueue (item);
+
+  return true;
+}
+
+template <typename Item>
+bool
+Queue<Item>::CheckEnqueue (Ptr<Item> item)
+{
   if (m_mode == QUEUE_MODE_PACKETS && (m_nPackets.Get () >= m_maxPackets))
     {
       QUEUE_LOG (LOG_LOGIC, "Queue full (at max packets) -- dropping pkt");
@@ -500,8 +564,13 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
       return false;
     }
 
-  m_packets.insert (pos, item);
+  return true;
+}
 
+template <typename Item>
+void
+Queue<Item>::NotifyEnqueue (Ptr<Item> item)
+{
   uint32_t size = item->GetSize ();
   m_nBytes += size;
   m_nTotalReceivedBytes += size;
@@ -511,8 +580,33 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
 
   QUEUE_LOG (LOG_LOGIC, "m_traceEnqueue (p)");
   m_traceEnqueue (item);
+}
 
-  return true;
+template <typename Item>
+void
+Queue<Item>::NotifyDequeue (Ptr<Item> item)
+{
+  NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
+  NS_ASSERT (m_nPackets.Get () > 0);
+
+  m_nBytes -= item->GetSize ();
+  m_nPackets--;
+
+  QUEUE_LOG (LOG_LOGIC, "m_traceDequeue (p)");
+  m_traceDequeue (item);
+}
+
+template <typename Item>
+void
+Queue<Item>::NotifyRemove (Ptr<Item> item)
+{
+  NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
+  NS_ASSERT (m_nPackets.Get () > 0);
+
+  m_nBytes -= item->GetSize ();
+  m_nPackets--;
+
+  DropAfterDequeue (item);
 }
 
 template <typename Item>
@@ -532,14 +626,7 @@ Queue<Item>::DoDequeue (ConstIterator pos)
 
   if (item != 0)
     {
-      NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
-
-      m_nBytes -= item->GetSize ();
-      m_nPackets--;
-
-      QUEUE_LOG (LOG_LOGIC, "m_traceDequeue (p)");
-      m_traceDequeue (item);
+      NotifyDequeue (item);
     }
   return item;
 }
@@ -561,13 +648,7 @@ Queue<Item>::DoRemove (ConstIterator pos)
 
   if (item != 0)
     {
-      NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
-
-      m_nBytes -= item->GetSize ();
-      m_nPackets--;
-
-      DropAfterDequeue (item);
+      NotifyRemove (item);
     }
   return item;
 }
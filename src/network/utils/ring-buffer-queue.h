@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RING_BUFFER_QUEUE_H
+#define RING_BUFFER_QUEUE_H
+
+#include "ns3/queue.h"
+#include <vector>
+#include <algorithm>
+
+namespace ns3 {
+
+/**
+ * \ingroup queue
+ *
+ * \brief A FIFO packet queue that drops tail-end packets on overflow and
+ * stores the items in a ring buffer
+ *
+ * The items are stored in a contiguous array rather than in a list, hence
+ * enqueue, dequeue and peek are O(1) and do not allocate memory. In packet
+ * mode, the array is sized once, on the first enqueue, to the maximum number
+ * of packets. In byte mode, the number of items is not known in advance and
+ * the array is doubled when full.
+ */
+template <typename Item>
+class RingBufferQueue : public Queue<Item>
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief RingBufferQueue Constructor
+   */
+  RingBufferQueue ();
+
+  virtual ~RingBufferQueue ();
+
+  virtual bool Enqueue (Ptr<Item> item);
+  virtual Ptr<Item> Dequeue (void);
+  virtual Ptr<Item> Remove (void);
+  virtual Ptr<const Item> Peek (void) const;
+
+  /**
+   * \return the number of items the ring buffer can store before growing
+   */
+  uint32_t GetCapacity (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Allocate the ring buffer or double its size, preserving the items
+   */
+  void Grow (void);
+
+  /**
+   * \brief Extract the item at the head of the ring buffer
+   * \return the item
+   */
+  Ptr<Item> Pop (void);
+
+  using Queue<Item>::CheckEnqueue;
+  using Queue<Item>::NotifyEnqueue;
+  using Queue<Item>::NotifyDequeue;
+  using Queue<Item>::NotifyRemove;
+
+  std::vector<Ptr<Item> > m_ring; //!< the items, the size is a power of 2
+  uint32_t m_mask;                //!< size of the ring buffer minus 1
+  uint32_t m_head;                //!< index of the first item
+  uint32_t m_count;               //!< number of items in the ring buffer
+};
+
+
+/**
+ * Implementation of the templates declared above.
+ */
+
+template <typename Item>
+TypeId
+RingBufferQueue<Item>::GetTypeId (void)
+{
+  static TypeId tid = TypeId (("ns3::RingBufferQueue<" + GetTypeParamName<RingBufferQueue<Item> > () + ">").c_str ())
+    .SetParent<Queue<Item> > ()
+    .SetGroupName ("Network")
+    .template AddConstructor<RingBufferQueue<Item> > ()
+  ;
+  return tid;
+}
+
+template <typename Item>
+RingBufferQueue<Item>::RingBufferQueue () :
+  Queue<Item> (),
+  m_mask (0),
+  m_head (0),
+  m_count (0)
+{
+  QUEUE_LOG (LOG_LOGIC, "RingBufferQueue(" << this << ")");
+}
+
+template <typename Item>
+RingBufferQueue<Item>::~RingBufferQueue ()
+{
+  QUEUE_LOG (LOG_LOGIC, "~RingBufferQueue(" << this << ")");
+}
+
+template <typename Item>
+void
+RingBufferQueue<Item>::DoDispose (void)
+{
+  m_ring.clear ();
+  m_mask = m_head = m_count = 0;
+  Queue<Item>::DoDispose ();
+}
+
+template <typename Item>
+uint32_t
+RingBufferQueue<Item>::GetCapacity (void) const
+{
+  return m_ring.size ();
+}
+
+template <typename Item>
+void
+RingBufferQueue<Item>::Grow (void)
+{
+  uint32_t size;
+  if (!m_ring.empty ())
+    {
+      size = 2 * m_ring.size ();
+    }
+  else if (this->GetMode () == QueueBase::QUEUE_MODE_PACKETS)
+    {
+      size = std::max (this->GetMaxPackets (), 1u);
+    }
+  else
+    {
+      size = 64;
+    }
+  // round up to a power of 2
+  uint32_t capacity = 1;
+  while (capacity < size)
+    {
+      capacity <<= 1;
+    }
+
+  QUEUE_LOG (LOG_LOGIC, "RingBufferQueue:Grow(" << this << ", " << capacity << ")");
+
+  std::vector<Ptr<Item> > ring (capacity);
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      ring[i] = m_ring[(m_head + i) & m_mask];
+    }
+  m_ring.swap (ring);
+  m_mask = capacity - 1;
+  m_head = 0;
+}
+
+template <typename Item>
+bool
+RingBufferQueue<Item>::Enqueue (Ptr<Item> item)
+{
+  QUEUE_LOG (LOG_LOGIC, "RingBufferQueue:Enqueue(" << this << ", " << item << ")");
+
+  if (!CheckEnqueue (item))
+    {
+      return false;
+    }
+
+  if (m_count == m_ring.size ())
+    {
+      Grow ();
+    }
+
+  m_ring[(m_head + m_count) & m_mask] = item;
+  m_count++;
+
+  NotifyEnqueue (item);
+
+  return true;
+}
+
+template <typename Item>
+Ptr<Item>
+RingBufferQueue<Item>::Pop (void)
+{
+  Ptr<Item> item = m_ring[m_head];
+  m_ring[m_head] = 0;
+  m_head = (m_head + 1) & m_mask;
+  m_count--;
+  return item;
+}
+
+template <typename Item>
+Ptr<Item>
+RingBufferQueue<Item>::Dequeue (void)
+{
+  QUEUE_LOG (LOG_LOGIC, "RingBufferQueue:Dequeue(" << this << ")");
+
+  if (m_count == 0)
+    {
+      QUEUE_LOG (LOG_LOGIC, "Queue empty");
+      return 0;
+    }
+
+  Ptr<Item> item = Pop ();
+  NotifyDequeue (item);
+
+  QUEUE_LOG (LOG_LOGIC, "Popped " << item);
+
+  return item;
+}
+
+template <typename Item>
+Ptr<Item>
+RingBufferQueue<Item>::Remove (void)
+{
+  QUEUE_LOG (LOG_LOGIC, "RingBufferQueue:Remove(" << this << ")");
+
+  if (m_count == 0)
+    {
+      QUEUE_LOG (LOG_LOGIC, "Queue empty");
+      return 0;
+    }
+
+  Ptr<Item> item = Pop ();
+  NotifyRemove (item);
+
+  QUEUE_LOG (LOG_LOGIC, "Removed " << item);
+
+  return item;
+}
+
+template <typename Item>
+Ptr<const Item>
+RingBufferQueue<Item>::Peek (void) const
+{
+  QUEUE_LOG (LOG_LOGIC, "RingBufferQueue:Peek(" << this << ")");
+
+  if (m_count == 0)
+    {
+      QUEUE_LOG (LOG_LOGIC, "Queue empty");
+      return 0;
+    }
+
+  return m_ring[m_head];
+}
+
+} // namespace ns3
+
+#endif /* RING_BUFFER_QUEUE_H */
@@ -21,6 +21,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -57,7 +58,8 @@ PointToPointChannel::PointToPointChannel()
   :
     Channel (),
     m_delay (Seconds (0.)),
-    m_nDevices (0)
+    m_nDevices (0),
+    m_multithreaded (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -80,6 +82,15 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+      for (uint32_t i = 0; i < N_DEVICES; i++)
+        {
+          if (m_link[i].m_dst->GetNode () != 0)
+            {
+              m_link[i].m_dstNode = m_link[i].m_dst->GetNode ()->GetId ();
+            }
+        }
+      // checked once here, while the simulation is set up by one thread
+      m_multithreaded = IsMultithreaded ();
     }
 }
 
@@ -97,15 +108,47 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
-                                  txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+  uint32_t dstNode = m_link[wire].m_dstNode;
+  if (dstNode == Simulator::NO_CONTEXT)
+    {
+      dstNode = m_link[wire].m_dst->GetNode ()->GetId ();
+    }
+  if (m_multithreaded)
+    {
+      // The receiving device and its node may be used by another thread,
+      // so their reference counts must not be touched here: the event
+      // holds a plain pointer to the device, which lives as long as the
+      // simulation. Likewise, the sending device keeps a reference to the
+      // packet until the end of the transmission, so the receiver gets
+      // its own copy (which shares the packet data).
+      Simulator::ScheduleWithContext (dstNode,
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      PeekPointer (m_link[wire].m_dst), p->Copy ());
+    }
+  else
+    {
+      Simulator::ScheduleWithContext (dstNode,
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      m_link[wire].m_dst, p);
+    }
 
   // Call the tx anim callback on the net device
-  m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+  if (!m_txrxPointToPoint.IsEmpty ())
+    {
+      m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+    }
   return true;
 }
 
+bool
+PointToPointChannel::IsMultithreaded (void)
+{
+  // the TypeId is only registered if the mtp module is linked in
+  TypeId multithreaded;
+  return TypeId::LookupByNameFailSafe ("ns3::MultithreadedSimulatorImpl", &multithreaded)
+         && Simulator::GetImplementation ()->GetInstanceTypeId () == multithreaded;
+}
+
 uint32_t 
 PointToPointChannel::GetNDevices (void) const
 {
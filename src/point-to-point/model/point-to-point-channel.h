@@ -25,6 +25,7 @@
 #include "ns3/nstime.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/simulator.h"
 
 namespace ns3 {
 
@@ -146,11 +147,17 @@ protected:
      Time duration, Time lastBitTime);
                     
 private:
+  /**
+   * \returns true if the simulator runs the nodes on several threads
+   */
+  static bool IsMultithreaded (void);
+
   /** Each point to point link has exactly two net devices. */
   static const int N_DEVICES = 2;
 
   Time          m_delay;    //!< Propagation delay
   int32_t       m_nDevices; //!< Devices of this channel
+  bool          m_multithreaded; //!< Whether the simulator ran the nodes on several threads when the link was set up
 
   /**
    * The trace source for the packet transmission animation events that the 
@@ -194,11 +201,12 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0), m_dstNode (Simulator::NO_CONTEXT) {}
 
-    WireState                  m_state; //!< State of the link
-    Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
-    Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    WireState                  m_state;   //!< State of the link
+    Ptr<PointToPointNetDevice> m_src;     //!< First NetDevice
+    Ptr<PointToPointNetDevice> m_dst;     //!< Second NetDevice
+    uint32_t                   m_dstNode; //!< Id of the node of m_dst, if known when the link was set up
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
@@ -26,6 +26,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-item.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -559,6 +560,49 @@ PointToPointNetDevice::Send (
       return false;
     }
 
+  return EnqueueAndTransmit (packet, protocolNumber);
+}
+
+uint32_t
+PointToPointNetDevice::SendBurst (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  bool linkUp = IsLinkUp ();
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+    {
+      txq = m_queueInterface->GetTxQueue (0);
+    }
+
+  uint32_t sent = 0;
+  for (; sent < items.size (); sent++)
+    {
+      //
+      // Stop as soon as the device queue is full, the caller requeues the
+      // remaining packets
+      //
+      if (txq && txq->IsStopped ())
+        {
+          break;
+        }
+
+      Ptr<Packet> packet = items[sent]->GetPacket ();
+      if (linkUp == false)
+        {
+          m_macTxDropTrace (packet);
+          continue;
+        }
+      EnqueueAndTransmit (packet, items[sent]->GetProtocol ());
+    }
+  return sent;
+}
+
+bool
+PointToPointNetDevice::EnqueueAndTransmit (Ptr<Packet> packet, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << protocolNumber);
+
   //
   // Stick a point to point protocol header on the packet in preparation for
   // shoving it out the door.
@@ -177,6 +177,7 @@ public:
   virtual bool IsBridge (void) const;
 
   virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
+  virtual uint32_t SendBurst (const std::vector<Ptr<QueueDiscItem> > &items);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
 
   virtual Ptr<Node> GetNode (void) const;
@@ -271,6 +272,16 @@ private:
    */
   bool TransmitStart (Ptr<Packet> p);
 
+  /**
+   * Add the PPP header to a packet, enqueue it in the device queue and start
+   * its transmission if the device is idle. The link must be up.
+   *
+   * \param packet the packet to send
+   * \param protocolNumber the protocol number of the packet
+   * \returns true if successful, false otherwise (drop, ...)
+   */
+  bool EnqueueAndTransmit (Ptr<Packet> packet, uint16_t protocolNumber);
+
   /**
    * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
    *
@@ -24,6 +24,8 @@
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-item.h"
+#include "ns3/uinteger.h"
 
 using namespace ns3;
 
@@ -101,6 +103,142 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Queue disc item used to test the SendBurst method
+ */
+class PointToPointTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param p the packet stored in this item
+   * \param addr the destination address
+   */
+  PointToPointTestItem (Ptr<Packet> p, const Address &addr)
+    : QueueDiscItem (p, addr, 0x800)
+  {
+  }
+  virtual void AddHeader (void)
+  {
+  }
+  virtual bool Mark (void)
+  {
+    return false;
+  }
+};
+
+/**
+ * \brief Test class for the SendBurst method of PointToPointNetDevice
+ *
+ * It sends a burst of packets larger than the device queue and checks that
+ * the device only consumes the packets it can store before its transmission
+ * queue is stopped.
+ */
+class PointToPointBurstTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointBurstTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a burst of packets to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param n the number of packets in the burst
+   */
+  void SendBurst (Ptr<PointToPointNetDevice> device, uint32_t n);
+
+  /**
+   * \brief Receive callback
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  uint32_t m_sent;      //!< Number of packets consumed by the device
+  uint32_t m_received;  //!< Number of packets received
+};
+
+PointToPointBurstTest::PointToPointBurstTest ()
+  : TestCase ("PointToPoint SendBurst"),
+    m_sent (0),
+    m_received (0)
+{
+}
+
+void
+PointToPointBurstTest::SendBurst (Ptr<PointToPointNetDevice> device, uint32_t n)
+{
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      items.push_back (Create<PointToPointTestItem> (Create<Packet> (100), device->GetBroadcast ()));
+    }
+  m_sent = device->SendBurst (items);
+
+  Ptr<NetDeviceQueueInterface> ndqi = device->GetObject<NetDeviceQueueInterface> ();
+  NS_TEST_EXPECT_MSG_EQ (ndqi->GetTxQueue (0)->IsStopped (), true, "The device queue must be stopped");
+}
+
+bool
+PointToPointBurstTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+PointToPointBurstTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObjectWithAttributes<DropTailQueue<Packet> > ("MaxPackets", UintegerValue (3)));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  // the node sets its own receive callback when the device is added
+  devB->SetReceiveCallback (MakeCallback (&PointToPointBurstTest::Receive, this));
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+  Ptr<NetDeviceQueueInterface> ifaceB = CreateObject<NetDeviceQueueInterface> ();
+  devB->AggregateObject (ifaceB);
+  ifaceB->CreateTxQueues ();
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointBurstTest::SendBurst, this, devA, 8);
+
+  Simulator::Run ();
+
+  // one packet is transmitted right away and three are stored in the device queue
+  NS_TEST_EXPECT_MSG_EQ (m_sent, 4, "The device must consume 4 packets of the burst");
+  NS_TEST_EXPECT_MSG_EQ (m_received, 4, "All the packets consumed by the device must be received");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -117,6 +255,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBurstTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -485,6 +485,89 @@ FqCoDelQueueDiscUDPFlowsSeparation::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * This class tests the flows separation based on the hash of the 5-tuple
+ * computed by the queue disc items, i.e., without packet filters
+ */
+class FqCoDelQueueDiscNoFilterFlowsSeparation : public TestCase
+{
+public:
+  FqCoDelQueueDiscNoFilterFlowsSeparation ();
+  virtual ~FqCoDelQueueDiscNoFilterFlowsSeparation ();
+
+private:
+  virtual void DoRun (void);
+  Ptr<Ipv4QueueDiscItem> CreateItem (Ipv4Header ipHdr, UdpHeader udpHdr);
+};
+
+FqCoDelQueueDiscNoFilterFlowsSeparation::FqCoDelQueueDiscNoFilterFlowsSeparation ()
+  : TestCase ("Test flows separation without packet filters")
+{
+}
+
+FqCoDelQueueDiscNoFilterFlowsSeparation::~FqCoDelQueueDiscNoFilterFlowsSeparation ()
+{
+}
+
+Ptr<Ipv4QueueDiscItem>
+FqCoDelQueueDiscNoFilterFlowsSeparation::CreateItem (Ipv4Header ipHdr, UdpHeader udpHdr)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (udpHdr);
+  Address dest;
+  return Create<Ipv4QueueDiscItem> (p, dest, 0, ipHdr);
+}
+
+void
+FqCoDelQueueDiscNoFilterFlowsSeparation::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> queueDisc = CreateObjectWithAttributes<FqCoDelQueueDisc> ("PacketLimit", UintegerValue (10),
+                                                                                  "Perturbation", UintegerValue (256));
+  queueDisc->SetQuantum (1500);
+  queueDisc->Initialize ();
+
+  Ipv4Header hdr;
+  hdr.SetPayloadSize (100);
+  hdr.SetSource (Ipv4Address ("10.10.1.1"));
+  hdr.SetDestination (Ipv4Address ("10.10.1.2"));
+  hdr.SetProtocol (17);
+
+  UdpHeader udpHdr;
+  udpHdr.SetSourcePort (7);
+  udpHdr.SetDestinationPort (27);
+
+  // The hash computed by the item is the one computed by the packet filter
+  Ptr<FqCoDelIpv4PacketFilter> filter = CreateObjectWithAttributes<FqCoDelIpv4PacketFilter> ("Perturbation", UintegerValue (256));
+  Ptr<Ipv4QueueDiscItem> item = CreateItem (hdr, udpHdr);
+  uint32_t hash = item->Hash (256);
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (filter->Classify (item)), hash, "the item and the filter computed different hashes");
+  NS_TEST_ASSERT_MSG_NE (item->Hash (0), hash, "the perturbation has not been used");
+  NS_TEST_ASSERT_MSG_EQ (item->Hash (256), hash, "the hash is not stable");
+
+  // Add two packets from the first flow
+  queueDisc->Enqueue (item);
+  queueDisc->Enqueue (CreateItem (hdr, udpHdr));
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 2, "unexpected number of packets in the queue disc");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 1, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the first flow queue");
+
+  // Add a packet from the second flow
+  udpHdr.SetSourcePort (8);
+  queueDisc->Enqueue (CreateItem (hdr, udpHdr));
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 3, "unexpected number of packets in the queue disc");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 2, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
+
+  // Add a packet from the third flow
+  hdr.SetDestination (Ipv4Address ("10.10.1.7"));
+  queueDisc->Enqueue (CreateItem (hdr, udpHdr));
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 4, "unexpected number of packets in the queue disc");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 3, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (2)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the third flow queue");
+
+  Simulator::Destroy ();
+}
+
 class FqCoDelQueueDiscTestSuite : public TestSuite
 {
 public:
@@ -499,6 +582,7 @@ FqCoDelQueueDiscTestSuite::FqCoDelQueueDiscTestSuite ()
   AddTestCase (new FqCoDelQueueDiscDeficit, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscTCPFlowsSeparation, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscUDPFlowsSeparation, TestCase::QUICK);
+  AddTestCase (new FqCoDelQueueDiscNoFilterFlowsSeparation, TestCase::QUICK);
 }
 
 static FqCoDelQueueDiscTestSuite fqCoDelQueueDiscTestSuite;
@@ -0,0 +1,210 @@
+#! /usr/bin/env python
+# -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+"""
+Run an ns-3 program over a grid of command line values and merge the results.
+
+Every combination of the --grid values is run once, as a separate process,
+on a pool of --jobs workers (all the cores by default). The program is passed
+--<name>=<value> for each grid parameter and --resultsFile=<file>, and must
+write a CSV header and one or more CSV rows to that file (as done by
+dual-q-coupled-curvy-red-example). The rows of all the runs are appended, as
+soon as each run completes, to a single results file whose first columns are
+the grid parameters. The results file doubles as the checkpoint: when the
+sweep is restarted, the combinations already in the file are skipped, hence
+an interrupted sweep resumes where it stopped and a failed run is retried.
+
+Example (run from the top-level directory, after ./waf build):
+
+  ./src/traffic-control/examples/aqm-sweep.py \\
+      --program dual-q-coupled-curvy-red-example \\
+      --grid curviness=1,2,4 --grid k0=1,2 --grid queueLimit=100,500 \\
+      --grid bottleneckRate=10Mbps,100Mbps --grid RngRun=1:10 \\
+      --fixed stopTime=30 --results curvy-red-sweep.csv
+
+A value range a:b stands for the integers from a to b included. RngRun, like
+any other global value, is accepted on the command line of every ns-3 program.
+"""
+
+from __future__ import print_function
+
+import csv
+import glob
+import itertools
+import multiprocessing
+import optparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+
+def read_build_dir():
+    """Return the build directory of the last waf configure."""
+    for lock in glob.glob(".lock-waf_*_build"):
+        for line in open(lock, "rt"):
+            if line.startswith("out_dir ="):
+                return eval(line.split("=", 1)[1].strip())
+    sys.exit("No waf lock file found: run this script from the top-level "
+             "directory of a configured ns-3 tree")
+
+
+def find_program(build_dir, program):
+    """Return the path of the executable of a program built by waf."""
+    patterns = ["src/*/examples/ns3*-%s-*", "examples/*/ns3*-%s-*", "scratch/ns3*-%s-*"]
+    for pattern in patterns:
+        for path in glob.glob(os.path.join(build_dir, pattern % program)):
+            if os.access(path, os.X_OK) and not path.endswith(".o"):
+                return path
+    sys.exit("Cannot find the executable of %s in %s: has it been built?" % (program, build_dir))
+
+
+def parse_grid(specs):
+    """Parse name=v1,v2,... or name=a:b specifications into (name, values) pairs."""
+    grid = []
+    for spec in specs:
+        if "=" not in spec:
+            sys.exit("Invalid grid parameter %s, expected name=v1,v2,... or name=a:b" % spec)
+        name, values = spec.split("=", 1)
+        if ":" in values and "," not in values:
+            first, last = values.split(":", 1)
+            values = [str(v) for v in range(int(first), int(last) + 1)]
+        else:
+            values = values.split(",")
+        grid.append((name, values))
+    return grid
+
+
+def run_one(task):
+    """Run the program for one combination of the grid (in a worker process)."""
+    binary, env, fixed, params = task
+    workdir = tempfile.mkdtemp(prefix="aqm-sweep-")
+    results = os.path.join(workdir, "results.csv")
+    argv = [binary] + ["--%s=%s" % p for p in fixed + params] + ["--resultsFile=%s" % results]
+    try:
+        with open(os.path.join(workdir, "output.txt"), "w") as output:
+            status = subprocess.call(argv, cwd=workdir, env=env, stdout=output, stderr=subprocess.STDOUT)
+        if status != 0:
+            with open(os.path.join(workdir, "output.txt")) as output:
+                tail = output.readlines()[-5:]
+            return params, None, None, "exit status %d: %s" % (status, "".join(tail).strip())
+        if not os.path.exists(results):
+            return params, None, None, "no results file written"
+        with open(results) as f:
+            rows = list(csv.reader(f))
+        if len(rows) < 2:
+            return params, None, None, "empty results file"
+        return params, rows[0], rows[1:], None
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+
+def main(argv):
+    parser = optparse.OptionParser(usage="%prog [options]", description=__doc__.split("\n\n")[1])
+    parser.add_option("--program", default="dual-q-coupled-curvy-red-example",
+                      help="name of the ns-3 program to run [%default]")
+    parser.add_option("--grid", action="append", default=[], metavar="NAME=VALUES",
+                      help="command line parameter and its values, e.g. curviness=1,2,4 or RngRun=1:10 "
+                      "(repeat for every parameter)")
+    parser.add_option("--fixed", action="append", default=[], metavar="NAME=VALUE",
+                      help="command line parameter passed unchanged to every run")
+    parser.add_option("--results", default="aqm-sweep.csv",
+                      help="merged results file, also used to resume an interrupted sweep [%default]")
+    parser.add_option("--jobs", type="int", default=multiprocessing.cpu_count(),
+                      help="number of runs executed in parallel [%default]")
+    options, args = parser.parse_args(argv)
+
+    grid = parse_grid(options.grid)
+    if not grid:
+        parser.error("at least one --grid parameter is needed")
+    names = [name for name, values in grid]
+    fixed = []
+    for spec in options.fixed:
+        name, value = spec.split("=", 1)
+        fixed.append((name, value))
+
+    build_dir = read_build_dir()
+    binary = find_program(build_dir, options.program)
+    env = dict(os.environ)
+    for var in ("LD_LIBRARY_PATH", "DYLD_LIBRARY_PATH"):
+        env[var] = build_dir + (":" + env[var] if env.get(var) else "")
+
+    # the combinations already in the results file are not run again
+    header = None
+    done = set()
+    if os.path.exists(options.results) and os.path.getsize(options.results) > 0:
+        with open(options.results) as f:
+            reader = csv.reader(f)
+            header = next(reader)
+            if header[:len(names)] != names:
+                sys.exit("The columns of %s do not match the grid parameters %s" % (options.results, names))
+            for row in reader:
+                done.add(tuple(row[:len(names)]))
+
+    combinations = list(itertools.product(*[values for name, values in grid]))
+    total = len(combinations)
+    combinations = [c for c in combinations if tuple(c) not in done]
+    print("%d runs, %d already done, %d workers" % (total, total - len(combinations), options.jobs))
+    if not combinations:
+        return 0
+
+    tasks = [(binary, env, fixed, list(zip(names, c))) for c in combinations]
+    pool = multiprocessing.Pool(options.jobs)
+    failed = 0
+    completed = total - len(combinations)
+    try:
+        with open(options.results, "a") as out:
+            writer = csv.writer(out)
+            for params, columns, rows, error in pool.imap_unordered(run_one, tasks):
+                completed += 1
+                label = " ".join("%s=%s" % p for p in params)
+                if error is not None:
+                    failed += 1
+                    print("[%d/%d] FAIL %s: %s" % (completed, total, label, error))
+                    continue
+                if header is None:
+                    header = names + columns
+                    writer.writerow(header)
+                elif header[len(names):] != columns:
+                    sys.exit("The columns written by %s do not match the results file" % label)
+                values = [v for n, v in params]
+                for row in rows:
+                    writer.writerow(values + row)
+                # flush after every run, so that the file is a valid checkpoint
+                out.flush()
+                os.fsync(out.fileno())
+                print("[%d/%d] done %s" % (completed, total, label))
+        pool.close()
+    except KeyboardInterrupt:
+        pool.terminate()
+        pool.join()
+        print("Interrupted: rerun the same command to resume the sweep")
+        return 1
+    except BaseException:
+        pool.terminate()
+        pool.join()
+        raise
+    pool.join()
+
+    if failed:
+        print("%d runs failed: rerun the same command to retry them" % failed)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
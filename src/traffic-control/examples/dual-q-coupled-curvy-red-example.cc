@@ -30,12 +30,18 @@
  *    10Mb/s, 0ms  |  QueueLimit = 100  |    10Mb/s, 0ms
  * n1--------------|                    |---------------n5
  *
+ * n0 sends Classic (NewReno) traffic to n4 and n1 sends L4S (DCTCP) traffic
+ * to n5. The Curvy RED parameters, the bottleneck link and the duration can
+ * be set from the command line, and --resultsFile writes the flow monitor
+ * statistics of the two flows and the queue disc statistics as a CSV header
+ * and a CSV row, so that the example can be driven by aqm-sweep.py.
  */
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/flow-monitor-helper.h"
+#include "ns3/ipv4-flow-classifier.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/traffic-control-module.h"
@@ -90,6 +96,70 @@ CheckQueueDiscSize (Ptr<QueueDisc> queue)
   fPlotQueueDiscAvg.close ();
 }
 
+/**
+ * Statistics of the flows sent by a node, as collected by the flow monitor
+ */
+struct FlowResults
+{
+  FlowResults () : rxBytes (0), rxPackets (0), lostPackets (0), duration (0), delaySum (0) {}
+  uint64_t rxBytes;       //!< Bytes received
+  uint64_t rxPackets;     //!< Packets received
+  uint64_t lostPackets;   //!< Packets lost
+  Time duration;          //!< Time between the first transmission and the last reception
+  Time delaySum;          //!< Sum of the end-to-end delays of the received packets
+};
+
+FlowResults
+GetFlowResults (Ptr<FlowMonitor> flowmon, Ptr<Ipv4FlowClassifier> classifier, Ipv4Address source)
+{
+  FlowResults results;
+  FlowMonitor::FlowStatsContainer stats = flowmon->GetFlowStats ();
+  for (FlowMonitor::FlowStatsContainer::const_iterator it = stats.begin (); it != stats.end (); it++)
+    {
+      if (classifier->FindFlow (it->first).sourceAddress != source)
+        {
+          continue;
+        }
+      results.rxBytes += it->second.rxBytes;
+      results.rxPackets += it->second.rxPackets;
+      results.lostPackets += it->second.lostPackets;
+      results.duration = std::max (results.duration, it->second.timeLastRxPacket - it->second.timeFirstTxPacket);
+      results.delaySum += it->second.delaySum;
+    }
+  return results;
+}
+
+void
+WriteResults (std::string fileName, Ptr<FlowMonitor> flowmon, Ptr<Ipv4FlowClassifier> classifier,
+              const DualQCoupledCurvyRedQueueDisc::Stats &st)
+{
+  std::ofstream out (fileName.c_str (), std::ios::out);
+  NS_ABORT_MSG_UNLESS (out.is_open (), "Cannot open file " << fileName);
+
+  out << "classic_throughput_mbps,classic_mean_delay_ms,classic_lost_packets,"
+      << "l4s_throughput_mbps,l4s_mean_delay_ms,l4s_lost_packets,"
+      << "unforced_classic_drop,unforced_classic_mark,unforced_l4s_mark,forced_drop,"
+      << "classic_mean_sojourn_ms,classic_p99_sojourn_ms,classic_p999_sojourn_ms,"
+      << "l4s_mean_sojourn_ms,l4s_p99_sojourn_ms,l4s_p999_sojourn_ms" << std::endl;
+
+  // Classic traffic is sent by n0, L4S traffic by n1
+  FlowResults flows[2] = { GetFlowResults (flowmon, classifier, i0i2.GetAddress (0)),
+                           GetFlowResults (flowmon, classifier, i1i2.GetAddress (0)) };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      double seconds = flows[i].duration.GetSeconds ();
+      out << (seconds > 0 ? flows[i].rxBytes * 8 / seconds / 1e6 : 0) << ","
+          << (flows[i].rxPackets > 0 ? flows[i].delaySum.GetSeconds () * 1e3 / flows[i].rxPackets : 0) << ","
+          << flows[i].lostPackets << ",";
+    }
+  out << st.unforcedClassicDrop << "," << st.unforcedClassicMark << ","
+      << st.unforcedL4SMark << "," << st.forcedDrop << ","
+      << (st.dequeuedClassicPackets > 0 ? st.totalClassicSojourn.GetSeconds () * 1e3 / st.dequeuedClassicPackets : 0) << ","
+      << st.p99ClassicSojourn.GetSeconds () * 1e3 << "," << st.p999ClassicSojourn.GetSeconds () * 1e3 << ","
+      << (st.dequeuedL4SPackets > 0 ? st.totalL4SSojourn.GetSeconds () * 1e3 / st.dequeuedL4SPackets : 0) << ","
+      << st.p99L4SSojourn.GetSeconds () * 1e3 << "," << st.p999L4SSojourn.GetSeconds () * 1e3 << std::endl;
+}
+
 void
 BuildAppsTest ()
 {
@@ -166,13 +236,14 @@ main (int argc, char *argv[])
   bool flowMonitor = false;
 
   bool printDualQCoupledCurvyRedStats = true;
+  std::string resultsFile;
+
+  uint32_t curviness = 1;
+  uint32_t k0 = 1;
+  uint32_t queueLimit = 100;
 
   global_start_time = 0.0;
-  sink_start_time = global_start_time;
-  client_start_time = global_start_time + 1.5;
   global_stop_time = 20.0;
-  sink_stop_time = global_stop_time + 3.0;
-  client_stop_time = global_stop_time - 2.0;
 
   // Configuration and command line parameter parsing
   // Will only save in the directory if enable opts below
@@ -182,9 +253,21 @@ main (int argc, char *argv[])
   cmd.AddValue ("writeForPlot", "<0/1> to write results for plot (gnuplot)", writeForPlot);
   cmd.AddValue ("writePcap", "<0/1> to write results in pcapfile", writePcap);
   cmd.AddValue ("writeFlowMonitor", "<0/1> to enable Flow Monitor and write their results", flowMonitor);
+  cmd.AddValue ("resultsFile", "File to write the flow and queue disc statistics to, as CSV", resultsFile);
+  cmd.AddValue ("curviness", "Curviness of the Curvy RED queue disc", curviness);
+  cmd.AddValue ("k0", "K0 of the Curvy RED queue disc", k0);
+  cmd.AddValue ("queueLimit", "Queue limit of the Curvy RED queue disc (packets)", queueLimit);
+  cmd.AddValue ("bottleneckRate", "Data rate of the bottleneck link", dualQCoupledCurvyRedLinkDataRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the bottleneck link", dualQCoupledCurvyRedLinkDelay);
+  cmd.AddValue ("stopTime", "Time the clients stop sending, plus 2 seconds (s)", global_stop_time);
 
   cmd.Parse (argc, argv);
 
+  sink_start_time = global_start_time;
+  client_start_time = global_start_time + 1.5;
+  sink_stop_time = global_stop_time + 3.0;
+  client_stop_time = global_stop_time - 2.0;
+
   NS_LOG_INFO ("Create nodes");
   NodeContainer c;
   c.Create (6);
@@ -210,7 +293,11 @@ main (int argc, char *argv[])
   NS_LOG_INFO ("Set DualQCoupledCurvyRed params");
   Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::Mode", StringValue ("QUEUE_DISC_MODE_PACKETS"));
   Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::L4SQueueSizeThreshold", UintegerValue (5*1500));
-  Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::QueueLimit", UintegerValue (100));
+  Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::QueueLimit", UintegerValue (queueLimit));
+  Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::Curviness", UintegerValue (curviness));
+  Config::SetDefault ("ns3::DualQCoupledCurvyRedQueueDisc::K0", UintegerValue (k0));
+  // the sojourn time percentiles are reported in the results file
+  Config::SetDefault ("ns3::QueueDisc::SojournHistogram", BooleanValue (!resultsFile.empty ()));
 
   NS_LOG_INFO ("Install internet stack on all nodes.");
   InternetStackHelper internet;
@@ -298,9 +385,9 @@ main (int argc, char *argv[])
     }
 
   Ptr<FlowMonitor> flowmon;
-  if (flowMonitor)
+  FlowMonitorHelper flowmonHelper;
+  if (flowMonitor || !resultsFile.empty ())
     {
-      FlowMonitorHelper flowmonHelper;
       flowmon = flowmonHelper.InstallAll ();
     }
 
@@ -328,6 +415,11 @@ main (int argc, char *argv[])
       flowmon->SerializeToXmlFile (stmp.str ().c_str (), false, false);
     }
 
+  if (!resultsFile.empty ())
+    {
+      WriteResults (resultsFile, flowmon, DynamicCast<Ipv4FlowClassifier> (flowmonHelper.GetClassifier ()), st);
+    }
+
   if (printDualQCoupledCurvyRedStats)
     {
       std::cout << "*** DualQCoupledCurvyRed stats from Node 2 queue ***" << std::endl;
@@ -0,0 +1,529 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Microbenchmark measuring the per-packet cost of a queue disc.
+ *
+ * Synthetic Ipv4QueueDiscItems (UDP, configurable ECN codepoint mix and
+ * number of flows) are enqueued into a queue disc of any TypeId, without
+ * any network stack or device. Arrivals follow a CBR, Poisson or bursty
+ * pattern, and packets are dequeued at a constant service rate, so that
+ * the sojourn times seen by the AQM are realistic. Only the Enqueue and
+ * Dequeue calls are timed: building the items and running the scheduler
+ * is not accounted for.
+ *
+ * Latencies are stored in arrays preallocated before the run and sorted
+ * once at the end to compute the percentiles, so that the bookkeeping
+ * does not pollute the caches while the queue disc runs. The number of
+ * heap allocations performed inside the Enqueue and Dequeue calls is
+ * counted by replacing the global operator new.
+ *
+ * Queue disc attributes can be set from the command line, e.g.:
+ *
+ *   ./waf --run "queue-disc-benchmark --queueDisc=ns3::DualQCoupledCurvyRedQueueDisc
+ *                --ect1=0.5 --arrival=burst --ns3::DualQCoupledCurvyRedQueueDisc::QueueLimit=100"
+ *
+ * The --csv option prints a single line suitable to track regressions.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+#include <time.h>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/traffic-control-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QueueDiscBenchmark");
+
+/// Number of calls to the global operator new
+static uint64_t g_allocations = 0;
+
+void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  void *p = std::malloc (size ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+/**
+ * \return a monotonic timestamp in nanoseconds
+ */
+static inline uint64_t
+GetNanoSeconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Latency and allocation samples of one operation (enqueue or dequeue)
+class OpSamples
+{
+public:
+  OpSamples ()
+    : m_allocations (0)
+  {
+  }
+
+  /**
+   * Preallocate the sample array
+   * \param n the maximum number of samples
+   */
+  void Reserve (uint32_t n)
+  {
+    m_ns.reserve (n);
+  }
+
+  /**
+   * Record a sample
+   * \param ns the duration of the operation
+   * \param allocations the number of allocations performed by the operation
+   */
+  void Add (uint64_t ns, uint64_t allocations)
+  {
+    m_ns.push_back (static_cast<uint32_t> (std::min<uint64_t> (ns, UINT32_MAX)));
+    m_allocations += allocations;
+  }
+
+  /**
+   * Subtract the timer overhead from all the samples and sort them
+   * \param overhead the timer overhead
+   */
+  void Finalize (uint32_t overhead)
+  {
+    for (std::vector<uint32_t>::iterator it = m_ns.begin (); it != m_ns.end (); it++)
+      {
+        *it = (*it > overhead ? *it - overhead : 0);
+      }
+    std::sort (m_ns.begin (), m_ns.end ());
+  }
+
+  /// \return the number of samples
+  uint32_t GetCount (void) const
+  {
+    return m_ns.size ();
+  }
+
+  /// \return the sum of the samples
+  double GetTotal (void) const
+  {
+    double total = 0;
+    for (std::vector<uint32_t>::const_iterator it = m_ns.begin (); it != m_ns.end (); it++)
+      {
+        total += *it;
+      }
+    return total;
+  }
+
+  /// \return the mean of the samples
+  double GetMean (void) const
+  {
+    return m_ns.empty () ? 0 : GetTotal () / m_ns.size ();
+  }
+
+  /**
+   * \param q the quantile, in [0,1]
+   * \return the given quantile of the (sorted) samples
+   */
+  uint32_t GetQuantile (double q) const
+  {
+    if (m_ns.empty ())
+      {
+        return 0;
+      }
+    uint32_t idx = static_cast<uint32_t> (q * (m_ns.size () - 1) + 0.5);
+    return m_ns[idx];
+  }
+
+  /// \return the number of allocations per operation
+  double GetAllocationsPerOp (void) const
+  {
+    return m_ns.empty () ? 0 : static_cast<double> (m_allocations) / m_ns.size ();
+  }
+
+  /// \return the total number of allocations
+  uint64_t GetAllocations (void) const
+  {
+    return m_allocations;
+  }
+
+private:
+  std::vector<uint32_t> m_ns;   //!< latency samples (ns)
+  uint64_t m_allocations;       //!< total number of allocations
+};
+
+/// Queue disc benchmark
+class QueueDiscBench
+{
+public:
+  QueueDiscBench ();
+
+  /// Run the benchmark
+  void Run (void);
+  /// Print the results
+  void Report (std::ostream &os) const;
+  /// Print the results on a single CSV line
+  void ReportCsv (std::ostream &os) const;
+
+  std::string m_typeId;     //!< TypeId of the queue disc
+  std::string m_arrival;    //!< arrival pattern (cbr, poisson, burst)
+  uint32_t m_packets;       //!< number of measured packets
+  uint32_t m_warmup;        //!< number of packets enqueued before measuring
+  uint32_t m_pktSize;       //!< size of the IP packets
+  double m_ect1;            //!< fraction of ECT(1) packets
+  double m_ect0;            //!< fraction of ECT(0) packets
+  uint32_t m_flows;         //!< number of UDP flows
+  double m_serviceRate;     //!< dequeue rate (packets/s)
+  double m_load;            //!< arrival rate over service rate
+  uint32_t m_burst;         //!< packets per burst for the burst pattern
+
+private:
+  /// Build the next item to enqueue
+  Ptr<Ipv4QueueDiscItem> CreateItem (void);
+  /// Enqueue one packet (or one burst) and schedule the next arrival
+  void Arrival (void);
+  /// Dequeue one packet and schedule the next departure
+  void Departure (void);
+  /// Measure the overhead of reading the clock
+  uint32_t CalibrateTimer (void) const;
+
+  Ptr<QueueDisc> m_qdisc;                      //!< the queue disc under test
+  Ptr<UniformRandomVariable> m_uv;             //!< ECN and flow selection
+  Ptr<ExponentialRandomVariable> m_interval;   //!< Poisson interarrival times
+  Ipv4Address m_src;                           //!< source address
+  Ipv4Address m_dst;                           //!< destination address
+  uint32_t m_arrived;                          //!< number of enqueued packets
+  uint64_t m_marked;                           //!< CE packets dequeued while measuring
+  uint64_t m_dequeued;                         //!< packets dequeued while measuring
+  uint32_t m_droppedAtStart;                   //!< drops when the measure started
+  uint32_t m_timerOverhead;                    //!< timer overhead (ns)
+  uint64_t m_wallNs;                           //!< wall clock duration of the run (ns)
+  OpSamples m_enqueue;                         //!< enqueue samples
+  OpSamples m_dequeue;                         //!< dequeue samples
+};
+
+QueueDiscBench::QueueDiscBench ()
+  : m_typeId ("ns3::RedQueueDisc"),
+    m_arrival ("poisson"),
+    m_packets (200000),
+    m_warmup (10000),
+    m_pktSize (1000),
+    m_ect1 (0.5),
+    m_ect0 (0.0),
+    m_flows (16),
+    m_serviceRate (100000),
+    m_load (1.05),
+    m_burst (16),
+    m_src ("10.1.1.1"),
+    m_dst ("10.1.2.1"),
+    m_arrived (0),
+    m_marked (0),
+    m_dequeued (0),
+    m_droppedAtStart (0),
+    m_timerOverhead (0),
+    m_wallNs (0)
+{
+}
+
+uint32_t
+QueueDiscBench::CalibrateTimer (void) const
+{
+  std::vector<uint32_t> samples (10000);
+  for (uint32_t i = 0; i < samples.size (); i++)
+    {
+      uint64_t start = GetNanoSeconds ();
+      samples[i] = GetNanoSeconds () - start;
+    }
+  std::nth_element (samples.begin (), samples.begin () + samples.size () / 2, samples.end ());
+  return samples[samples.size () / 2];
+}
+
+Ptr<Ipv4QueueDiscItem>
+QueueDiscBench::CreateItem (void)
+{
+  const uint32_t headers = 28;   // IPv4 and UDP headers
+  Ptr<Packet> p = Create<Packet> (m_pktSize > headers ? m_pktSize - headers : 0);
+  UdpHeader udp;
+  udp.SetSourcePort (1024 + m_uv->GetInteger (0, m_flows - 1));
+  udp.SetDestinationPort (9);
+  p->AddHeader (udp);
+
+  Ipv4Header hdr;
+  hdr.SetSource (m_src);
+  hdr.SetDestination (m_dst);
+  hdr.SetProtocol (17);
+  hdr.SetPayloadSize (p->GetSize ());
+  hdr.SetTtl (64);
+  double u = m_uv->GetValue ();
+  if (u < m_ect1)
+    {
+      hdr.SetEcn (Ipv4Header::ECN_ECT1);
+    }
+  else if (u < m_ect1 + m_ect0)
+    {
+      hdr.SetEcn (Ipv4Header::ECN_ECT0);
+    }
+  else
+    {
+      hdr.SetEcn (Ipv4Header::ECN_NotECT);
+    }
+  return Create<Ipv4QueueDiscItem> (p, Address (), Ipv4L3Protocol::PROT_NUMBER, hdr);
+}
+
+void
+QueueDiscBench::Arrival (void)
+{
+  uint32_t total = m_warmup + m_packets;
+  uint32_t n = (m_arrival == "burst" ? m_burst : 1);
+
+  for (uint32_t i = 0; i < n && m_arrived < total; i++)
+    {
+      if (m_arrived == m_warmup)
+        {
+          m_droppedAtStart = m_qdisc->GetTotalDroppedPackets ();
+        }
+      Ptr<Ipv4QueueDiscItem> item = CreateItem ();
+      bool measure = (m_arrived++ >= m_warmup);
+
+      uint64_t allocs = g_allocations;
+      uint64_t start = GetNanoSeconds ();
+      m_qdisc->Enqueue (item);
+      uint64_t end = GetNanoSeconds ();
+      allocs = g_allocations - allocs;
+
+      if (measure)
+        {
+          m_enqueue.Add (end - start, allocs);
+        }
+    }
+
+  if (m_arrived < total)
+    {
+      double rate = m_load * m_serviceRate;
+      double delay;
+      if (m_arrival == "poisson")
+        {
+          delay = m_interval->GetValue ();
+        }
+      else
+        {
+          delay = n / rate;
+        }
+      Simulator::Schedule (Seconds (delay), &QueueDiscBench::Arrival, this);
+    }
+}
+
+void
+QueueDiscBench::Departure (void)
+{
+  if (m_qdisc->GetNPackets () > 0)
+    {
+      bool measure = (m_arrived > m_warmup);
+
+      uint64_t allocs = g_allocations;
+      uint64_t start = GetNanoSeconds ();
+      Ptr<QueueDiscItem> item = m_qdisc->Dequeue ();
+      uint64_t end = GetNanoSeconds ();
+      allocs = g_allocations - allocs;
+
+      if (measure && item != 0)
+        {
+          m_dequeue.Add (end - start, allocs);
+          m_dequeued++;
+          Ptr<Ipv4QueueDiscItem> ipv4Item = DynamicCast<Ipv4QueueDiscItem> (item);
+          if (ipv4Item && ipv4Item->GetHeader ().GetEcn () == Ipv4Header::ECN_CE)
+            {
+              m_marked++;
+            }
+        }
+    }
+  else if (m_arrived == m_warmup + m_packets)
+    {
+      // all the packets have been served
+      Simulator::Stop ();
+      return;
+    }
+
+  Simulator::Schedule (Seconds (1.0 / m_serviceRate), &QueueDiscBench::Departure, this);
+}
+
+void
+QueueDiscBench::Run (void)
+{
+  NS_ABORT_MSG_IF (m_arrival != "cbr" && m_arrival != "poisson" && m_arrival != "burst",
+                   "Unknown arrival pattern " << m_arrival);
+  NS_ABORT_MSG_IF (m_flows == 0 || m_burst == 0, "At least one flow and one packet per burst");
+  NS_ABORT_MSG_IF (m_serviceRate <= 0 || m_load <= 0, "Service rate and load must be positive");
+
+  ObjectFactory factory;
+  factory.SetTypeId (m_typeId);
+  m_qdisc = factory.Create<QueueDisc> ();
+  NS_ABORT_MSG_IF (m_qdisc == 0, m_typeId << " is not a queue disc");
+
+  // FqCoDel needs a quantum, as it has no device; packets are classified
+  // by the hash of the 5-tuple cached in the items
+  Ptr<FqCoDelQueueDisc> fqCoDel = DynamicCast<FqCoDelQueueDisc> (m_qdisc);
+  if (fqCoDel)
+    {
+      fqCoDel->SetQuantum (m_pktSize);
+    }
+  m_qdisc->Initialize ();
+
+  m_uv = CreateObject<UniformRandomVariable> ();
+  m_interval = CreateObject<ExponentialRandomVariable> ();
+  m_interval->SetAttribute ("Mean", DoubleValue (1.0 / (m_load * m_serviceRate)));
+
+  m_enqueue.Reserve (m_packets);
+  m_dequeue.Reserve (m_packets);
+  m_timerOverhead = CalibrateTimer ();
+
+  Simulator::ScheduleNow (&QueueDiscBench::Arrival, this);
+  Simulator::Schedule (Seconds (1.0 / m_serviceRate), &QueueDiscBench::Departure, this);
+
+  uint64_t start = GetNanoSeconds ();
+  Simulator::Run ();
+  m_wallNs = GetNanoSeconds () - start;
+
+  m_enqueue.Finalize (m_timerOverhead);
+  m_dequeue.Finalize (m_timerOverhead);
+}
+
+void
+QueueDiscBench::Report (std::ostream &os) const
+{
+  uint32_t dropped = m_qdisc->GetTotalDroppedPackets () - m_droppedAtStart;
+  double perPacketNs = (m_enqueue.GetTotal () + m_dequeue.GetTotal ()) / m_packets;
+  double perPacketAllocs = static_cast<double> (m_enqueue.GetAllocations () + m_dequeue.GetAllocations ()) / m_packets;
+
+  os << "Queue disc:      " << m_typeId << std::endl
+     << "Arrivals:        " << m_arrival << ", load " << m_load
+     << ", service rate " << m_serviceRate << " pkt/s";
+  if (m_arrival == "burst")
+    {
+      os << ", " << m_burst << " pkt bursts";
+    }
+  os << std::endl
+     << "Traffic:         " << m_packets << " packets (+" << m_warmup << " warmup), "
+     << m_pktSize << " bytes, " << m_flows << " flows, ECT(1) " << m_ect1
+     << ", ECT(0) " << m_ect0 << std::endl
+     << "Outcome:         " << m_dequeued << " dequeued, " << m_marked << " CE marked, "
+     << dropped << " dropped" << std::endl
+     << "Timer overhead:  " << m_timerOverhead << " ns (subtracted)" << std::endl
+     << "Wall clock:      " << m_wallNs / 1e6 << " ms" << std::endl
+     << std::endl;
+
+  os << std::left << std::setw (10) << "op" << std::right
+     << std::setw (10) << "calls" << std::setw (10) << "ns/op"
+     << std::setw (8) << "p50" << std::setw (8) << "p90" << std::setw (8) << "p99"
+     << std::setw (8) << "p99.9" << std::setw (10) << "max" << std::setw (12) << "allocs/op"
+     << std::endl;
+
+  const OpSamples *samples[2] = { &m_enqueue, &m_dequeue };
+  const char *names[2] = { "enqueue", "dequeue" };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      const OpSamples &s = *samples[i];
+      os << std::left << std::setw (10) << names[i] << std::right
+         << std::setw (10) << s.GetCount ()
+         << std::setw (10) << std::fixed << std::setprecision (1) << s.GetMean ()
+         << std::setw (8) << s.GetQuantile (0.5) << std::setw (8) << s.GetQuantile (0.9)
+         << std::setw (8) << s.GetQuantile (0.99) << std::setw (8) << s.GetQuantile (0.999)
+         << std::setw (10) << s.GetQuantile (1.0)
+         << std::setw (12) << std::setprecision (2) << s.GetAllocationsPerOp ()
+         << std::endl;
+    }
+  os << std::endl
+     << "Per packet:      " << std::setprecision (1) << perPacketNs << " ns, "
+     << std::setprecision (2) << perPacketAllocs << " allocations" << std::endl;
+}
+
+void
+QueueDiscBench::ReportCsv (std::ostream &os) const
+{
+  uint32_t dropped = m_qdisc->GetTotalDroppedPackets () - m_droppedAtStart;
+  os << m_typeId << "," << m_arrival << "," << m_load << "," << m_ect1 << "," << m_ect0
+     << "," << m_flows << "," << m_packets << "," << m_dequeued << "," << m_marked
+     << "," << dropped;
+  const OpSamples *samples[2] = { &m_enqueue, &m_dequeue };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      const OpSamples &s = *samples[i];
+      os << "," << s.GetMean () << "," << s.GetQuantile (0.5) << "," << s.GetQuantile (0.99)
+         << "," << s.GetQuantile (0.999) << "," << s.GetAllocationsPerOp ();
+    }
+  os << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  QueueDiscBench bench;
+  bool csv = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("queueDisc", "TypeId of the queue disc under test", bench.m_typeId);
+  cmd.AddValue ("arrival", "Arrival pattern: cbr, poisson or burst", bench.m_arrival);
+  cmd.AddValue ("packets", "Number of measured packets", bench.m_packets);
+  cmd.AddValue ("warmup", "Number of packets enqueued before measuring", bench.m_warmup);
+  cmd.AddValue ("pktSize", "Size of the IP packets (bytes)", bench.m_pktSize);
+  cmd.AddValue ("ect1", "Fraction of ECT(1) packets", bench.m_ect1);
+  cmd.AddValue ("ect0", "Fraction of ECT(0) packets", bench.m_ect0);
+  cmd.AddValue ("flows", "Number of UDP flows", bench.m_flows);
+  cmd.AddValue ("serviceRate", "Dequeue rate (packets/s)", bench.m_serviceRate);
+  cmd.AddValue ("load", "Ratio of the arrival rate to the service rate", bench.m_load);
+  cmd.AddValue ("burst", "Packets per burst for the burst arrival pattern", bench.m_burst);
+  cmd.AddValue ("csv", "Print the results on a single CSV line", csv);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (bench.m_ect1 < 0 || bench.m_ect0 < 0 || bench.m_ect1 + bench.m_ect0 > 1,
+                   "Invalid ECN mix");
+
+  bench.Run ();
+
+  if (csv)
+    {
+      bench.ReportCsv (std::cout);
+    }
+  else
+    {
+      bench.Report (std::cout);
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
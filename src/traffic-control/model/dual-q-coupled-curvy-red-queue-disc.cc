@@ -22,6 +22,7 @@
  */
 
 #include "math.h"
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
@@ -30,98 +31,179 @@
 #include "ns3/abort.h"
 #include "ns3/object-factory.h"
 #include "ns3/string.h"
+#include "ns3/pointer.h"
 #include "dual-q-coupled-curvy-red-queue-disc.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/net-device-queue-interface.h"
-#define max(a,b)  (a > b) ? a : b
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("DualQCoupledCurvyRedQueueDisc");
 
-class DualQCoupledCurvyRedTimestampTag : public Tag
-{
-public:
-  DualQCoupledCurvyRedTimestampTag ();
-  /**
-   * \brief Get the type ID.
-   *
-   * \return the object TypeId
-   */
-  static TypeId GetTypeId (void);
-  virtual TypeId GetInstanceTypeId (void) const;
+/**
+ * Smallest Q32 conversion factor accepted in fixed point mode: with 16
+ * significant bits, the factor is rounded by less than 2^-17 relatively.
+ */
+static const uint64_t MIN_PROB_SCALE_Q32 = UINT64_C (1) << 16;
 
-  virtual uint32_t GetSerializedSize (void) const;
-  virtual void Serialize (TagBuffer i) const;
-  virtual void Deserialize (TagBuffer i);
-  virtual void Print (std::ostream &os) const;
+/**
+ * Convert a queuing time in ns into a Q32 probability
+ * \param ns the queuing time in ns
+ * \param scaleQ32 the Q32 conversion factor
+ * \return the probability in Q32 format, saturated to 2^32
+ */
+static inline uint64_t
+QueuingTimeToProbQ32 (int64_t ns, uint64_t scaleQ32)
+{
+  if (ns <= 0)
+    {
+      return 0;
+    }
+  // the product overflows exactly when the probability reaches 1
+  if (scaleQ32 != 0 && (uint64_t) ns > UINT64_MAX / scaleQ32)
+    {
+      return (UINT64_C (1) << 32);
+    }
+  return ((uint64_t) ns * scaleQ32) >> 32;
+}
 
-  /**
-   * \brief Gets the Tag creation time
-   *
-   * \return the time object stored in the tag
-   */
-  Time GetTxTime (void) const;
+/**
+ * Compute the Q32 factor converting a queuing time in ns into a Q32
+ * probability equal to the queuing time in seconds divided by 2^scalingFactor
+ * \param scalingFactor the scaling factor
+ * \return the Q32 conversion factor, or 0 if it does not fit in 64 bits
+ */
+static uint64_t
+ProbScaleQ32 (double scalingFactor)
+{
+  double scale = ldexp (1.0, 64) / (1e9 * pow (2, scalingFactor)) + 0.5;
+  if (scale >= ldexp (1.0, 64))
+    {
+      return 0;
+    }
+  return (uint64_t) scale;
+}
 
-private:
-  uint64_t m_creationTime; //!< Tag creation time
-};
+/**
+ * Compute base^u by repeated squaring
+ * \param base the base
+ * \param u the exponent
+ * \return base^u
+ */
+static inline double
+PowU (double base, uint32_t u)
+{
+  double result = 1.0;
+  while (u > 0)
+    {
+      if (u & 1)
+        {
+          result *= base;
+        }
+      base *= base;
+      u >>= 1;
+    }
+  return result;
+}
 
+/**
+ * Compute the u-th power of a Q32 probability
+ * \param probQ32 the probability in Q32 format, not greater than 2^32
+ * \param u the exponent
+ * \return probQ32^u in Q32 format
+ */
+static inline uint64_t
+PowUQ32 (uint64_t probQ32, uint32_t u)
+{
+  if (probQ32 >= (UINT64_C (1) << 32))
+    {
+      return (UINT64_C (1) << 32);
+    }
+  // Both factors are below 2^32, hence products fit in 64 bits
+  uint64_t probPowU = UINT64_C (1) << 32;
+  uint64_t base = probQ32;
+  while (u > 0)
+    {
+      if (u & 1)
+        {
+          probPowU = (probPowU * base) >> 32;
+        }
+      base = (base * base) >> 32;
+      u >>= 1;
+    }
+  return probPowU;
+}
 
-DualQCoupledCurvyRedTimestampTag::DualQCoupledCurvyRedTimestampTag ()
-  : m_creationTime (Simulator::Now ().GetTimeStep ())
+/**
+ * Convert a probability into Q32 format
+ * \param prob the probability
+ * \return the probability in Q32 format, saturated to [0, 2^32]
+ */
+static inline uint64_t
+ProbToQ32 (double prob)
 {
+  if (prob <= 0)
+    {
+      return 0;
+    }
+  if (prob >= 1)
+    {
+      return (UINT64_C (1) << 32);
+    }
+  return (uint64_t) (prob * 4294967296.0);
 }
 
-TypeId
-DualQCoupledCurvyRedTimestampTag::GetTypeId (void)
+NS_OBJECT_ENSURE_REGISTERED (DualQCoupledCurvyRedCoupling);
+
+TypeId DualQCoupledCurvyRedCoupling::GetTypeId (void)
 {
-  static TypeId tid = TypeId ("ns3::DualQCoupledCurvyRedTimestampTag")
-    .SetParent<Tag> ()
-    .AddConstructor<DualQCoupledCurvyRedTimestampTag> ()
-    .AddAttribute ("CreationTime",
-                   "The time at which the timestamp was created",
-                   StringValue ("0.0s"),
-                   MakeTimeAccessor (&DualQCoupledCurvyRedTimestampTag::GetTxTime),
-                   MakeTimeChecker ())
+  static TypeId tid = TypeId ("ns3::DualQCoupledCurvyRedCoupling")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<DualQCoupledCurvyRedCoupling> ()
+    .AddTraceSource ("AvgQueuingTime",
+                     "EWMA of the Classic queuing time aggregated over the coupled queue discs",
+                     MakeTraceSourceAccessor (&DualQCoupledCurvyRedCoupling::m_avgQueuingTime),
+                     "ns3::TracedValueCallback::Time")
   ;
   return tid;
 }
 
-TypeId
-DualQCoupledCurvyRedTimestampTag::GetInstanceTypeId (void) const
+DualQCoupledCurvyRedCoupling::DualQCoupledCurvyRedCoupling ()
+  : m_avgQueuingTime (Seconds (0)),
+    m_nQueueDiscs (0)
 {
-  return GetTypeId ();
+  NS_LOG_FUNCTION (this);
 }
 
-uint32_t
-DualQCoupledCurvyRedTimestampTag::GetSerializedSize (void) const
+DualQCoupledCurvyRedCoupling::~DualQCoupledCurvyRedCoupling ()
 {
-  return 8;
+  NS_LOG_FUNCTION (this);
 }
 
-void
-DualQCoupledCurvyRedTimestampTag::Serialize (TagBuffer i) const
+Time
+DualQCoupledCurvyRedCoupling::GetAvgQueuingTime (void) const
 {
-  i.WriteU64 (m_creationTime);
+  return m_avgQueuingTime;
 }
 
 void
-DualQCoupledCurvyRedTimestampTag::Deserialize (TagBuffer i)
+DualQCoupledCurvyRedCoupling::SetAvgQueuingTime (Time avgQueuingTime)
 {
-  m_creationTime = i.ReadU64 ();
+  m_avgQueuingTime = avgQueuingTime;
 }
 
 void
-DualQCoupledCurvyRedTimestampTag::Print (std::ostream &os) const
+DualQCoupledCurvyRedCoupling::AddQueueDisc (void)
 {
-  os << "CreationTime=" << m_creationTime;
+  NS_LOG_FUNCTION (this);
+  m_nQueueDiscs++;
 }
 
-Time
-DualQCoupledCurvyRedTimestampTag::GetTxTime (void) const
+uint32_t
+DualQCoupledCurvyRedCoupling::GetNQueueDiscs (void) const
 {
-  return TimeStep (m_creationTime);
+  return m_nQueueDiscs;
 }
 
 NS_OBJECT_ENSURE_REGISTERED (DualQCoupledCurvyRedQueueDisc);
@@ -168,13 +250,151 @@ TypeId DualQCoupledCurvyRedQueueDisc::GetTypeId (void)
                    UintegerValue (25),
                    MakeUintegerAccessor (&DualQCoupledCurvyRedQueueDisc::SetQueueLimit),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MarkingEngine",
+                   "Engine used to compare the marking probability against the maximum of Curviness random numbers",
+                   EnumValue (MARKING_ENGINE_SINGLE_DRAW),
+                   MakeEnumAccessor (&DualQCoupledCurvyRedQueueDisc::m_markingEngine),
+                   MakeEnumChecker (MARKING_ENGINE_MAXRAND, "MARKING_ENGINE_MAXRAND",
+                                    MARKING_ENGINE_SINGLE_DRAW, "MARKING_ENGINE_SINGLE_DRAW"))
+    .AddAttribute ("FixedPoint",
+                   "True to compute the EWMA and the probabilities in fixed point arithmetic",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DualQCoupledCurvyRedQueueDisc::m_fixedPoint),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Scheduler",
+                   "Scheduler used to pick the queue (L4S or Classic) to serve",
+                   EnumValue (SCHEDULER_STRICT_PRIORITY),
+                   MakeEnumAccessor (&DualQCoupledCurvyRedQueueDisc::m_scheduler),
+                   MakeEnumChecker (SCHEDULER_STRICT_PRIORITY, "SCHEDULER_STRICT_PRIORITY",
+                                    SCHEDULER_TIME_SHIFTED_FIFO, "SCHEDULER_TIME_SHIFTED_FIFO",
+                                    SCHEDULER_WRR, "SCHEDULER_WRR"))
+    .AddAttribute ("TimeShift",
+                   "Time shift added to the L4S head sojourn time by the time-shifted FIFO scheduler",
+                   TimeValue (Seconds (0.03)),
+                   MakeTimeAccessor (&DualQCoupledCurvyRedQueueDisc::m_tShift),
+                   MakeTimeChecker ())
+    .AddAttribute ("L4SWeight",
+                   "Number of L4S packets served per round by the WRR scheduler",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&DualQCoupledCurvyRedQueueDisc::m_l4sWeight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ClassicWeight",
+                   "Number of Classic packets served per round by the WRR scheduler",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&DualQCoupledCurvyRedQueueDisc::m_classicWeight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("QueueProtection",
+                   "True to sanction the L4S flows building a queue",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DualQCoupledCurvyRedQueueDisc::m_qProt),
+                   MakeBooleanChecker ())
+    .AddAttribute ("QueueProtectionSanction",
+                   "Sanction applied to the L4S packets of the flows exceeding their queuing score",
+                   EnumValue (QPROT_SANCTION_REDIRECT),
+                   MakeEnumAccessor (&DualQCoupledCurvyRedQueueDisc::m_qProtSanction),
+                   MakeEnumChecker (QPROT_SANCTION_REDIRECT, "QPROT_SANCTION_REDIRECT",
+                                    QPROT_SANCTION_DROP, "QPROT_SANCTION_DROP"))
+    .AddAttribute ("QueueProtectionBuckets",
+                   "Number of buckets of the queue protection flow table (rounded up to a power of 2)",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&DualQCoupledCurvyRedQueueDisc::m_qProtBuckets),
+                   MakeUintegerChecker<uint32_t> (1, 1u << 16))
+    .AddAttribute ("QueueProtectionAgingRate",
+                   "Rate at which the congestion volume accumulated by a flow is aged",
+                   DataRateValue (DataRate ("4Mbps")),
+                   MakeDataRateAccessor (&DualQCoupledCurvyRedQueueDisc::m_qProtAgingRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("QueueProtectionCriticalScore",
+                   "Queuing score (time needed to age the congestion volume of a flow) above which the flow is sanctioned",
+                   TimeValue (MilliSeconds (4)),
+                   MakeTimeAccessor (&DualQCoupledCurvyRedQueueDisc::m_qProtCriticalScore),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueProtectionCriticalDelay",
+                   "L4S queuing delay below which no flow is sanctioned",
+                   TimeValue (MilliSeconds (2)),
+                   MakeTimeAccessor (&DualQCoupledCurvyRedQueueDisc::m_qProtCriticalDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("Overload",
+                   "True to drop instead of mark L4S packets when the L4S queue is in overload",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DualQCoupledCurvyRedQueueDisc::m_overloadEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("OverloadThreshold",
+                   "L4S probability at which the L4S queue enters overload",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&DualQCoupledCurvyRedQueueDisc::m_overloadThreshold),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("OverloadExitThreshold",
+                   "L4S probability below which the L4S queue leaves overload",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DualQCoupledCurvyRedQueueDisc::m_overloadExitThreshold),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("Coupling",
+                   "Coupled state shared with other queue discs (e.g., the other children of an mq queue disc), if any",
+                   PointerValue (),
+                   MakePointerAccessor (&DualQCoupledCurvyRedQueueDisc::m_coupling),
+                   MakePointerChecker<DualQCoupledCurvyRedCoupling> ())
+    .AddAttribute ("UpdateInterval",
+                   "Interval between the updates of the probabilities from the sampled Classic "
+                   "queuing time (0 to update them at every dequeue)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&DualQCoupledCurvyRedQueueDisc::m_updateInterval),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("AutoTune",
+                   "True to derive ClassicQueueScalingFactor, Fc and L4SQueueSizeThreshold "
+                   "from the link bandwidth and the target delays",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DualQCoupledCurvyRedQueueDisc::m_autoTune),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LinkBandwidth",
+                   "The link bandwidth used by AutoTune (0 to use the DataRate attribute of the device)",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&DualQCoupledCurvyRedQueueDisc::m_linkBandwidth),
+                   MakeDataRateChecker ())
+    .AddAttribute ("TargetDelay",
+                   "Classic queuing delay targeted by AutoTune",
+                   TimeValue (MilliSeconds (15)),
+                   MakeTimeAccessor (&DualQCoupledCurvyRedQueueDisc::m_targetDelay),
+                   MakeTimeChecker (NanoSeconds (1)))
+    .AddAttribute ("L4STargetDelay",
+                   "L4S queuing delay at which AutoTune sets the L4S marking threshold",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&DualQCoupledCurvyRedQueueDisc::m_l4sTargetDelay),
+                   MakeTimeChecker (NanoSeconds (1)))
+    .AddAttribute ("MeanPktSize",
+                   "Average of packet size used by AutoTune",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&DualQCoupledCurvyRedQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("AvgQueuingTime",
+                     "EWMA of the Classic queuing time",
+                     MakeTraceSourceAccessor (&DualQCoupledCurvyRedQueueDisc::avgQueuingTime),
+                     "ns3::TracedValueCallback::Time")
+    .AddTraceSource ("L4SProb",
+                     "L4S probability (before applying the curviness)",
+                     MakeTraceSourceAccessor (&DualQCoupledCurvyRedQueueDisc::m_l4sProb),
+                     "ns3::TracedValueCallback::Double")
+    .AddTraceSource ("ClassicSqrtProb",
+                     "Square root of the Classic probability (before applying the curviness)",
+                     MakeTraceSourceAccessor (&DualQCoupledCurvyRedQueueDisc::m_classicSqrtProb),
+                     "ns3::TracedValueCallback::Double")
+    .AddTraceSource ("Overload",
+                     "True if the L4S queue is in overload",
+                     MakeTraceSourceAccessor (&DualQCoupledCurvyRedQueueDisc::m_overload),
+                     "ns3::TracedValueCallback::Bool")
   ;
 
   return tid;
 }
 
 DualQCoupledCurvyRedQueueDisc::DualQCoupledCurvyRedQueueDisc ()
-  : QueueDisc ()
+  : QueueDisc (),
+    m_l4sProb (0),
+    m_classicSqrtProb (0),
+    m_overload (false),
+    m_periodicUpdate (false),
+    m_l4sThresholdQ32 (0),
+    m_classicThresholdQ32 (0)
 {
   NS_LOG_FUNCTION (this);
   m_uv = CreateObject<UniformRandomVariable> ();
@@ -190,6 +410,8 @@ DualQCoupledCurvyRedQueueDisc::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_uv = 0;
+  m_coupling = 0;
+  Simulator::Remove (m_updateEvent);
   QueueDisc::DoDispose ();
 }
 
@@ -218,13 +440,15 @@ uint32_t
 DualQCoupledCurvyRedQueueDisc::GetQueueSize (void)
 {
   NS_LOG_FUNCTION (this);
-  if (GetMode () == QUEUE_DISC_MODE_BYTES)
+  // the occupancy counters of the base class are updated incrementally by
+  // EnqueueInternalQueue and DequeueInternalQueue
+  if (m_mode == QUEUE_DISC_MODE_BYTES)
     {
-      return (GetInternalQueue (0)->GetNBytes () + GetInternalQueue (1)->GetNBytes ());
+      return GetInternalQueuesNBytes ();
     }
-  else if (GetMode () == QUEUE_DISC_MODE_PACKETS)
+  else if (m_mode == QUEUE_DISC_MODE_PACKETS)
     {
-      return (GetInternalQueue (0)->GetNPackets () + GetInternalQueue (1)->GetNPackets ());
+      return GetInternalQueuesNPackets ();
     }
   else
     {
@@ -236,14 +460,25 @@ uint32_t
 DualQCoupledCurvyRedQueueDisc::Getl4sQueueSize (void)        //to calculate the current size of l4s queue in bytes
 {
   NS_LOG_FUNCTION (this);
-  return (GetInternalQueue (1)->GetNBytes ());
+  return GetInternalQueueNBytes (1);
 }
 
 DualQCoupledCurvyRedQueueDisc::Stats
 DualQCoupledCurvyRedQueueDisc::GetStats ()
 {
   NS_LOG_FUNCTION (this);
-  return m_stats;
+  Stats stats = m_stats;
+  if (IsSojournHistogramEnabled () && GetNInternalQueues () == 2)
+    {
+      // percentiles of the sojourn time in the Classic (0) and L4S (1) queues
+      const SojournHistogram &classic = GetInternalQueueSojournHistogram (0);
+      const SojournHistogram &l4s = GetInternalQueueSojournHistogram (1);
+      stats.p99ClassicSojourn = classic.GetPercentile (99);
+      stats.p999ClassicSojourn = classic.GetPercentile (99.9);
+      stats.p99L4SSojourn = l4s.GetPercentile (99);
+      stats.p999L4SSojourn = l4s.GetPercentile (99.9);
+    }
+  return stats;
 }
 
 int64_t
@@ -254,13 +489,102 @@ DualQCoupledCurvyRedQueueDisc::AssignStreams (int64_t stream)
   return 1;
 }
 
+void
+DualQCoupledCurvyRedQueueDisc::AutoTune (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  DataRate bandwidth = m_linkBandwidth;
+  if (bandwidth.GetBitRate () == 0)
+    {
+      // read the rate of the device (e.g., a PointToPointNetDevice) through the
+      // attribute system, as traffic-control does not depend on the device models
+      DataRateValue rate;
+      Ptr<NetDevice> device = GetNetDevice ();
+      if (device != 0 && device->GetAttributeFailSafe ("DataRate", rate))
+        {
+          bandwidth = rate.Get ();
+        }
+    }
+  NS_ABORT_MSG_IF (bandwidth.GetBitRate () == 0, "AutoTune requires the LinkBandwidth attribute "
+                   "or a device with a non-zero DataRate attribute");
+
+  // sqrt of the Classic probability reaches 1 at 32 times the target delay
+  // (0.5 s for the default 15 ms target, as recommended by the draft)
+  m_classicQScalingFact = floor (log2 (32 * m_targetDelay.GetSeconds ()) + 0.5);
+
+  // the EWMA averages over about twice the number of packets served in the target delay
+  double pktsPerTarget = bandwidth.GetBitRate () * m_targetDelay.GetSeconds () / (8.0 * m_meanPktSize);
+  double fc = (pktsPerTarget > 1) ? floor (log2 (pktsPerTarget) + 0.5) + 1 : 1;
+  m_calcAlpha = (uint32_t) std::min (fc, 31.0);
+
+  // mark L4S packets above the bytes served in the L4S target delay, but not below 2 packets
+  double threshold = bandwidth.GetBitRate () * m_l4sTargetDelay.GetSeconds () / 8.0;
+  m_l4SQSizeThreshold = (uint32_t) std::min (std::max (threshold, 2.0 * m_meanPktSize), (double) UINT32_MAX);
+
+  NS_LOG_DEBUG ("Auto-tuned for " << bandwidth << ": ClassicQueueScalingFactor=" << m_classicQScalingFact
+                << " Fc=" << m_calcAlpha << " L4SQueueSizeThreshold=" << m_l4SQSizeThreshold);
+}
+
 void DualQCoupledCurvyRedQueueDisc::InitializeParams (void)
 {
   m_l4sQScalingFact = m_classicQScalingFact + m_k0;
+  m_l4sQScale = pow (2, m_l4sQScalingFact);
+  m_classicQScale = pow (2, m_classicQScalingFact);
+  m_ewmaScale = pow (2, m_calcAlpha);
+  m_l4sProbScaleQ32 = ProbScaleQ32 (m_l4sQScalingFact);
+  m_classicProbScaleQ32 = ProbScaleQ32 (m_classicQScalingFact);
+  m_avgQueuingTimeNs = 0;
   m_stats.forcedDrop = 0;
   m_stats.unforcedClassicDrop = 0;
+  m_stats.unforcedClassicMark = 0;
   m_stats.unforcedL4SMark = 0;
+  m_stats.dequeuedClassicPackets = 0;
+  m_stats.dequeuedL4SPackets = 0;
+  m_stats.dequeuedClassicBytes = 0;
+  m_stats.dequeuedL4SBytes = 0;
+  m_stats.totalClassicSojourn = Time (Seconds (0));
+  m_stats.totalL4SSojourn = Time (Seconds (0));
+  m_stats.maxClassicSojourn = Time (Seconds (0));
+  m_stats.maxL4SSojourn = Time (Seconds (0));
+  m_stats.qProtRedirected = 0;
+  m_stats.qProtDropped = 0;
+  m_stats.overloadL4SDrop = 0;
+  m_stats.p99ClassicSojourn = Time (Seconds (0));
+  m_stats.p999ClassicSojourn = Time (Seconds (0));
+  m_stats.p99L4SSojourn = Time (Seconds (0));
+  m_stats.p999L4SSojourn = Time (Seconds (0));
+  m_overloadThresholdQ32 = (uint64_t) (m_overloadThreshold * 4294967296.0);
+  m_overloadExitThresholdQ32 = (uint64_t) (m_overloadExitThreshold * 4294967296.0);
+  m_overload = false;
   avgQueuingTime = Time (Seconds (0));
+  m_l4sProb = 0;
+  m_classicSqrtProb = 0;
+  m_wrrServingL4S = false;
+  m_wrrCredit = 0;
+  if (m_coupling != 0)
+    {
+      m_coupling->AddQueueDisc ();
+    }
+  m_l4sThresholdQ32 = 0;
+  m_classicThresholdQ32 = 0;
+  m_periodicUpdate = !m_updateInterval.IsZero ();
+  if (m_periodicUpdate)
+    {
+      m_updateEvent = Simulator::Schedule (m_updateInterval, &DualQCoupledCurvyRedQueueDisc::UpdateProbabilities, this);
+    }
+  if (m_qProt)
+    {
+      uint32_t buckets = 1;
+      while (buckets < m_qProtBuckets)
+        {
+          buckets <<= 1;
+        }
+      FlowBucket empty = { 0, 0 };
+      m_qProtTable.assign (buckets + 1, empty);
+      m_qProtMask = buckets - 1;
+      m_qProtNsPerByte = 8e9 / m_qProtAgingRate.GetBitRate ();
+    }
 }
 
 bool
@@ -269,17 +593,12 @@ DualQCoupledCurvyRedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   NS_LOG_FUNCTION (this << item);
   uint8_t queueNumber;
 
-  // attach arrival time to packet
-  Ptr<Packet> p = item->GetPacket ();
-  DualQCoupledCurvyRedTimestampTag tag;
-  p->AddPacketTag (tag);
-
   uint32_t nQueued = GetQueueSize ();
-  if ((GetMode () == QUEUE_DISC_MODE_PACKETS && nQueued >= m_queueLimit)
-      || (GetMode () == QUEUE_DISC_MODE_BYTES && nQueued + item->GetSize () > m_queueLimit))
+  if ((m_mode == QUEUE_DISC_MODE_PACKETS && nQueued >= m_queueLimit)
+      || (m_mode == QUEUE_DISC_MODE_BYTES && nQueued + item->GetSize () > m_queueLimit))
     {
       // Drops due to queue limit
-      Drop (item);
+      Drop (item, DROP_FORCED);
       m_stats.forcedDrop++;
       return false;
     }
@@ -287,17 +606,103 @@ DualQCoupledCurvyRedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (item->IsL4S ())
     {
       queueNumber = 1;
+      if (m_qProt && QueueProtectionCheck (item))
+        {
+          if (m_qProtSanction == QPROT_SANCTION_DROP)
+            {
+              Drop (item, DROP_OTHER);
+              m_stats.qProtDropped++;
+              return false;
+            }
+          queueNumber = 0;
+          m_stats.qProtRedirected++;
+        }
     }
   else
     {
       queueNumber = 0;
     }
 
-  bool retval = GetInternalQueue (queueNumber)->Enqueue (item);
-  NS_LOG_LOGIC ("Number packets in queue-number " << queueNumber << ": " << GetInternalQueue (queueNumber)->GetNPackets ());
+  bool retval = EnqueueInternalQueue (queueNumber, item);
+  NS_LOG_LOGIC ("Number packets in queue-number " << queueNumber << ": " << GetInternalQueueNPackets (queueNumber));
   return retval;
 }
 
+DualQCoupledCurvyRedQueueDisc::FlowBucket&
+DualQCoupledCurvyRedQueueDisc::PickBucket (uint32_t id, int64_t nowNs)
+{
+  NS_LOG_FUNCTION (this << id << nowNs);
+  // two candidate buckets, from the low and the high bits of the hash
+  uint32_t idx[2] = { id & m_qProtMask, ((id >> 16) ^ (id * 0x9e3779b1u)) & m_qProtMask };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      FlowBucket &b = m_qProtTable[idx[i]];
+      if (b.id == id)
+        {
+          return b;
+        }
+    }
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      FlowBucket &b = m_qProtTable[idx[i]];
+      if (b.expiryNs <= nowNs)
+        {
+          b.id = id;
+          b.expiryNs = nowNs;
+          return b;
+        }
+    }
+  // the flows that cannot get a bucket share the last one
+  return m_qProtTable.back ();
+}
+
+bool
+DualQCoupledCurvyRedQueueDisc::QueueProtectionCheck (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  uint32_t id;
+  if (GetNPacketFilters () == 0)
+    {
+      // use the hash of the 5-tuple computed and cached by the item
+      id = item->Hash ();
+    }
+  else
+    {
+      int32_t ret = Classify (item);
+      id = (ret == PacketFilter::PF_NO_MATCH ? 0 : static_cast<uint32_t> (ret));
+    }
+  int64_t nowNs = Simulator::Now ().GetNanoSeconds ();
+
+  // current L4S marking probability
+  double prob;
+  if (Getl4sQueueSize () > m_l4SQSizeThreshold)
+    {
+      prob = 1;
+    }
+  else
+    {
+      Ptr<const QueueDiscItem> classicHead = GetInternalQueue (0)->Peek ();
+      prob = 0;
+      if (classicHead != 0)
+        {
+          prob = std::min (1.0, (Simulator::Now () - classicHead->GetTimeStamp ()).GetSeconds () / m_l4sQScale);
+          prob = PowU (prob, m_curviness);
+        }
+    }
+
+  // add the congestion volume of the packet to the score of its flow
+  FlowBucket &b = PickBucket (id, nowNs);
+  b.expiryNs = std::max (b.expiryNs, nowNs) + (int64_t) (item->GetSize () * prob * m_qProtNsPerByte);
+
+  if (b.expiryNs - nowNs <= m_qProtCriticalScore.GetNanoSeconds ())
+    {
+      return false;
+    }
+
+  Ptr<const QueueDiscItem> l4sHead = GetInternalQueue (1)->Peek ();
+  return (l4sHead != 0 && Simulator::Now () - l4sHead->GetTimeStamp () > m_qProtCriticalDelay);
+}
+
 double
 DualQCoupledCurvyRedQueueDisc::MaxRand (int u)
 {
@@ -305,72 +710,384 @@ DualQCoupledCurvyRedQueueDisc::MaxRand (int u)
   double maxr = 0.0;
   while (u-- > 0)
     {
-      maxr = max (maxr, m_uv->GetValue ());
+      maxr = std::max (maxr, m_uv->GetValue ());
     }
   return maxr;
 }
 
-Ptr<QueueDiscItem>
-DualQCoupledCurvyRedQueueDisc::DoDequeue ()
+bool
+DualQCoupledCurvyRedQueueDisc::CurvyRedDecision (double prob, uint32_t u)
+{
+  NS_LOG_FUNCTION (this << prob << u);
+  if (m_markingEngine == MARKING_ENGINE_MAXRAND)
+    {
+      return prob > MaxRand (u);
+    }
+
+  // The maximum of u random numbers lies in [0, 1)
+  if (prob <= 0)
+    {
+      return false;
+    }
+  if (prob >= 1)
+    {
+      return true;
+    }
+
+  // P (prob > max (X1..Xu)) = prob^u
+  return PowU (prob, u) > m_uv->GetValue ();
+}
+
+bool
+DualQCoupledCurvyRedQueueDisc::CurvyRedDecisionFixed (uint64_t probQ32, uint32_t u)
+{
+  NS_LOG_FUNCTION (this << probQ32 << u);
+  if (probQ32 == 0)
+    {
+      return false;
+    }
+  if (probQ32 >= (UINT64_C (1) << 32))
+    {
+      return true;
+    }
+
+  if (m_markingEngine == MARKING_ENGINE_MAXRAND)
+    {
+      uint32_t maxr = 0;
+      while (u-- > 0)
+        {
+          maxr = std::max (maxr, m_uv->GetInteger (0, UINT32_MAX));
+        }
+      return probQ32 > maxr;
+    }
+
+  return PowUQ32 (probQ32, u) > m_uv->GetInteger (0, UINT32_MAX);
+}
+
+bool
+DualQCoupledCurvyRedQueueDisc::CachedDecision (uint64_t thresholdQ32)
+{
+  NS_LOG_FUNCTION (this << thresholdQ32);
+  if (thresholdQ32 == 0)
+    {
+      return false;
+    }
+  if (thresholdQ32 >= (UINT64_C (1) << 32))
+    {
+      return true;
+    }
+  return thresholdQ32 > m_uv->GetInteger (0, UINT32_MAX);
+}
+
+void
+DualQCoupledCurvyRedQueueDisc::UpdateProbabilities (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (GetInternalQueue (1)->Peek () != 0)
+  // sample the sojourn time of the packet at the head of the Classic queue
+  Ptr<const QueueDiscItem> classicHead = GetInternalQueue (0)->Peek ();
+  Time classicQueueDelay = Time (Seconds (0));
+  if (classicHead != 0)
+    {
+      classicQueueDelay = Simulator::Now () - classicHead->GetTimeStamp ();
+    }
+
+  if (m_coupling != 0)
     {
-      Ptr<const QueueDiscItem> item1 = GetInternalQueue (0)->Peek ();
-      DualQCoupledCurvyRedTimestampTag tag;
-      Time classicQueueTime;
-      double l4sDropProb;
-      if (item1 != 0)
-        {         
-          item1->GetPacket ()->PeekPacketTag (tag);
-          classicQueueTime = tag.GetTxTime ();                             //arrival time of the packet at the head of classic queue
+      // the EWMA is computed over the samples of all the coupled queue discs
+      avgQueuingTime = m_coupling->GetAvgQueuingTime ();
+      m_avgQueuingTimeNs = avgQueuingTime.Get ().GetNanoSeconds ();
+    }
+
+  uint64_t l4sProbQ32;
+  uint64_t classicSqrtProbQ32;
+  if (m_fixedPoint)
+    {
+      int64_t delta = classicQueueDelay.GetNanoSeconds () - m_avgQueuingTimeNs;
+      m_avgQueuingTimeNs += (delta >= 0) ? (delta >> m_calcAlpha) : -((-delta) >> m_calcAlpha);
+      avgQueuingTime = NanoSeconds (m_avgQueuingTimeNs);
+      classicSqrtProbQ32 = QueuingTimeToProbQ32 (m_avgQueuingTimeNs, m_classicProbScaleQ32);
+      l4sProbQ32 = QueuingTimeToProbQ32 (classicQueueDelay.GetNanoSeconds (), m_l4sProbScaleQ32);
+      if (m_coupling != 0)
+        {
+          l4sProbQ32 = std::max (l4sProbQ32, QueuingTimeToProbQ32 (m_avgQueuingTimeNs, m_l4sProbScaleQ32));
         }
-      else
+      m_l4sProb = l4sProbQ32 / 4294967296.0;
+      m_classicSqrtProb = classicSqrtProbQ32 / 4294967296.0;
+    }
+  else
+    {
+      avgQueuingTime = avgQueuingTime.Get () + (classicQueueDelay - avgQueuingTime.Get ()) / m_ewmaScale;
+      double l4sProb = classicQueueDelay.GetSeconds () / m_l4sQScale;
+      if (m_coupling != 0)
         {
-          classicQueueTime = Time (Seconds (0));
+          l4sProb = std::max (l4sProb, avgQueuingTime.Get ().GetSeconds () / m_l4sQScale);
         }
-  
-      Ptr<QueueDiscItem> item = GetInternalQueue (1)->Dequeue ();
-      l4sDropProb = (Simulator::Now ().GetSeconds () - classicQueueTime.GetSeconds ()) / pow (2, m_l4sQScalingFact);
-      if(classicQueueTime.GetSeconds () == 0)
-      {
-        l4sDropProb = 0;
-      }
-      if (Getl4sQueueSize () > m_l4SQSizeThreshold || l4sDropProb > MaxRand (m_curviness))
+      m_l4sProb = l4sProb;
+      m_classicSqrtProb = avgQueuingTime.Get ().GetSeconds () / m_classicQScale;
+      l4sProbQ32 = ProbToQ32 (m_l4sProb);
+      classicSqrtProbQ32 = ProbToQ32 (m_classicSqrtProb);
+    }
+
+  if (m_coupling != 0)
+    {
+      m_coupling->SetAvgQueuingTime (avgQueuingTime);
+    }
+
+  if (m_overloadEnabled)
+    {
+      UpdateOverload (l4sProbQ32 >= m_overloadThresholdQ32, l4sProbQ32 < m_overloadExitThresholdQ32);
+    }
+
+  // the probability that the maximum of U random numbers is below p is p^U
+  m_l4sThresholdQ32 = PowUQ32 (l4sProbQ32, m_curviness);
+  m_classicThresholdQ32 = PowUQ32 (classicSqrtProbQ32, 2 * m_curviness);
+
+  m_updateEvent = Simulator::Schedule (m_updateInterval, &DualQCoupledCurvyRedQueueDisc::UpdateProbabilities, this);
+}
+
+bool
+DualQCoupledCurvyRedQueueDisc::SelectL4SQueue (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<const QueueDiscItem> l4sHead = GetInternalQueue (1)->Peek ();
+  Ptr<const QueueDiscItem> classicHead = GetInternalQueue (0)->Peek ();
+
+  if (l4sHead == 0 || classicHead == 0)
+    {
+      return (l4sHead != 0);
+    }
+
+  switch (m_scheduler)
+    {
+    case SCHEDULER_TIME_SHIFTED_FIFO:
+      // Compare (now - l4sTs) + tShift with (now - classicTs)
+      return (classicHead->GetTimeStamp () + m_tShift >= l4sHead->GetTimeStamp ());
+    case SCHEDULER_WRR:
+      if (m_wrrCredit == 0)
         {
-          item->Mark ();
-          m_stats.unforcedL4SMark++;
+          m_wrrServingL4S = !m_wrrServingL4S;
+          m_wrrCredit = m_wrrServingL4S ? m_l4sWeight : m_classicWeight;
         }
-      item->GetPacket ()->RemovePacketTag (tag); 
-      return item;
+      m_wrrCredit--;
+      return m_wrrServingL4S;
+    default:
+      return true;
+    }
+}
+
+void
+DualQCoupledCurvyRedQueueDisc::UpdateDequeueStats (Ptr<const QueueDiscItem> item, bool l4s)
+{
+  NS_LOG_FUNCTION (this << item << l4s);
+  Time sojourn = Simulator::Now () - item->GetTimeStamp ();
+  if (l4s)
+    {
+      m_stats.dequeuedL4SPackets++;
+      m_stats.dequeuedL4SBytes += item->GetSize ();
+      m_stats.totalL4SSojourn += sojourn;
+      m_stats.maxL4SSojourn = std::max (m_stats.maxL4SSojourn, sojourn);
+    }
+  else
+    {
+      m_stats.dequeuedClassicPackets++;
+      m_stats.dequeuedClassicBytes += item->GetSize ();
+      m_stats.totalClassicSojourn += sojourn;
+      m_stats.maxClassicSojourn = std::max (m_stats.maxClassicSojourn, sojourn);
     }
+}
+
+Ptr<QueueDiscItem>
+DualQCoupledCurvyRedQueueDisc::DoDequeue ()
+{
+  NS_LOG_FUNCTION (this);
 
-  while (GetInternalQueue (0)->Peek () != 0)                 //if there is a packet in classic queue to drop
+  while (GetInternalQueue (0)->Peek () != 0 || GetInternalQueue (1)->Peek () != 0)
     {
-      Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
-      DualQCoupledCurvyRedTimestampTag tag;
-      double sqrtClassicDropProb;
-      item->GetPacket ()->PeekPacketTag (tag);
-      
-      Time classicQueueDelay = Simulator::Now () - tag.GetTxTime ();             //instantaneous queuing time of the current classic packet
-      avgQueuingTime += (classicQueueDelay - avgQueuingTime) / pow(2,m_calcAlpha);           //classic Queue EWMA
-      sqrtClassicDropProb = (double) avgQueuingTime.GetSeconds () / pow (2, m_classicQScalingFact);
+      if (SelectL4SQueue ())
+        {
+          Ptr<QueueDiscItem> item;
+          bool mark;
+          if (m_periodicUpdate)
+            {
+              // the marking threshold is computed by UpdateProbabilities
+              item = DequeueInternalQueue (1);
+              mark = Getl4sQueueSize () > m_l4SQSizeThreshold || CachedDecision (m_l4sThresholdQ32);
+            }
+          else
+            {
+              Ptr<const QueueDiscItem> item1 = GetInternalQueue (0)->Peek ();
+              Time classicQueueTime;
+              double l4sDropProb;
+              if (item1 != 0)
+                {
+                  classicQueueTime = item1->GetTimeStamp ();                         //arrival time of the packet at the head of classic queue
+                }
+              else
+                {
+                  classicQueueTime = Time (Seconds (0));
+                }
 
-      if (sqrtClassicDropProb > MaxRand (2 * m_curviness))
+              item = DequeueInternalQueue (1);
+              if (m_fixedPoint)
+                {
+                  uint64_t l4sDropProbQ32 = 0;
+                  if (item1 != 0)
+                    {
+                      l4sDropProbQ32 = QueuingTimeToProbQ32 ((Simulator::Now () - classicQueueTime).GetNanoSeconds (), m_l4sProbScaleQ32);
+                    }
+                  if (m_coupling != 0)
+                    {
+                      // couple to the Classic queuing time aggregated over the coupled queue discs
+                      l4sDropProbQ32 = std::max (l4sDropProbQ32, QueuingTimeToProbQ32 (m_coupling->GetAvgQueuingTime ().GetNanoSeconds (), m_l4sProbScaleQ32));
+                    }
+                  m_l4sProb = l4sDropProbQ32 / 4294967296.0;
+                  if (m_overloadEnabled)
+                    {
+                      UpdateOverload (l4sDropProbQ32 >= m_overloadThresholdQ32, l4sDropProbQ32 < m_overloadExitThresholdQ32);
+                    }
+                  mark = Getl4sQueueSize () > m_l4SQSizeThreshold || CurvyRedDecisionFixed (l4sDropProbQ32, m_curviness);
+                }
+              else
+                {
+                  l4sDropProb = (Simulator::Now ().GetSeconds () - classicQueueTime.GetSeconds ()) / m_l4sQScale;
+                  if (item1 == 0)
+                    {
+                      l4sDropProb = 0;
+                    }
+                  if (m_coupling != 0)
+                    {
+                      // couple to the Classic queuing time aggregated over the coupled queue discs
+                      l4sDropProb = std::max (l4sDropProb, m_coupling->GetAvgQueuingTime ().GetSeconds () / m_l4sQScale);
+                    }
+                  m_l4sProb = l4sDropProb;
+                  if (m_overloadEnabled)
+                    {
+                      UpdateOverload (l4sDropProb >= m_overloadThreshold, l4sDropProb < m_overloadExitThreshold);
+                    }
+                  mark = Getl4sQueueSize () > m_l4SQSizeThreshold || CurvyRedDecision (l4sDropProb, m_curviness);
+                }
+            }
+          if (mark && m_overload)
+            {
+              // in overload, the L4S queue is drained by dropping
+              Drop (item, DROP_UNFORCED);
+              m_stats.overloadL4SDrop++;
+              continue;
+            }
+          if (mark)
+            {
+              item->Mark ();
+              m_stats.unforcedL4SMark++;
+            }
+          UpdateDequeueStats (item, true);
+          return item;
+        }
+
+      // drop Classic packets until one is forwarded or the scheduler picks the L4S queue
+      Ptr<QueueDiscItem> item = DequeueInternalQueue (0);
+      bool drop;
+
+      if (m_periodicUpdate)
         {
-          Drop (item);
+          // the dropping threshold is computed by UpdateProbabilities
+          drop = CachedDecision (m_classicThresholdQ32);
+        }
+      else
+        {
+          Time classicQueueDelay = Simulator::Now () - item->GetTimeStamp ();             //instantaneous queuing time of the current classic packet
+          if (m_coupling != 0)
+            {
+              // the EWMA is computed over the Classic packets of all the coupled queue discs
+              avgQueuingTime = m_coupling->GetAvgQueuingTime ();
+              m_avgQueuingTimeNs = avgQueuingTime.Get ().GetNanoSeconds ();
+            }
+
+          if (m_fixedPoint)
+            {
+              // classic Queue EWMA, the shift rounds towards zero as the Time division does
+              int64_t delta = classicQueueDelay.GetNanoSeconds () - m_avgQueuingTimeNs;
+              m_avgQueuingTimeNs += (delta >= 0) ? (delta >> m_calcAlpha) : -((-delta) >> m_calcAlpha);
+              uint64_t classicDropProbQ32 = QueuingTimeToProbQ32 (m_avgQueuingTimeNs, m_classicProbScaleQ32);
+              avgQueuingTime = NanoSeconds (m_avgQueuingTimeNs);
+              m_classicSqrtProb = classicDropProbQ32 / 4294967296.0;
+              drop = CurvyRedDecisionFixed (classicDropProbQ32, 2 * m_curviness);
+            }
+          else
+            {
+              double sqrtClassicDropProb;
+              avgQueuingTime = avgQueuingTime.Get () + (classicQueueDelay - avgQueuingTime.Get ()) / m_ewmaScale;           //classic Queue EWMA
+              sqrtClassicDropProb = (double) avgQueuingTime.Get ().GetSeconds () / m_classicQScale;
+              m_classicSqrtProb = sqrtClassicDropProb;
+              drop = CurvyRedDecision (sqrtClassicDropProb, 2 * m_curviness);
+            }
+
+          if (m_coupling != 0)
+            {
+              m_coupling->SetAvgQueuingTime (avgQueuingTime);
+            }
+        }
+
+      if (drop)
+        {
+          Drop (item, DROP_UNFORCED);
           m_stats.unforcedClassicDrop++;
         }
       else
         { 
-          item->GetPacket ()->RemovePacketTag (tag);
+          UpdateDequeueStats (item, false);
           return item; 
         }  
     }
   return 0;
 }
 
+Time
+DualQCoupledCurvyRedQueueDisc::GetAvgQueuingTime (void) const
+{
+  return avgQueuingTime;
+}
+
+double
+DualQCoupledCurvyRedQueueDisc::GetL4SProb (void) const
+{
+  return m_l4sProb;
+}
+
+double
+DualQCoupledCurvyRedQueueDisc::GetClassicSqrtProb (void) const
+{
+  return m_classicSqrtProb;
+}
+
+bool
+DualQCoupledCurvyRedQueueDisc::GetOverload (void) const
+{
+  return m_overload;
+}
+
+Ptr<DualQCoupledCurvyRedCoupling>
+DualQCoupledCurvyRedQueueDisc::GetCoupling (void) const
+{
+  return m_coupling;
+}
+
+void
+DualQCoupledCurvyRedQueueDisc::UpdateOverload (bool saturated, bool relieved)
+{
+  NS_LOG_FUNCTION (this << saturated << relieved);
+  if (!m_overload && saturated)
+    {
+      NS_LOG_DEBUG ("L4S queue enters overload");
+      m_overload = true;
+    }
+  else if (m_overload && relieved)
+    {
+      NS_LOG_DEBUG ("L4S queue leaves overload");
+      m_overload = false;
+    }
+}
+
 Ptr<const QueueDiscItem>
 DualQCoupledCurvyRedQueueDisc::DoPeek () const
 {
@@ -402,17 +1119,31 @@ DualQCoupledCurvyRedQueueDisc::CheckConfig (void)
       return false;
     }
 
-  if (GetNPacketFilters () > 0)
+  if (!m_qProt && GetNPacketFilters () > 0)
     {
       NS_LOG_ERROR ("DualQCoupledCurvyRedQueueDisc cannot have packet filters");
       return false;
     }
 
+  if (m_qProt && m_qProtAgingRate.GetBitRate () == 0)
+    {
+      NS_LOG_ERROR ("The queue protection aging rate must be positive");
+      return false;
+    }
+
+  if (m_overloadExitThreshold > m_overloadThreshold)
+    {
+      NS_LOG_ERROR ("OverloadExitThreshold cannot exceed OverloadThreshold");
+      return false;
+    }
+
   if (GetNInternalQueues () == 0)
     {
-      // Create 2 DropTail queues
-      Ptr<InternalQueue> queue1 = CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> > ("Mode", EnumValue (m_mode));
-      Ptr<InternalQueue> queue2 = CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> > ("Mode", EnumValue (m_mode));
+      // Create the 2 internal queues (DropTail by default)
+      Ptr<InternalQueue> queue1 = CreateInternalQueue ();
+      Ptr<InternalQueue> queue2 = CreateInternalQueue ();
+      queue1->SetAttribute ("Mode", EnumValue (m_mode));
+      queue2->SetAttribute ("Mode", EnumValue (m_mode));
       if (m_mode == QUEUE_DISC_MODE_PACKETS)
         {
           queue1->SetMaxPackets (m_queueLimit);
@@ -433,6 +1164,32 @@ DualQCoupledCurvyRedQueueDisc::CheckConfig (void)
       return false;
     }
 
+  if (m_autoTune)
+    {
+      // tune the parameters here, so that the tuned values are checked below
+      AutoTune ();
+    }
+
+  if (m_fixedPoint && m_calcAlpha >= 63)
+    {
+      NS_LOG_ERROR ("Fc must be lower than 63 in fixed point mode");
+      return false;
+    }
+
+  if (m_fixedPoint && (ProbScaleQ32 (m_classicQScalingFact) < MIN_PROB_SCALE_Q32
+                       || ProbScaleQ32 (m_classicQScalingFact + m_k0) < MIN_PROB_SCALE_Q32))
+    {
+      NS_LOG_ERROR ("The Classic and L4S queue scaling factors must be between -29 and 18 "
+                    "in fixed point mode");
+      return false;
+    }
+
+  if (m_scheduler == SCHEDULER_WRR && (m_l4sWeight == 0 || m_classicWeight == 0))
+    {
+      NS_LOG_ERROR ("The WRR weights of the DualQCoupledCurvyRedQueueDisc must be positive");
+      return false;
+    }
+
   if ((GetInternalQueue (0)->GetMode () == QueueBase::QUEUE_MODE_PACKETS && m_mode == QUEUE_DISC_MODE_BYTES)
       || (GetInternalQueue (0)->GetMode () == QueueBase::QUEUE_MODE_BYTES && m_mode == QUEUE_DISC_MODE_PACKETS))
     {
@@ -42,6 +42,62 @@ namespace ns3 {
 class TraceContainer;
 class UniformRandomVariable;
 
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Coupled state shared by several DualQ Coupled Curvy RED queue discs
+ *
+ * When the same object is set as the Coupling attribute of several DualQ
+ * Coupled Curvy RED queue discs (e.g., the child queue discs of an mq queue
+ * disc, one per device transmission queue), the EWMA of the Classic queuing
+ * time is computed over the Classic packets dequeued by all of them, and
+ * the L4S probability of each queue disc is coupled to such aggregated
+ * Classic queuing time.
+ */
+class DualQCoupledCurvyRedCoupling : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief DualQCoupledCurvyRedCoupling Constructor
+   */
+  DualQCoupledCurvyRedCoupling ();
+
+  virtual ~DualQCoupledCurvyRedCoupling ();
+
+  /**
+   * \brief Get the aggregated EWMA of the Classic queuing time
+   * \return the aggregated averaged Classic queuing time
+   */
+  Time GetAvgQueuingTime (void) const;
+
+  /**
+   * \brief Set the aggregated EWMA of the Classic queuing time
+   * \param avgQueuingTime the aggregated averaged Classic queuing time
+   */
+  void SetAvgQueuingTime (Time avgQueuingTime);
+
+  /**
+   * \brief Register a queue disc sharing this coupled state
+   */
+  void AddQueueDisc (void);
+
+  /**
+   * \brief Get the number of queue discs sharing this coupled state
+   * \return the number of queue discs
+   */
+  uint32_t GetNQueueDiscs (void) const;
+
+private:
+  TracedValue<Time> m_avgQueuingTime;   //!< Aggregated EWMA of the Classic queuing time
+  uint32_t m_nQueueDiscs;               //!< Number of queue discs sharing this coupled state
+};
+
 /**
  * \ingroup traffic-control
  *
@@ -76,6 +132,21 @@ public:
     uint32_t unforcedClassicMark;      //!< Probability marks of Classic traffic: proactive
     uint32_t unforcedL4SMark;          //!< Probability marks of L4S traffic: proactive
     uint32_t forcedDrop;               //!< Drops due to queue limit: reactive
+    uint32_t dequeuedClassicPackets;   //!< Packets dequeued from the Classic queue
+    uint32_t dequeuedL4SPackets;       //!< Packets dequeued from the L4S queue
+    uint64_t dequeuedClassicBytes;     //!< Bytes dequeued from the Classic queue
+    uint64_t dequeuedL4SBytes;         //!< Bytes dequeued from the L4S queue
+    Time totalClassicSojourn;          //!< Sum of the sojourn times of dequeued Classic packets
+    Time totalL4SSojourn;              //!< Sum of the sojourn times of dequeued L4S packets
+    Time maxClassicSojourn;            //!< Maximum sojourn time of a dequeued Classic packet
+    Time maxL4SSojourn;                //!< Maximum sojourn time of a dequeued L4S packet
+    uint32_t qProtRedirected;          //!< L4S packets redirected to the Classic queue by queue protection
+    uint32_t qProtDropped;             //!< L4S packets dropped by queue protection
+    uint32_t overloadL4SDrop;          //!< L4S packets dropped instead of marked in overload mode
+    Time p99ClassicSojourn;            //!< 99th percentile of the Classic queue sojourn time (zero unless SojournHistogram is true)
+    Time p999ClassicSojourn;           //!< 99.9th percentile of the Classic queue sojourn time (zero unless SojournHistogram is true)
+    Time p99L4SSojourn;                //!< 99th percentile of the L4S queue sojourn time (zero unless SojournHistogram is true)
+    Time p999L4SSojourn;               //!< 99.9th percentile of the L4S queue sojourn time (zero unless SojournHistogram is true)
   } Stats;
 
   /**
@@ -87,6 +158,35 @@ public:
     QUEUE_DISC_MODE_BYTES,       /**< Use number of bytes for maximum queue disc size */
   };
 
+  /**
+   * \brief Enumeration of the engines used to take the Curvy RED marking decision.
+   */
+  enum MarkingEngine
+  {
+    MARKING_ENGINE_MAXRAND,      /**< Compare against the maximum of U random numbers (reference) */
+    MARKING_ENGINE_SINGLE_DRAW,  /**< Compare prob^U against a single random number */
+  };
+
+  /**
+   * \brief Enumeration of the schedulers used to pick the queue to serve.
+   */
+  enum Scheduler
+  {
+    SCHEDULER_STRICT_PRIORITY,   /**< Serve the L4S queue whenever it is not empty */
+    SCHEDULER_TIME_SHIFTED_FIFO, /**< Serve the queue whose head has the larger time-shifted sojourn time */
+    SCHEDULER_WRR,               /**< Weighted round robin between the two queues */
+  };
+
+  /**
+   * \brief Enumeration of the sanctions applied by queue protection to the
+   *        packets of a flow exceeding its queuing score.
+   */
+  enum QueueProtectionSanction
+  {
+    QPROT_SANCTION_REDIRECT,     /**< Enqueue the packet in the Classic queue */
+    QPROT_SANCTION_DROP,         /**< Drop the packet */
+  };
+
   /**
    * \brief Set the operating mode of this queue.
    *
@@ -131,11 +231,76 @@ public:
    */
   double MaxRand ( int U );
 
+  /**
+   * \brief Decide whether a packet has to be marked (or dropped)
+   *
+   * The maximum of U uniform random numbers has CDF x^U, hence prob exceeds
+   * such a maximum with probability prob^U. The single draw engine uses this
+   * property to take the decision with one random number instead of U.
+   *
+   * \param prob the probability computed from the queuing time
+   * \param u the number of random numbers the maximum is taken over
+   * \return true if prob is greater than the maximum of u random numbers
+   */
+  bool CurvyRedDecision (double prob, uint32_t u);
+
+  /**
+   * \brief Fixed point version of CurvyRedDecision
+   *
+   * The probability is expressed in Q32 format (1.0 is 2^32) and compared
+   * against 32-bit random integers.
+   *
+   * \param probQ32 the probability computed from the queuing time, in Q32 format
+   * \param u the number of random numbers the maximum is taken over
+   * \return true if probQ32 is greater than the maximum of u random integers
+   */
+  bool CurvyRedDecisionFixed (uint64_t probQ32, uint32_t u);
+
+  /**
+   * \brief Decide whether a packet has to be marked (or dropped) against a
+   *        threshold computed by UpdateProbabilities
+   *
+   * \param thresholdQ32 the probability raised to the power of the number of
+   *        random numbers, in Q32 format
+   * \return true if a 32-bit random integer is below the threshold
+   */
+  bool CachedDecision (uint64_t thresholdQ32);
+
   /**
    * \brief Get the drop probability
    */
   double GetDropProb (void);
 
+  /**
+   * \brief Get the EWMA of the Classic queuing time
+   * \return the averaged Classic queuing time
+   */
+  Time GetAvgQueuingTime (void) const;
+
+  /**
+   * \brief Get the L4S probability computed at the last L4S dequeue
+   * \return the L4S probability (before applying the curviness)
+   */
+  double GetL4SProb (void) const;
+
+  /**
+   * \brief Get the square root of the Classic probability computed at the last Classic dequeue
+   * \return the Classic probability (before applying the curviness)
+   */
+  double GetClassicSqrtProb (void) const;
+
+  /**
+   * \brief Get the overload state of the L4S queue
+   * \return true if the L4S queue is in overload
+   */
+  bool GetOverload (void) const;
+
+  /**
+   * \brief Get the coupled state shared with other queue discs, if any
+   * \return the coupled state, or a null pointer if this queue disc is not coupled
+   */
+  Ptr<DualQCoupledCurvyRedCoupling> GetCoupling (void) const;
+
   /**
    * \brief Get Dual Queue PI Square statistics after running.
    *
@@ -170,6 +335,95 @@ private:
    */
   virtual void InitializeParams (void);
 
+  /**
+   * \brief Derive the scaling factor of the Classic queue, the EWMA constant
+   *        and the L4S marking threshold from the link bandwidth and the
+   *        target delays (if AutoTune is set). Called by CheckConfig.
+   *
+   * K0 and Curviness are dimensionless, hence they are not changed.
+   */
+  void AutoTune (void);
+
+  /**
+   * \brief Pick the internal queue to serve according to the scheduler.
+   *
+   * Must be called only when at least one of the internal queues is not empty.
+   *
+   * \return true if the L4S queue has to be served, false otherwise
+   */
+  bool SelectL4SQueue (void);
+
+  /**
+   * \brief Update the per-queue counters for a dequeued packet.
+   * \param item the dequeued item
+   * \param l4s true if the item was dequeued from the L4S queue
+   */
+  void UpdateDequeueStats (Ptr<const QueueDiscItem> item, bool l4s);
+
+  /**
+   * \brief Bucket of the queue protection flow table
+   *
+   * The queuing score of a flow is stored as the time at which it would
+   * decay to zero, so that no periodic aging is needed.
+   */
+  struct FlowBucket
+  {
+    uint32_t id;                //!< Hash of the flow owning the bucket
+    int64_t expiryNs;           //!< Time (ns) at which the queuing score of the flow is zero
+  };
+
+  /**
+   * \brief Find the bucket of a flow in the queue protection flow table.
+   *
+   * The two buckets indexed by the flow hash are checked. A bucket is taken
+   * over if it belongs to the flow or its score has decayed to zero. If both
+   * buckets are held by other flows, the last (shared) bucket is returned.
+   *
+   * \param id the hash of the flow
+   * \param nowNs the current time in ns
+   * \return the bucket of the flow
+   */
+  FlowBucket& PickBucket (uint32_t id, int64_t nowNs);
+
+  /**
+   * \brief Update the queuing score of the flow of an L4S packet and check
+   *        whether the packet has to be sanctioned.
+   *
+   * The queuing score of a flow grows with the bytes it sends times the
+   * current L4S marking probability (congestion volume) and decays at the
+   * QueueProtectionAgingRate. A packet is sanctioned if the score of its
+   * flow exceeds QueueProtectionCriticalScore while the L4S queuing delay
+   * exceeds QueueProtectionCriticalDelay.
+   *
+   * \param item the L4S packet being enqueued
+   * \return true if the packet has to be sanctioned
+   */
+  bool QueueProtectionCheck (Ptr<QueueDiscItem> item);
+
+  /**
+   * \brief Update the overload state of the L4S queue.
+   *
+   * The L4S queue enters overload when its coupled probability reaches
+   * OverloadThreshold and leaves it when the probability falls below
+   * OverloadExitThreshold.
+   *
+   * \param saturated true if the probability is not below OverloadThreshold
+   * \param relieved true if the probability is below OverloadExitThreshold
+   */
+  void UpdateOverload (bool saturated, bool relieved);
+
+  /**
+   * \brief Periodically update the probabilities (if UpdateInterval is not zero).
+   *
+   * The sojourn time of the packet at the head of the Classic queue is sampled
+   * and fed to the EWMA of the Classic queuing time. The L4S probability is
+   * computed from the sample and the Classic probability from the EWMA. Both
+   * are raised to the power of the number of random numbers the maximum is
+   * taken over and cached, so that the decision taken at each dequeue is a
+   * single comparison against a random integer.
+   */
+  void UpdateProbabilities (void);
+
   Stats m_stats;                                //!< DualQ Coupled Curvy RED statistics
 
   // ** Variables supplied by user
@@ -180,9 +434,51 @@ private:
   double m_classicQScalingFact;                 //!< scaling factor for Classic queuing time
   uint32_t m_calcAlpha;                         //!< parameter used to calculate alpha
   uint32_t m_curviness;                         //!< curviness parameter for Curvy RED 
+  MarkingEngine m_markingEngine;                //!< Engine used to take the marking decision
+  Scheduler m_scheduler;                        //!< Scheduler between the L4S and Classic queues
+  Time m_tShift;                                //!< Time shift added to the L4S sojourn time
+  uint32_t m_l4sWeight;                         //!< WRR weight of the L4S queue
+  uint32_t m_classicWeight;                     //!< WRR weight of the Classic queue
+  bool m_fixedPoint;                            //!< True to compute the probabilities in fixed point
+  bool m_qProt;                                 //!< True to enable queue protection of the L4S queue
+  QueueProtectionSanction m_qProtSanction;      //!< Sanction applied to the packets of misbehaving flows
+  uint32_t m_qProtBuckets;                      //!< Number of buckets of the flow table
+  DataRate m_qProtAgingRate;                    //!< Rate at which the queuing score of a flow decays
+  Time m_qProtCriticalScore;                    //!< Queuing score above which a flow is sanctioned
+  Time m_qProtCriticalDelay;                    //!< L4S queuing delay below which no flow is sanctioned
+  bool m_overloadEnabled;                       //!< True to drop instead of mark L4S packets in overload
+  double m_overloadThreshold;                   //!< L4S probability at which the L4S queue enters overload
+  double m_overloadExitThreshold;               //!< L4S probability below which the L4S queue leaves overload
   // ** Variables maintained by DualQ Coupled Curvy RED
-  Time avgQueuingTime;                        //!< Averaged Queuing time
+  TracedValue<Time> avgQueuingTime;             //!< Averaged Queuing time
+  TracedValue<double> m_l4sProb;                //!< L4S probability at the last L4S dequeue
+  TracedValue<double> m_classicSqrtProb;        //!< Square root of the Classic probability at the last Classic dequeue
   double  m_l4sQScalingFact;                    //!<scaling factor for L4S queuing time
+  double m_l4sQScale;                           //!< 2^m_l4sQScalingFact
+  double m_classicQScale;                       //!< 2^m_classicQScalingFact
+  double m_ewmaScale;                           //!< 2^m_calcAlpha
+  uint64_t m_l4sProbScaleQ32;                   //!< Q32 factor converting a queuing time in ns into a Q32 L4S probability
+  uint64_t m_classicProbScaleQ32;               //!< Q32 factor converting a queuing time in ns into a Q32 Classic probability
+  int64_t m_avgQueuingTimeNs;                   //!< Averaged Queuing time in ns (fixed point mode)
+  bool m_wrrServingL4S;                         //!< Queue currently served by WRR
+  uint32_t m_wrrCredit;                         //!< Packets left in the current WRR round
+  std::vector<FlowBucket> m_qProtTable;         //!< Queue protection flow table (plus the shared bucket)
+  uint32_t m_qProtMask;                         //!< Mask selecting a bucket index from a flow hash
+  double m_qProtNsPerByte;                      //!< Time (ns) needed to age one byte of congestion volume
+  uint64_t m_overloadThresholdQ32;              //!< OverloadThreshold in Q32 format (fixed point mode)
+  uint64_t m_overloadExitThresholdQ32;          //!< OverloadExitThreshold in Q32 format (fixed point mode)
+  TracedValue<bool> m_overload;                 //!< True if the L4S queue is in overload
+  Ptr<DualQCoupledCurvyRedCoupling> m_coupling; //!< Coupled state shared with other queue discs (if any)
+  Time m_updateInterval;                        //!< Interval between the updates of the probabilities (0 to update at every dequeue)
+  bool m_periodicUpdate;                        //!< True if the probabilities are updated by UpdateProbabilities
+  uint64_t m_l4sThresholdQ32;                   //!< L4S probability raised to U, in Q32 format (periodic update)
+  uint64_t m_classicThresholdQ32;               //!< Square root of the Classic probability raised to 2U, in Q32 format (periodic update)
+  EventId m_updateEvent;                        //!< Event used to update the probabilities
+  bool m_autoTune;                              //!< True to derive the parameters from the link bandwidth
+  DataRate m_linkBandwidth;                     //!< Link bandwidth used by AutoTune (0 to read the device)
+  Time m_targetDelay;                           //!< Classic queuing delay targeted by AutoTune
+  Time m_l4sTargetDelay;                        //!< L4S queuing delay targeted by AutoTune
+  uint32_t m_meanPktSize;                       //!< Average packet size used by AutoTune
   Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
 };
 
@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/queue.h"
+#include "dual-q-coupled-curvy-red-sampler.h"
+#include "dual-q-coupled-curvy-red-queue-disc.h"
+#include <fstream>
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DualQCoupledCurvyRedSampler");
+
+NS_OBJECT_ENSURE_REGISTERED (DualQCoupledCurvyRedSampler);
+
+TypeId DualQCoupledCurvyRedSampler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DualQCoupledCurvyRedSampler")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<DualQCoupledCurvyRedSampler> ()
+    .AddAttribute ("Interval",
+                   "Sampling interval",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&DualQCoupledCurvyRedSampler::m_interval),
+                   MakeTimeChecker (NanoSeconds (1)))
+    .AddAttribute ("Capacity",
+                   "Number of samples retained (the oldest samples are overwritten)",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&DualQCoupledCurvyRedSampler::m_capacity),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FileName",
+                   "File the samples are written to when the simulator is destroyed (none if empty)",
+                   StringValue (""),
+                   MakeStringAccessor (&DualQCoupledCurvyRedSampler::m_fileName),
+                   MakeStringChecker ())
+    .AddAttribute ("Format",
+                   "Format of the file the samples are written to",
+                   EnumValue (FORMAT_CSV),
+                   MakeEnumAccessor (&DualQCoupledCurvyRedSampler::m_format),
+                   MakeEnumChecker (FORMAT_CSV, "FORMAT_CSV",
+                                    FORMAT_BINARY, "FORMAT_BINARY"))
+  ;
+
+  return tid;
+}
+
+DualQCoupledCurvyRedSampler::DualQCoupledCurvyRedSampler ()
+  : m_next (0),
+    m_count (0),
+    m_overwritten (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DualQCoupledCurvyRedSampler::~DualQCoupledCurvyRedSampler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DualQCoupledCurvyRedSampler::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_sampleEvent);
+  m_queueDisc = 0;
+  m_samples.clear ();
+  Object::DoDispose ();
+}
+
+void
+DualQCoupledCurvyRedSampler::Install (Ptr<DualQCoupledCurvyRedQueueDisc> queueDisc)
+{
+  NS_LOG_FUNCTION (this << queueDisc);
+  NS_ABORT_MSG_IF (m_queueDisc != 0, "The sampler is already installed");
+  m_queueDisc = queueDisc;
+  m_samples.resize (m_capacity);
+  m_next = 0;
+  m_count = 0;
+  m_overwritten = 0;
+  m_sampleEvent = Simulator::ScheduleNow (&DualQCoupledCurvyRedSampler::DoSample, this);
+  if (!m_fileName.empty ())
+    {
+      Simulator::ScheduleDestroy (&DualQCoupledCurvyRedSampler::WriteOnDestroy, Ptr<DualQCoupledCurvyRedSampler> (this));
+    }
+}
+
+void
+DualQCoupledCurvyRedSampler::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_sampleEvent);
+}
+
+void
+DualQCoupledCurvyRedSampler::DoSample (void)
+{
+  Sample &sample = m_samples[m_next];
+  sample.timeNs = Simulator::Now ().GetNanoSeconds ();
+  sample.classicBytes = m_queueDisc->GetInternalQueue (0)->GetNBytes ();
+  sample.l4sBytes = m_queueDisc->GetInternalQueue (1)->GetNBytes ();
+  sample.avgQueuingTimeNs = m_queueDisc->GetAvgQueuingTime ().GetNanoSeconds ();
+  sample.l4sProb = m_queueDisc->GetL4SProb ();
+  sample.classicSqrtProb = m_queueDisc->GetClassicSqrtProb ();
+  sample.overload = m_queueDisc->GetOverload () ? 1 : 0;
+
+  if (++m_next == m_capacity)
+    {
+      m_next = 0;
+    }
+  if (m_count < m_capacity)
+    {
+      m_count++;
+    }
+  else
+    {
+      m_overwritten++;
+    }
+
+  m_sampleEvent = Simulator::Schedule (m_interval, &DualQCoupledCurvyRedSampler::DoSample, this);
+}
+
+uint32_t
+DualQCoupledCurvyRedSampler::GetNSamples (void) const
+{
+  return m_count;
+}
+
+const DualQCoupledCurvyRedSampler::Sample&
+DualQCoupledCurvyRedSampler::GetSample (uint32_t i) const
+{
+  NS_ASSERT (i < m_count);
+  uint32_t index = m_next + m_capacity - m_count + i;
+  if (index >= m_capacity)
+    {
+      index -= m_capacity;
+    }
+  return m_samples[index];
+}
+
+uint64_t
+DualQCoupledCurvyRedSampler::GetNOverwritten (void) const
+{
+  return m_overwritten;
+}
+
+void
+DualQCoupledCurvyRedSampler::Write (std::string filename, Format format) const
+{
+  NS_LOG_FUNCTION (this << filename << format);
+
+  if (format == FORMAT_CSV)
+    {
+      std::ofstream out (filename.c_str ());
+      NS_ABORT_MSG_UNLESS (out.is_open (), "Cannot open file " << filename);
+      out << "time_ns,classic_bytes,l4s_bytes,avg_queuing_time_ns,l4s_prob,classic_sqrt_prob,overload" << std::endl;
+      out << std::setprecision (9);
+      for (uint32_t i = 0; i < m_count; i++)
+        {
+          const Sample &s = GetSample (i);
+          out << s.timeNs << "," << s.classicBytes << "," << s.l4sBytes << ","
+              << s.avgQueuingTimeNs << "," << s.l4sProb << "," << s.classicSqrtProb << ","
+              << s.overload << "\n";
+        }
+      return;
+    }
+
+  // binary format: an 8 byte magic string, the number of samples and the
+  // size of a record (uint32_t), then one record per sample with the fields
+  // of Sample in declaration order, packed, in host byte order
+  std::ofstream out (filename.c_str (), std::ios::out | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (out.is_open (), "Cannot open file " << filename);
+  uint32_t recordSize = 2 * sizeof (int64_t) + 3 * sizeof (uint32_t) + 2 * sizeof (double);
+  out.write ("DQCRSMP1", 8);
+  out.write (reinterpret_cast<const char *> (&m_count), sizeof (m_count));
+  out.write (reinterpret_cast<const char *> (&recordSize), sizeof (recordSize));
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      const Sample &s = GetSample (i);
+      out.write (reinterpret_cast<const char *> (&s.timeNs), sizeof (s.timeNs));
+      out.write (reinterpret_cast<const char *> (&s.classicBytes), sizeof (s.classicBytes));
+      out.write (reinterpret_cast<const char *> (&s.l4sBytes), sizeof (s.l4sBytes));
+      out.write (reinterpret_cast<const char *> (&s.avgQueuingTimeNs), sizeof (s.avgQueuingTimeNs));
+      out.write (reinterpret_cast<const char *> (&s.l4sProb), sizeof (s.l4sProb));
+      out.write (reinterpret_cast<const char *> (&s.classicSqrtProb), sizeof (s.classicSqrtProb));
+      out.write (reinterpret_cast<const char *> (&s.overload), sizeof (s.overload));
+    }
+}
+
+void
+DualQCoupledCurvyRedSampler::WriteOnDestroy (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_fileName.empty ())
+    {
+      Write (m_fileName, m_format);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DUAL_Q_COUPLED_CURVY_RED_SAMPLER_H
+#define DUAL_Q_COUPLED_CURVY_RED_SAMPLER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include <vector>
+#include <string>
+
+namespace ns3 {
+
+class DualQCoupledCurvyRedQueueDisc;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Periodically samples the internal state of a DualQ Coupled Curvy RED
+ *        queue disc into a preallocated ring buffer
+ *
+ * Every Interval, the sampler reads the queue sizes, the averaged Classic
+ * queuing time, the L4S and Classic probabilities and the overload state of
+ * the queue disc, and stores them in a ring buffer of Capacity samples
+ * allocated once by Install. When the ring buffer is full, the oldest samples
+ * are overwritten. The retained samples can be written to a CSV or binary file
+ * at any time and, if FileName is set, are written when the simulator is
+ * destroyed.
+ */
+class DualQCoupledCurvyRedSampler : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief DualQCoupledCurvyRedSampler Constructor
+   */
+  DualQCoupledCurvyRedSampler ();
+
+  virtual ~DualQCoupledCurvyRedSampler ();
+
+  /**
+   * \brief Enumeration of the output file formats.
+   */
+  enum Format
+  {
+    FORMAT_CSV,      /**< One line per sample, comma separated values */
+    FORMAT_BINARY,   /**< A header followed by fixed-size records */
+  };
+
+  /**
+   * \brief Sample of the state of the queue disc
+   */
+  struct Sample
+  {
+    int64_t timeNs;              //!< Sampling time (ns)
+    uint32_t classicBytes;       //!< Bytes in the Classic queue
+    uint32_t l4sBytes;           //!< Bytes in the L4S queue
+    int64_t avgQueuingTimeNs;    //!< EWMA of the Classic queuing time (ns)
+    double l4sProb;              //!< L4S probability
+    double classicSqrtProb;      //!< Square root of the Classic probability
+    uint32_t overload;           //!< 1 if the L4S queue is in overload
+  };
+
+  /**
+   * \brief Allocate the ring buffer and start sampling the given queue disc
+   * \param queueDisc the queue disc to sample
+   */
+  void Install (Ptr<DualQCoupledCurvyRedQueueDisc> queueDisc);
+
+  /**
+   * \brief Stop sampling
+   */
+  void Stop (void);
+
+  /**
+   * \brief Get the number of samples retained in the ring buffer
+   * \return the number of samples
+   */
+  uint32_t GetNSamples (void) const;
+
+  /**
+   * \brief Get a retained sample
+   * \param i the index of the sample, 0 being the oldest retained sample
+   * \return the sample
+   */
+  const Sample& GetSample (uint32_t i) const;
+
+  /**
+   * \brief Get the number of samples overwritten because the ring buffer was full
+   * \return the number of overwritten samples
+   */
+  uint64_t GetNOverwritten (void) const;
+
+  /**
+   * \brief Write the retained samples to a file
+   * \param filename the name of the file
+   * \param format the format of the file
+   */
+  void Write (std::string filename, Format format) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Record a sample and schedule the next one
+   */
+  void DoSample (void);
+
+  /**
+   * \brief Write the retained samples to the file set by the FileName attribute
+   */
+  void WriteOnDestroy (void);
+
+  Time m_interval;                              //!< Sampling interval
+  uint32_t m_capacity;                          //!< Number of samples of the ring buffer
+  std::string m_fileName;                       //!< File written when the simulator is destroyed
+  Format m_format;                              //!< Format of the file written when the simulator is destroyed
+  Ptr<DualQCoupledCurvyRedQueueDisc> m_queueDisc; //!< Sampled queue disc
+  std::vector<Sample> m_samples;                //!< Ring buffer of samples
+  uint32_t m_next;                              //!< Index where the next sample is stored
+  uint32_t m_count;                             //!< Number of retained samples
+  uint64_t m_overwritten;                       //!< Number of overwritten samples
+  EventId m_sampleEvent;                        //!< Next sampling event
+};
+
+} // namespace ns3
+
+#endif /* DUAL_Q_COUPLED_CURVY_RED_SAMPLER_H */
@@ -30,93 +30,22 @@
 #include "ns3/string.h"
 #include "dual-q-coupled-pi-square-queue-disc.h"
 #include "ns3/drop-tail-queue.h"
-#define min (a,b)((a) < (b) ? (a) : (b))
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("DualQCoupledPiSquareQueueDisc");
 
-class DualQCoupledPiSquareTimestampTag : public Tag
-{
-public:
-  DualQCoupledPiSquareTimestampTag ();
-  /**
-   * \brief Get the type ID.
-   * \return the object TypeId
-   */
-  static TypeId GetTypeId (void);
-  virtual TypeId GetInstanceTypeId (void) const;
-
-  virtual uint32_t GetSerializedSize (void) const;
-  virtual void Serialize (TagBuffer i) const;
-  virtual void Deserialize (TagBuffer i);
-  virtual void Print (std::ostream &os) const;
-
-  /**
-   * \brief Gets the Tag creation time
-   *
-   * \return the time object stored in the tag
-   */
-  Time GetTxTime (void) const;
-
-private:
-  uint64_t m_creationTime; //!< Tag creation time
-};
-
-DualQCoupledPiSquareTimestampTag::DualQCoupledPiSquareTimestampTag ()
-  : m_creationTime (Simulator::Now ().GetTimeStep ())
-{
-}
-
-TypeId
-DualQCoupledPiSquareTimestampTag::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::DualQCoupledPiSquareTimestampTag")
-    .SetParent<Tag> ()
-    .AddConstructor<DualQCoupledPiSquareTimestampTag> ()
-    .AddAttribute ("CreationTime",
-                   "The time at which the timestamp was created",
-                   StringValue ("0.0s"),
-                   MakeTimeAccessor (&DualQCoupledPiSquareTimestampTag::GetTxTime),
-                   MakeTimeChecker ())
-  ;
-  return tid;
-}
-
-TypeId
-DualQCoupledPiSquareTimestampTag::GetInstanceTypeId (void) const
-{
-  return GetTypeId ();
-}
-
-uint32_t
-DualQCoupledPiSquareTimestampTag::GetSerializedSize (void) const
-{
-  return 8; // Why return 8???????
-}
-
-void
-DualQCoupledPiSquareTimestampTag::Serialize (TagBuffer i) const
-{
-  i.WriteU64 (m_creationTime);
-}
-
-void
-DualQCoupledPiSquareTimestampTag::Deserialize (TagBuffer i)
-{
-  m_creationTime = i.ReadU64 ();
-}
-
-void
-DualQCoupledPiSquareTimestampTag::Print (std::ostream &os) const
-{
-  os << "CreationTime=" << m_creationTime;
-}
-
-Time
-DualQCoupledPiSquareTimestampTag::GetTxTime (void) const
+/**
+ * Multiply a value by a Q16 factor, rounding towards zero
+ * \param value the value to multiply
+ * \param factorQ16 the Q16 factor
+ * \return the product, without the 16 fractional bits
+ */
+static inline int64_t
+MulQ16 (int64_t value, int64_t factorQ16)
 {
-  return TimeStep (m_creationTime);
+  int64_t product = value * factorQ16;
+  return (product >= 0) ? (product >> 16) : -((-product) >> 16);
 }
 
 NS_OBJECT_ENSURE_REGISTERED (DualQCoupledPiSquareQueueDisc);
@@ -173,6 +102,11 @@ TypeId DualQCoupledPiSquareQueueDisc::GetTypeId (void)
                    TimeValue (Seconds (0.001)),
                    MakeTimeAccessor (&DualQCoupledPiSquareQueueDisc::m_l4sThreshold),
                    MakeTimeChecker ())
+    .AddAttribute ("FixedPoint",
+                   "True to compute the probabilities in fixed point arithmetic",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DualQCoupledPiSquareQueueDisc::m_fixedPoint),
+                   MakeBooleanChecker ())
     .AddAttribute ("K",
                    "Coupling factor",
                    UintegerValue (2),
@@ -230,13 +164,13 @@ uint32_t
 DualQCoupledPiSquareQueueDisc::GetQueueSize (void)
 {
   NS_LOG_FUNCTION (this);
-  if (GetMode () == QUEUE_DISC_MODE_BYTES)
+  if (m_mode == QUEUE_DISC_MODE_BYTES)
     {
-      return (GetInternalQueue (0)->GetNBytes () + GetInternalQueue (1)->GetNBytes ());
+      return GetInternalQueuesNBytes ();
     }
-  else if (GetMode () == QUEUE_DISC_MODE_PACKETS)
+  else if (m_mode == QUEUE_DISC_MODE_PACKETS)
     {
-      return (GetInternalQueue (0)->GetNPackets () + GetInternalQueue (1)->GetNPackets ());
+      return GetInternalQueuesNPackets ();
     }
   else
     {
@@ -279,17 +213,12 @@ DualQCoupledPiSquareQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   NS_LOG_FUNCTION (this << item);
   uint8_t queueNumber;
 
-  // attach arrival time to packet
-  Ptr<Packet> p = item->GetPacket ();
-  DualQCoupledPiSquareTimestampTag tag;
-  p->AddPacketTag (tag);
-
   uint32_t nQueued = GetQueueSize ();
-  if ((GetMode () == QUEUE_DISC_MODE_PACKETS && nQueued >= m_queueLimit)
-      || (GetMode () == QUEUE_DISC_MODE_BYTES && nQueued + item->GetSize () > m_queueLimit))
+  if ((m_mode == QUEUE_DISC_MODE_PACKETS && nQueued >= m_queueLimit)
+      || (m_mode == QUEUE_DISC_MODE_BYTES && nQueued + item->GetSize () > m_queueLimit))
     {
       // Drops due to queue limit
-      Drop (item);
+      Drop (item, DROP_FORCED);
       m_stats.forcedDrop++;
       return false;
     }
@@ -305,8 +234,8 @@ DualQCoupledPiSquareQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
         }
     }
 
-  bool retval = GetInternalQueue (queueNumber)->Enqueue (item);
-  NS_LOG_LOGIC ("Number packets in queue-number " << queueNumber << ": " << GetInternalQueue (queueNumber)->GetNPackets ());
+  bool retval = EnqueueInternalQueue (queueNumber, item);
+  NS_LOG_LOGIC ("Number packets in queue-number " << queueNumber << ": " << GetInternalQueueNPackets (queueNumber));
   return retval;
 }
 
@@ -316,6 +245,12 @@ DualQCoupledPiSquareQueueDisc::InitializeParams (void)
   m_tShift = 2 * m_classicQueueDelayRef;
   m_alphaU = m_alpha * m_tUpdate.GetSeconds ();
   m_betaU = m_beta * m_tUpdate.GetSeconds ();
+  // A delay of 1 ns times alphaU (betaU) gives a Q32 increment of alphaU * 2^32 / 1e9
+  m_alphaUQ16 = llround (ldexp (m_alphaU, 48) / 1e9);
+  m_betaUQ16 = llround (ldexp (m_betaU, 48) / 1e9);
+  m_dropProbQ32 = 0;
+  m_classicDropProbQ32 = 0;
+  m_l4sDropProbQ32 = 0;
   m_minL4SLength = 2 * m_meanPktSize;
   m_dropProb = 0.0;
   m_qDelayOld = Time (Seconds (0));
@@ -336,9 +271,7 @@ void DualQCoupledPiSquareQueueDisc::CalculateP ()
 
   if ((item = GetInternalQueue (0)->Peek ()) != 0)
     {
-      DualQCoupledPiSquareTimestampTag tag;
-      item->GetPacket ()->PeekPacketTag (tag);
-      qDelay = Simulator::Now () - tag.GetTxTime ();
+      qDelay = Simulator::Now () - item->GetTimeStamp ();
     }
   else
     {
@@ -352,6 +285,14 @@ void DualQCoupledPiSquareQueueDisc::CalculateP ()
       m_rtrsEvent = Simulator::Schedule (m_tUpdate, &DualQCoupledPiSquareQueueDisc::CalculateP, this);
       return;
     }
+  if (m_fixedPoint)
+    {
+      CalculatePFixed (qDelay);
+      m_qDelayOld = qDelay;
+      m_rtrsEvent = Simulator::Schedule (m_tUpdate, &DualQCoupledPiSquareQueueDisc::CalculateP, this);
+      return;
+    }
+
   double delta = m_alphaU * (qDelay.GetSeconds () - m_classicQueueDelayRef.GetSeconds ()) +
     m_betaU * (qDelay.GetSeconds () - m_qDelayOld.GetSeconds ());
 
@@ -373,6 +314,32 @@ void DualQCoupledPiSquareQueueDisc::CalculateP ()
   m_rtrsEvent = Simulator::Schedule (m_tUpdate, &DualQCoupledPiSquareQueueDisc::CalculateP, this);
 }
 
+void
+DualQCoupledPiSquareQueueDisc::CalculatePFixed (Time qDelay)
+{
+  NS_LOG_FUNCTION (this << qDelay);
+  const int64_t one = INT64_C (1) << 32;
+  int64_t qDelayNs = qDelay.GetNanoSeconds ();
+
+  m_dropProbQ32 += MulQ16 (qDelayNs - m_classicQueueDelayRef.GetNanoSeconds (), m_alphaUQ16)
+    + MulQ16 (qDelayNs - m_qDelayOld.GetNanoSeconds (), m_betaUQ16);
+
+  // Non-linear drop in probability: 0.98 is 64225 in Q16 format
+  if ((qDelay == 0) && (m_qDelayOld == 0))
+    {
+      m_dropProbQ32 = MulQ16 (m_dropProbQ32, 64225);
+    }
+
+  m_dropProbQ32 = (m_dropProbQ32 > 0) ? m_dropProbQ32 : 0;
+  m_dropProbQ32 = (m_dropProbQ32 < one) ? m_dropProbQ32 : one;
+
+  // the square of a probability lower than 2^32 fits in 64 bits
+  uint64_t prob = (m_dropProbQ32 < one) ? m_dropProbQ32 : one - 1;
+  m_l4sDropProbQ32 = prob * m_k;
+  m_classicDropProbQ32 = ((prob * prob) >> 32) / m_k;
+  m_dropProb = (double) m_dropProbQ32 / one;
+}
+
 Ptr<QueueDiscItem>
 DualQCoupledPiSquareQueueDisc::DoDequeue ()
 {
@@ -381,15 +348,12 @@ DualQCoupledPiSquareQueueDisc::DoDequeue ()
   Ptr<const QueueDiscItem> item2;
   Time classicQueueTime;
   Time l4sQueueTime;
-  DualQCoupledPiSquareTimestampTag tag1;
-  DualQCoupledPiSquareTimestampTag tag2;
 
   while (GetQueueSize () > 0)
     {
       if ((item1 = GetInternalQueue (0)->Peek ()) != 0)
         {
-          item1->GetPacket ()->PeekPacketTag (tag1);
-          classicQueueTime = tag1.GetTxTime ();
+          classicQueueTime = item1->GetTimeStamp ();
         }
       else
         {
@@ -398,8 +362,7 @@ DualQCoupledPiSquareQueueDisc::DoDequeue ()
 
       if ((item2 = GetInternalQueue (1)->Peek ()) != 0)
         {
-          item2->GetPacket ()->PeekPacketTag (tag2);
-          l4sQueueTime = tag2.GetTxTime ();
+          l4sQueueTime = item2->GetTimeStamp ();
         }
       else
         {
@@ -408,20 +371,27 @@ DualQCoupledPiSquareQueueDisc::DoDequeue ()
 
       if (l4sQueueTime.GetSeconds () + m_tShift.GetSeconds () >= classicQueueTime.GetSeconds () && GetInternalQueue (1)->Peek () != 0 )
         {
-          Ptr<QueueDiscItem> item = GetInternalQueue (1)->Dequeue ();
-          DualQCoupledPiSquareTimestampTag tag;
-          item->GetPacket ()->PeekPacketTag (tag);
+          Ptr<QueueDiscItem> item = DequeueInternalQueue (1);
           bool minL4SQueueSizeFlag = false;
-          if (GetMode () == QUEUE_DISC_MODE_BYTES && GetInternalQueue (1)->GetNBytes () > 2 * m_meanPktSize)
+          if (m_mode == QUEUE_DISC_MODE_BYTES && GetInternalQueueNBytes (1) > 2 * m_meanPktSize)
             {
               minL4SQueueSizeFlag = true;
             }
-          else if (GetMode () == QUEUE_DISC_MODE_PACKETS && GetInternalQueue (1)->GetNPackets () > 2 )
+          else if (m_mode == QUEUE_DISC_MODE_PACKETS && GetInternalQueueNPackets (1) > 2 )
             {
               minL4SQueueSizeFlag = true;
             }
 
-          if ((Simulator::Now () - tag.GetTxTime () > m_l4sThreshold && minL4SQueueSizeFlag) || (m_l4sDropProb > m_uv->GetValue ()))
+          bool mark = (Simulator::Now () - item->GetTimeStamp () > m_l4sThreshold && minL4SQueueSizeFlag);
+          if (!mark && m_fixedPoint)
+            {
+              mark = m_l4sDropProbQ32 > m_uv->GetInteger (0, UINT32_MAX);
+            }
+          else if (!mark)
+            {
+              mark = m_l4sDropProb > m_uv->GetValue ();
+            }
+          if (mark)
             {
               item->Mark ();
               m_stats.unforcedL4SMark++;
@@ -431,12 +401,21 @@ DualQCoupledPiSquareQueueDisc::DoDequeue ()
 
       else
         {
-          Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
-          if (m_classicDropProb / (m_k * 1.0) >  m_uv->GetValue ())
+          Ptr<QueueDiscItem> item = DequeueInternalQueue (0);
+          bool drop;
+          if (m_fixedPoint)
+            {
+              drop = m_classicDropProbQ32 > m_uv->GetInteger (0, UINT32_MAX);
+            }
+          else
+            {
+              drop = m_classicDropProb / (m_k * 1.0) >  m_uv->GetValue ();
+            }
+          if (drop)
             {
               if (!item->Mark ())
                 {
-                  Drop (item);
+                  Drop (item, DROP_UNFORCED);
                   m_stats.unforcedClassicDrop++;
                   continue;
                 }
@@ -491,9 +470,11 @@ DualQCoupledPiSquareQueueDisc::CheckConfig (void)
 
   if (GetNInternalQueues () == 0)
     {
-      // Create 2 DropTail queues
-      Ptr<InternalQueue> queue1 = CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> > ("Mode", EnumValue (m_mode));
-      Ptr<InternalQueue> queue2 = CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> > ("Mode", EnumValue (m_mode));
+      // Create the 2 internal queues (DropTail by default)
+      Ptr<InternalQueue> queue1 = CreateInternalQueue ();
+      Ptr<InternalQueue> queue2 = CreateInternalQueue ();
+      queue1->SetAttribute ("Mode", EnumValue (m_mode));
+      queue2->SetAttribute ("Mode", EnumValue (m_mode));
       if (m_mode == QUEUE_DISC_MODE_PACKETS)
         {
           queue1->SetMaxPackets (m_queueLimit);
@@ -514,6 +495,12 @@ DualQCoupledPiSquareQueueDisc::CheckConfig (void)
       return false;
     }
 
+  if (m_fixedPoint && m_k == 0)
+    {
+      NS_LOG_ERROR ("The coupling factor cannot be zero in fixed point mode");
+      return false;
+    }
+
   if ((GetInternalQueue (0)->GetMode () == QueueBase::QUEUE_MODE_PACKETS && m_mode == QUEUE_DISC_MODE_BYTES)
       || (GetInternalQueue (0)->GetMode () == QueueBase::QUEUE_MODE_BYTES && m_mode == QUEUE_DISC_MODE_PACKETS))
     {
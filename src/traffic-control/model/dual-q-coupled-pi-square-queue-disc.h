@@ -162,6 +162,12 @@ private:
    */
   void CalculateP ();
 
+  /**
+   * \brief Update the probabilities in fixed point arithmetic
+   * \param qDelay the queuing time of the first-in Classic packet
+   */
+  void CalculatePFixed (Time qDelay);
+
   Stats m_stats;                                //!< DualQ Coupled PI Square statistics
 
   // ** Variables supplied by user
@@ -175,6 +181,7 @@ private:
   Time m_l4sThreshold;                          //!< L4S marking threshold (in time)
   uint32_t m_k;                                 //!< Coupling factor
   uint32_t m_queueLimit;                        //!< Queue limit in bytes / packets
+  bool m_fixedPoint;                            //!< True to compute the probabilities in fixed point
 
   // ** Variables maintained by DualQ Coupled PI Square
   Time m_classicQueueTime;                      //!< Arrival time of a packet of Classic Traffic
@@ -186,6 +193,11 @@ private:
   double m_l4sDropProb;                         //!< Variable used in calculation of drop probability of L4S traffic
   double m_alphaU;                              //!< Parameter to PI Square controller
   double m_betaU;                               //!< Parameter to PI Square controller
+  int64_t m_alphaUQ16;                          //!< Q16 factor converting a delay in ns into a Q32 probability increment (alpha)
+  int64_t m_betaUQ16;                           //!< Q16 factor converting a delay in ns into a Q32 probability increment (beta)
+  int64_t m_dropProbQ32;                        //!< Drop probability in Q32 format (fixed point mode)
+  uint64_t m_classicDropProbQ32;                //!< Drop probability of Classic traffic divided by k, in Q32 format
+  uint64_t m_l4sDropProbQ32;                    //!< Drop probability of L4S traffic in Q32 format
   Time m_qDelayOld;                             //!< Old value of queue delay
   Time m_qDelay;                                //!< Current value of queue delay
   EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
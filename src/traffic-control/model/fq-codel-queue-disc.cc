@@ -123,6 +123,12 @@ TypeId FqCoDelQueueDisc::GetTypeId (void)
                    UintegerValue (64),
                    MakeUintegerAccessor (&FqCoDelQueueDisc::m_dropBatchSize),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Perturbation",
+                   "The salt used as an additional input to the hash function used to classify "
+                   "packets when no packet filter is installed",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_perturbation),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -132,6 +138,8 @@ FqCoDelQueueDisc::FqCoDelQueueDisc ()
     m_overlimitDroppedPackets (0)
 {
   NS_LOG_FUNCTION (this);
+  m_newFlows.head = m_newFlows.tail = NO_SLOT;
+  m_oldFlows.head = m_oldFlows.tail = NO_SLOT;
 }
 
 FqCoDelQueueDisc::~FqCoDelQueueDisc ()
@@ -139,6 +147,44 @@ FqCoDelQueueDisc::~FqCoDelQueueDisc ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+FqCoDelQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flowTable.clear ();
+  m_newFlows.head = m_newFlows.tail = NO_SLOT;
+  m_oldFlows.head = m_oldFlows.tail = NO_SLOT;
+  QueueDisc::DoDispose ();
+}
+
+void
+FqCoDelQueueDisc::PushBack (FlowList &list, uint32_t slot)
+{
+  m_flowTable[slot].next = NO_SLOT;
+  if (list.tail == NO_SLOT)
+    {
+      list.head = slot;
+    }
+  else
+    {
+      m_flowTable[list.tail].next = slot;
+    }
+  list.tail = slot;
+}
+
+uint32_t
+FqCoDelQueueDisc::PopFront (FlowList &list)
+{
+  NS_ASSERT (list.head != NO_SLOT);
+  uint32_t slot = list.head;
+  list.head = m_flowTable[slot].next;
+  if (list.head == NO_SLOT)
+    {
+      list.tail = NO_SLOT;
+    }
+  return slot;
+}
+
 void
 FqCoDelQueueDisc::SetQuantum (uint32_t quantum)
 {
@@ -157,44 +203,48 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  int32_t ret = Classify (item);
+  uint32_t h;
 
-  if (ret == PacketFilter::PF_NO_MATCH)
+  if (GetNPacketFilters () == 0)
     {
-      NS_LOG_ERROR ("No filter has been able to classify this packet, drop it.");
-      Drop (item);
-      return false;
+      // use the hash of the 5-tuple computed and cached by the item
+      h = item->Hash (m_perturbation) % m_flows;
     }
+  else
+    {
+      int32_t ret = Classify (item);
 
-  uint32_t h = ret % m_flows;
+      if (ret == PacketFilter::PF_NO_MATCH)
+        {
+          NS_LOG_ERROR ("No filter has been able to classify this packet, drop it.");
+          Drop (item);
+          return false;
+        }
 
-  Ptr<FqCoDelFlow> flow;
-  if (m_flowsIndices.find (h) == m_flowsIndices.end ())
+      h = ret % m_flows;
+    }
+
+  FlowSlot &slot = m_flowTable[h];
+  if (slot.flow == 0)
     {
       NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
-      flow = m_flowFactory.Create<FqCoDelFlow> ();
+      slot.flow = m_flowFactory.Create<FqCoDelFlow> ();
       Ptr<QueueDisc> qd = m_queueDiscFactory.Create<QueueDisc> ();
       qd->Initialize ();
-      flow->SetQueueDisc (qd);
-      AddQueueDiscClass (flow);
-
-      m_flowsIndices[h] = GetNQueueDiscClasses () - 1;
-    }
-  else
-    {
-      flow = StaticCast<FqCoDelFlow> (GetQueueDiscClass (m_flowsIndices[h]));
+      slot.flow->SetQueueDisc (qd);
+      AddQueueDiscClass (slot.flow);
     }
 
-  if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
+  if (slot.flow->GetStatus () == FqCoDelFlow::INACTIVE)
     {
-      flow->SetStatus (FqCoDelFlow::NEW_FLOW);
-      flow->SetDeficit (m_quantum);
-      m_newFlows.push_back (flow);
+      slot.flow->SetStatus (FqCoDelFlow::NEW_FLOW);
+      slot.flow->SetDeficit (m_quantum);
+      PushBack (m_newFlows, h);
     }
 
-  flow->GetQueueDisc ()->Enqueue (item);
+  slot.flow->GetQueueDisc ()->Enqueue (item);
 
-  NS_LOG_DEBUG ("Packet enqueued into flow " << h << "; flow index " << m_flowsIndices[h]);
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h);
 
   if (GetNPackets () > m_limit)
     {
@@ -209,23 +259,22 @@ FqCoDelQueueDisc::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<FqCoDelFlow> flow;
+  FqCoDelFlow *flow = 0;
   Ptr<QueueDiscItem> item;
 
   do
     {
       bool found = false;
 
-      while (!found && !m_newFlows.empty ())
+      while (!found && m_newFlows.head != NO_SLOT)
         {
-          flow = m_newFlows.front ();
+          flow = PeekPointer (m_flowTable[m_newFlows.head].flow);
 
           if (flow->GetDeficit () <= 0)
             {
               flow->IncreaseDeficit (m_quantum);
               flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              PushBack (m_oldFlows, PopFront (m_newFlows));
             }
           else
             {
@@ -234,15 +283,14 @@ FqCoDelQueueDisc::DoDequeue (void)
             }
         }
 
-      while (!found && !m_oldFlows.empty ())
+      while (!found && m_oldFlows.head != NO_SLOT)
         {
-          flow = m_oldFlows.front ();
+          flow = PeekPointer (m_flowTable[m_oldFlows.head].flow);
 
           if (flow->GetDeficit () <= 0)
             {
               flow->IncreaseDeficit (m_quantum);
-              m_oldFlows.push_back (flow);
-              m_oldFlows.pop_front ();
+              PushBack (m_oldFlows, PopFront (m_oldFlows));
             }
           else
             {
@@ -262,16 +310,15 @@ FqCoDelQueueDisc::DoDequeue (void)
       if (!item)
         {
           NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
-          if (!m_newFlows.empty ())
+          if (m_newFlows.head != NO_SLOT)
             {
               flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              PushBack (m_oldFlows, PopFront (m_newFlows));
             }
           else
             {
               flow->SetStatus (FqCoDelFlow::INACTIVE);
-              m_oldFlows.pop_front ();
+              PopFront (m_oldFlows);
             }
         }
       else
@@ -290,17 +337,17 @@ FqCoDelQueueDisc::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<FqCoDelFlow> flow;
+  uint32_t slot;
 
-  if (!m_newFlows.empty ())
+  if (m_newFlows.head != NO_SLOT)
     {
-      flow = m_newFlows.front ();
+      slot = m_newFlows.head;
     }
   else
     {
-      if (!m_oldFlows.empty ())
+      if (m_oldFlows.head != NO_SLOT)
         {
-          flow = m_oldFlows.front ();
+          slot = m_oldFlows.head;
         }
       else
         {
@@ -308,7 +355,7 @@ FqCoDelQueueDisc::DoPeek (void) const
         }
     }
 
-  return flow->GetQueueDisc ()->Peek ();
+  return m_flowTable[slot].flow->GetQueueDisc ()->Peek ();
 }
 
 bool
@@ -321,15 +368,15 @@ FqCoDelQueueDisc::CheckConfig (void)
       return false;
     }
 
-  if (GetNPacketFilters () == 0)
+  if (GetNInternalQueues () > 0)
     {
-      NS_LOG_ERROR ("FqCoDelQueueDisc needs at least a packet filter");
+      NS_LOG_ERROR ("FqCoDelQueueDisc cannot have internal queues");
       return false;
     }
 
-  if (GetNInternalQueues () > 0)
+  if (m_flows == 0)
     {
-      NS_LOG_ERROR ("FqCoDelQueueDisc cannot have internal queues");
+      NS_LOG_ERROR ("FqCoDelQueueDisc needs at least a flow queue");
       return false;
     }
 
@@ -358,6 +405,13 @@ FqCoDelQueueDisc::InitializeParams (void)
   m_queueDiscFactory.Set ("MaxPackets", UintegerValue (m_limit + 1));
   m_queueDiscFactory.Set ("Interval", StringValue (m_interval));
   m_queueDiscFactory.Set ("Target", StringValue (m_target));
+
+  // the flow table is allocated once, with a slot per flow hash value
+  FlowSlot empty;
+  empty.next = NO_SLOT;
+  m_flowTable.assign (m_flows, empty);
+  m_newFlows.head = m_newFlows.tail = NO_SLOT;
+  m_oldFlows.head = m_oldFlows.tail = NO_SLOT;
 }
 
 uint32_t
@@ -24,8 +24,7 @@
 
 #include "ns3/queue-disc.h"
 #include "ns3/object-factory.h"
-#include <list>
-#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -126,6 +125,12 @@ public:
     */
    uint32_t GetQuantum (void) const;
 
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
 private:
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
@@ -133,6 +138,41 @@ private:
   virtual bool CheckConfig (void);
   virtual void InitializeParams (void);
 
+  /**
+   * \brief Slot of the flow table
+   *
+   * The flow table has one slot per flow hash value. The new and old flow
+   * lists are linked through the slots, so that no list node is allocated.
+   */
+  struct FlowSlot
+  {
+    Ptr<FqCoDelFlow> flow;     //!< The flow, null until the first packet of the flow
+    uint32_t next;             //!< The next slot in the list of new or old flows
+  };
+
+  /**
+   * \brief Intrusive list of flows linked through the flow table
+   */
+  struct FlowList
+  {
+    uint32_t head;             //!< The first slot of the list
+    uint32_t tail;             //!< The last slot of the list
+  };
+
+  /**
+   * \brief Append a slot to a list of flows
+   * \param list the list of flows
+   * \param slot the index of the slot
+   */
+  void PushBack (FlowList &list, uint32_t slot);
+
+  /**
+   * \brief Remove the first slot of a (non empty) list of flows
+   * \param list the list of flows
+   * \return the index of the removed slot
+   */
+  uint32_t PopFront (FlowList &list);
+
   /**
    * \brief Drop a packet from the head of the queue with the largest current byte count
    * \return the index of the queue with the largest current byte count
@@ -145,13 +185,15 @@ private:
   uint32_t m_quantum;        //!< Deficit assigned to flows at each round
   uint32_t m_flows;          //!< Number of flow queues
   uint32_t m_dropBatchSize;  //!< Max number of packets dropped from the fat flow
+  uint32_t m_perturbation;   //!< hash perturbation value used when no packet filter is installed
 
   uint32_t m_overlimitDroppedPackets; //!< Number of overlimit dropped packets
 
-  std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
-  std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
+  static const uint32_t NO_SLOT = 0xffffffff;   //!< Marks the end of a list of flows
 
-  std::map<uint32_t, uint32_t> m_flowsIndices;    //!< Map with the index of class for each flow
+  std::vector<FlowSlot> m_flowTable;   //!< The flow table, indexed by the flow hash
+  FlowList m_newFlows;                 //!< The list of new flows
+  FlowList m_oldFlows;                 //!< The list of old flows
 
   ObjectFactory m_flowFactory;         //!< Factory to create a new flow
   ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
@@ -20,19 +20,25 @@
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
+#include "ns3/string.h"
 #include "ns3/object-vector.h"
 #include "ns3/packet.h"
+#include "ns3/simulator.h"
 #include "ns3/socket.h"
 #include "ns3/unused.h"
 #include "queue-disc.h"
 #include <ns3/drop-tail-queue.h>
+#include "ns3/ring-buffer-queue.h"
 #include "ns3/net-device-queue-interface.h"
+#include <algorithm>
 
 namespace ns3 {
 
 NS_OBJECT_TEMPLATE_CLASS_DEFINE (Queue,QueueDiscItem);
 NS_OBJECT_TEMPLATE_CLASS_DEFINE (DropTailQueue,QueueDiscItem);
+NS_OBJECT_TEMPLATE_CLASS_DEFINE (RingBufferQueue,QueueDiscItem);
 
 NS_LOG_COMPONENT_DEFINE ("QueueDisc");
 
@@ -99,6 +105,16 @@ TypeId QueueDisc::GetTypeId (void)
                    MakeUintegerAccessor (&QueueDisc::SetQuota,
                                          &QueueDisc::GetQuota),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("BurstSize", "The maximum number of packets sent to the device at once "
+                   "(1 sends packets one at a time)",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&QueueDisc::m_burstSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("InternalQueueType", "The type of the internal queues created by "
+                   "the queue discs that support it (e.g., ns3::RingBufferQueue)",
+                   StringValue ("ns3::DropTailQueue<QueueDiscItem>"),
+                   MakeStringAccessor (&QueueDisc::SetInternalQueueType),
+                   MakeStringChecker ())
     .AddAttribute ("InternalQueueList", "The list of internal queues.",
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QueueDisc::m_queues),
@@ -111,6 +127,21 @@ TypeId QueueDisc::GetTypeId (void)
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QueueDisc::m_classes),
                    MakeObjectVectorChecker<QueueDiscClass> ())
+    .AddAttribute ("SojournHistogram",
+                   "True to record the sojourn times of the dequeued packets in "
+                   "histograms, for the queue disc and for each internal queue",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QueueDisc::m_useSojournHistogram),
+                   MakeBooleanChecker ())
+    .AddAttribute ("DropTraceBatchSize",
+                   "Number of drops traced at once: if not zero, the Drop trace "
+                   "is deferred until this number of packets are dropped (or "
+                   "FlushDropTrace is called) and the DropBatch trace is fired "
+                   "with all of them; the sinks then see the time of the flush, not "
+                   "the time of each drop. If zero, the Drop trace is fired at each drop",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&QueueDisc::m_dropTraceBatchSize),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Enqueue", "Enqueue a packet in the queue disc",
                      MakeTraceSourceAccessor (&QueueDisc::m_traceEnqueue),
                      "ns3::QueueDiscItem::TracedCallback")
@@ -123,6 +154,10 @@ TypeId QueueDisc::GetTypeId (void)
     .AddTraceSource ("Drop", "Drop a packet stored in the queue disc",
                      MakeTraceSourceAccessor (&QueueDisc::m_traceDrop),
                      "ns3::QueueDiscItem::TracedCallback")
+    .AddTraceSource ("DropBatch", "Drop a batch of packets stored in the queue disc "
+                     "(only if DropTraceBatchSize is not zero)",
+                     MakeTraceSourceAccessor (&QueueDisc::m_traceDropBatch),
+                     "ns3::QueueDisc::DropBatchTracedCallback")
     .AddTraceSource ("PacketsInQueue",
                      "Number of packets currently stored in the queue disc",
                      MakeTraceSourceAccessor (&QueueDisc::m_nPackets),
@@ -144,9 +179,19 @@ QueueDisc::QueueDisc ()
      m_nTotalDroppedBytes (0),
      m_nTotalRequeuedPackets (0),
      m_nTotalRequeuedBytes (0),
-     m_running (false)
+     m_dropTraceBatchSize (0),
+     m_burstSize (1),
+     m_running (false),
+     m_useSojournHistogram (false)
 {
   NS_LOG_FUNCTION (this);
+  m_totalOccupancy.nPackets = 0;
+  m_totalOccupancy.nBytes = 0;
+  for (uint32_t i = 0; i < DROP_N_REASONS; i++)
+    {
+      m_dropCounters[i].nPackets = 0;
+      m_dropCounters[i].nBytes = 0;
+    }
 }
 
 QueueDisc::~QueueDisc ()
@@ -158,12 +203,16 @@ void
 QueueDisc::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  FlushDropTrace ();
   m_queues.clear ();
+  m_occupancy.clear ();
   m_filters.clear ();
   m_classes.clear ();
   m_device = 0;
   m_devQueueIface = 0;
-  m_requeued = 0;
+  m_requeued.clear ();
+  m_burst.clear ();
+  m_sojournHistograms.clear ();
   Object::DoDispose ();
 }
 
@@ -184,6 +233,20 @@ QueueDisc::DoInitialize (void)
   NS_UNUSED (ok); // suppress compiler warning
   InitializeParams ();
 
+  // the deferred drops are stored without allocating memory
+  m_dropBatch.reserve (m_dropTraceBatchSize);
+
+  if (m_useSojournHistogram)
+    {
+      // the histograms are allocated once, the one of the queue disc first
+      m_sojournHistograms.reserve (m_queues.size () + 1);
+      m_sojournHistograms.resize (1);
+      for (uint32_t i = 0; i < m_queues.size (); i++)
+        {
+          AddInternalQueueSojournHistogram (i);
+        }
+    }
+
   // Check the configuration and initialize the parameters of the child queue discs
   for (std::vector<Ptr<QueueDiscClass> >::iterator cl = m_classes.begin ();
        cl != m_classes.end (); cl++)
@@ -250,6 +313,22 @@ QueueDisc:: GetTotalRequeuedBytes (void) const
   return m_nTotalRequeuedBytes;
 }
 
+uint32_t
+QueueDisc::GetDroppedPackets (DropReason reason) const
+{
+  NS_LOG_FUNCTION (this << reason);
+  NS_ASSERT (reason < DROP_N_REASONS);
+  return m_dropCounters[reason].nPackets;
+}
+
+uint32_t
+QueueDisc::GetDroppedBytes (DropReason reason) const
+{
+  NS_LOG_FUNCTION (this << reason);
+  NS_ASSERT (reason < DROP_N_REASONS);
+  return m_dropCounters[reason].nBytes;
+}
+
 void
 QueueDisc::SetNetDevice (Ptr<NetDevice> device)
 {
@@ -284,8 +363,136 @@ QueueDisc::AddInternalQueue (Ptr<InternalQueue> queue)
   NS_LOG_FUNCTION (this);
   // set the drop callback on the internal queue, so that the queue disc is
   // notified of packets dropped by the internal queue
-  queue->TraceConnectWithoutContext ("Drop", MakeCallback (&QueueDisc::Drop, this));
+  queue->TraceConnectWithoutContext ("Drop", MakeCallback (&QueueDisc::DropFromInternalQueue, this));
+  // keep the occupancy counters up to date however the subclass accesses the
+  // queue (a packet removed by the queue is traced by DropAfterDequeue)
+  uint32_t i = m_queues.size ();
+  queue->TraceConnectWithoutContext ("Enqueue",
+                                     MakeCallback (&QueueDisc::InternalQueueEnqueued, this).Bind (i));
+  queue->TraceConnectWithoutContext ("Dequeue",
+                                     MakeCallback (&QueueDisc::InternalQueueDequeued, this).Bind (i));
+  queue->TraceConnectWithoutContext ("DropAfterDequeue",
+                                     MakeCallback (&QueueDisc::InternalQueueDequeued, this).Bind (i));
   m_queues.push_back (queue);
+  InternalQueueOccupancy occupancy;
+  occupancy.nPackets = queue->GetNPackets ();
+  occupancy.nBytes = queue->GetNBytes ();
+  m_occupancy.push_back (occupancy);
+  m_totalOccupancy.nPackets += occupancy.nPackets;
+  m_totalOccupancy.nBytes += occupancy.nBytes;
+  // queues added after the initialization get their histogram here
+  if (!m_sojournHistograms.empty ())
+    {
+      AddInternalQueueSojournHistogram (m_queues.size () - 1);
+    }
+}
+
+bool
+QueueDisc::EnqueueInternalQueue (uint32_t i, Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << i << item);
+  NS_ASSERT (i < m_queues.size ());
+  bool ret = m_queues[i]->Enqueue (item);
+  NS_ASSERT_MSG (m_occupancy[i].nPackets == m_queues[i]->GetNPackets ()
+                 && m_occupancy[i].nBytes == m_queues[i]->GetNBytes (),
+                 "The occupancy counters of internal queue " << i << " are out of date");
+  return ret;
+}
+
+Ptr<QueueDiscItem>
+QueueDisc::DequeueInternalQueue (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_queues.size ());
+  Ptr<QueueDiscItem> item = m_queues[i]->Dequeue ();
+  NS_ASSERT_MSG (m_occupancy[i].nPackets == m_queues[i]->GetNPackets ()
+                 && m_occupancy[i].nBytes == m_queues[i]->GetNBytes (),
+                 "The occupancy counters of internal queue " << i << " are out of date");
+  return item;
+}
+
+void
+QueueDisc::InternalQueueEnqueued (uint32_t i, Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << i << item);
+  uint32_t size = item->GetSize ();
+  m_occupancy[i].nPackets++;
+  m_occupancy[i].nBytes += size;
+  m_totalOccupancy.nPackets++;
+  m_totalOccupancy.nBytes += size;
+}
+
+void
+QueueDisc::InternalQueueDequeued (uint32_t i, Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << i << item);
+  uint32_t size = item->GetSize ();
+  m_occupancy[i].nPackets--;
+  m_occupancy[i].nBytes -= size;
+  m_totalOccupancy.nPackets--;
+  m_totalOccupancy.nBytes -= size;
+}
+
+void
+QueueDisc::AddInternalQueueSojournHistogram (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (m_sojournHistograms.size () == i + 1);
+  m_sojournHistograms.push_back (SojournHistogram ());
+  m_queues[i]->TraceConnectWithoutContext ("Dequeue",
+                                           MakeCallback (&QueueDisc::RecordInternalQueueSojourn, this).Bind (i));
+}
+
+void
+QueueDisc::RecordInternalQueueSojourn (uint32_t i, Ptr<const QueueDiscItem> item)
+{
+  m_sojournHistograms[i + 1].Record (Simulator::Now () - item->GetTimeStamp ());
+}
+
+bool
+QueueDisc::IsSojournHistogramEnabled (void) const
+{
+  return m_useSojournHistogram;
+}
+
+const SojournHistogram&
+QueueDisc::GetSojournHistogram (void) const
+{
+  NS_ASSERT_MSG (!m_sojournHistograms.empty (), "Sojourn histograms are not enabled or the queue disc is not initialized");
+  return m_sojournHistograms[0];
+}
+
+const SojournHistogram&
+QueueDisc::GetInternalQueueSojournHistogram (uint32_t i) const
+{
+  NS_ASSERT_MSG (i + 1 < m_sojournHistograms.size (), "No sojourn histogram for internal queue " << i);
+  return m_sojournHistograms[i + 1];
+}
+
+void
+QueueDisc::ResetSojournHistograms (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<SojournHistogram>::iterator h = m_sojournHistograms.begin ();
+       h != m_sojournHistograms.end (); h++)
+    {
+      h->Reset ();
+    }
+}
+
+void
+QueueDisc::SetInternalQueueType (std::string type)
+{
+  NS_LOG_FUNCTION (this << type);
+  QueueBase::AppendItemTypeIfNotPresent (type, "QueueDiscItem");
+  m_queueFactory.SetTypeId (type);
+}
+
+Ptr<QueueDisc::InternalQueue>
+QueueDisc::CreateInternalQueue (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_queueFactory.Create<InternalQueue> ();
 }
 
 Ptr<QueueDisc::InternalQueue>
@@ -332,7 +539,7 @@ QueueDisc::AddQueueDiscClass (Ptr<QueueDiscClass> qdClass)
                    "A queue disc with WAKE_CHILD as wake mode can only be a root queue disc");
   // set the parent drop callback on the child queue disc, so that it can notify
   // packet drops to the parent queue disc
-  qdClass->GetQueueDisc ()->SetParentDropCallback (MakeCallback (&QueueDisc::Drop, this));
+  qdClass->GetQueueDisc ()->SetParentDropCallback (MakeCallback (&QueueDisc::DropFromChildQueueDisc, this));
   m_classes.push_back (qdClass);
 }
 
@@ -376,9 +583,9 @@ QueueDisc::SetParentDropCallback (ParentDropCallback cb)
 }
 
 void
-QueueDisc::Drop (Ptr<const QueueDiscItem> item)
+QueueDisc::Drop (Ptr<const QueueDiscItem> item, DropReason reason)
 {
-  NS_LOG_FUNCTION (this << item);
+  NS_LOG_FUNCTION (this << item << reason);
 
   // if the wake mode of this queue disc is WAKE_CHILD, packets are directly
   // enqueued/dequeued from the child queue discs, thus this queue disc does not
@@ -393,17 +600,74 @@ QueueDisc::Drop (Ptr<const QueueDiscItem> item)
                  << " is reported to be dropped is greater than the amount of bytes"
                  << "stored in the queue disc");
 
+  uint32_t size = item->GetSize ();
   m_nPackets--;
-  m_nBytes -= item->GetSize ();
+  m_nBytes -= size;
   m_nTotalDroppedPackets++;
-  m_nTotalDroppedBytes += item->GetSize ();
+  m_nTotalDroppedBytes += size;
+  m_dropCounters[reason].nPackets++;
+  m_dropCounters[reason].nBytes += size;
 
-  NS_LOG_LOGIC ("m_traceDrop (p)");
-  m_traceDrop (item);
+  if (m_dropTraceBatchSize == 0)
+    {
+      NS_LOG_LOGIC ("m_traceDrop (p)");
+      m_traceDrop (item);
+    }
+  else if (!m_traceDrop.IsEmpty () || !m_traceDropBatch.IsEmpty ())
+    {
+      // defer the trace, the items are only kept if somebody is listening
+      m_dropBatch.push_back (item);
+      if (m_dropBatch.size () >= m_dropTraceBatchSize)
+        {
+          FlushDropTrace ();
+        }
+    }
 
   NotifyParentDrop (item);
 }
 
+void
+QueueDisc::FlushDropTrace (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_dropBatch.empty ())
+    {
+      return;
+    }
+
+  // A sink may cause further drops, and even flush them before we return:
+  // the items traced here are moved out of the batch first, so that they
+  // are neither traced twice nor cleared under our feet
+  std::vector<Ptr<const QueueDiscItem> > batch;
+  batch.swap (m_dropBatch);
+  NS_LOG_LOGIC ("m_traceDropBatch (" << batch.size () << " items)");
+  m_traceDropBatch (batch);
+  for (uint32_t i = 0; i < batch.size (); i++)
+    {
+      m_traceDrop (batch[i]);
+    }
+  batch.clear ();
+  if (m_dropBatch.empty ())
+    {
+      // no drop meanwhile: keep the preallocated array
+      m_dropBatch.swap (batch);
+    }
+}
+
+void
+QueueDisc::DropFromInternalQueue (Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  Drop (item, DROP_INTERNAL_QUEUE);
+}
+
+void
+QueueDisc::DropFromChildQueueDisc (Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  Drop (item, DROP_CHILD_QUEUE_DISC);
+}
+
 void
 QueueDisc::NotifyParentDrop (Ptr<const QueueDiscItem> item)
 {
@@ -425,6 +689,9 @@ QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
   m_nTotalReceivedPackets++;
   m_nTotalReceivedBytes += item->GetSize ();
 
+  // record the arrival time, used by AQMs to compute the sojourn time
+  item->SetTimeStamp (Simulator::Now ());
+
   NS_LOG_LOGIC ("m_traceEnqueue (p)");
   m_traceEnqueue (item);
 
@@ -444,6 +711,11 @@ QueueDisc::Dequeue (void)
       m_nPackets--;
       m_nBytes -= item->GetSize ();
 
+      if (!m_sojournHistograms.empty ())
+        {
+          m_sojournHistograms[0].Record (Simulator::Now () - item->GetTimeStamp ());
+        }
+
       NS_LOG_LOGIC ("m_traceDequeue (p)");
       m_traceDequeue (item);
     }
@@ -451,6 +723,25 @@ QueueDisc::Dequeue (void)
   return item;
 }
 
+uint32_t
+QueueDisc::DequeueBurst (uint32_t n, std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << n);
+
+  uint32_t count = 0;
+  while (count < n)
+    {
+      Ptr<QueueDiscItem> item = Dequeue ();
+      if (item == 0)
+        {
+          break;
+        }
+      items.push_back (item);
+      count++;
+    }
+  return count;
+}
+
 Ptr<const QueueDiscItem>
 QueueDisc::Peek (void) const
 {
@@ -466,13 +757,29 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      if (m_burstSize > 1)
+        {
+          uint32_t sent;
+          while (RestartBurst (std::min (quota, m_burstSize), sent))
+            {
+              quota -= sent;
+              if (quota <= 0)
+                {
+                  /// \todo netif_schedule (q);
+                  break;
+                }
+            }
+        }
+      else
         {
-          quota -= 1;
-          if (quota <= 0)
+          while (Restart ())
             {
-              /// \todo netif_schedule (q);
-              break;
+              quota -= 1;
+              if (quota <= 0)
+                {
+                  /// \todo netif_schedule (q);
+                  break;
+                }
             }
         }
       RunEnd ();
@@ -513,6 +820,58 @@ QueueDisc::Restart (void)
   return Transmit (item);
 }
 
+bool
+QueueDisc::RestartBurst (uint32_t n, uint32_t &sent)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT (m_devQueueIface);
+
+  // As in Linux, bulk dequeue is only performed for single queue devices
+  if (!m_requeued.empty () || m_devQueueIface->GetNTxQueues () > 1)
+    {
+      sent = 1;
+      return Restart ();
+    }
+
+  sent = 0;
+  if (m_devQueueIface->GetTxQueue (0)->IsStopped ())
+    {
+      return false;
+    }
+
+  if (DequeueBurst (n, m_burst) == 0)
+    {
+      NS_LOG_LOGIC ("No packet to send");
+      return false;
+    }
+
+  // a single queue device makes no use of the priority tag
+  SocketPriorityTag priorityTag;
+  for (std::vector<Ptr<QueueDiscItem> >::iterator it = m_burst.begin (); it != m_burst.end (); it++)
+    {
+      (*it)->AddHeader ();
+      (*it)->GetPacket ()->RemovePacketTag (priorityTag);
+    }
+
+  sent = m_device->SendBurst (m_burst);
+  NS_ASSERT (sent <= m_burst.size ());
+
+  // the packets not consumed by the device (whose queue has been stopped) are requeued
+  bool requeued = (sent < m_burst.size ());
+  for (uint32_t i = sent; i < m_burst.size (); i++)
+    {
+      Requeue (m_burst[i]);
+    }
+  m_burst.clear ();
+
+  if (requeued || GetNPackets () == 0 || m_devQueueIface->GetTxQueue (0)->IsStopped ())
+    {
+      return false;
+    }
+
+  return true;
+}
+
 Ptr<QueueDiscItem>
 QueueDisc::DequeuePacket ()
 {
@@ -521,15 +880,15 @@ QueueDisc::DequeuePacket ()
   Ptr<QueueDiscItem> item;
 
   // First check if there is a requeued packet
-  if (m_requeued != 0)
+  if (!m_requeued.empty ())
     {
         // If the queue where the requeued packet is destined to is not stopped, return
         // the requeued packet; otherwise, return an empty packet.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        if (!m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            item = m_requeued.front ();
+            m_requeued.pop_front ();
 
             m_nPackets--;
             m_nBytes -= item->GetSize ();
@@ -563,7 +922,7 @@ void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  m_requeued.push_back (item);
   /// \todo netif_schedule (q);
 
   m_nPackets++;       // it's still part of the queue
@@ -21,11 +21,14 @@
 #define QUEUE_DISC_H
 
 #include "ns3/object.h"
+#include "ns3/object-factory.h"
 #include "ns3/traced-value.h"
 #include "ns3/net-device.h"
 #include "ns3/queue-item.h"
 #include <vector>
+#include <deque>
 #include "packet-filter.h"
+#include "sojourn-histogram.h"
 
 namespace ns3 {
 
@@ -129,6 +132,29 @@ public:
   QueueDisc ();
   virtual ~QueueDisc ();
 
+  /**
+   * \brief Enumeration of the reasons why a packet is dropped, for which
+   *        separate counters are kept
+   */
+  enum DropReason
+    {
+      DROP_UNSPECIFIED = 0,   /**< Reason not given by the queue disc */
+      DROP_INTERNAL_QUEUE,    /**< Dropped by an internal queue (e.g., because it is full) */
+      DROP_CHILD_QUEUE_DISC,  /**< Dropped by a child queue disc */
+      DROP_FORCED,            /**< Dropped because the queue disc limit is exceeded */
+      DROP_UNFORCED,          /**< Dropped by the AQM algorithm (e.g., RED early drop) */
+      DROP_OTHER,             /**< Dropped for a reason specific to the queue disc (e.g., queue protection) */
+      DROP_N_REASONS          /**< Number of drop reasons */
+    };
+
+  /**
+   * TracedCallback signature for the batches of dropped items.
+   *
+   * \param [in] items The items dropped since the previous batch.
+   */
+  typedef void (* DropBatchTracedCallback)
+    (const std::vector<Ptr<const QueueDiscItem> > &items);
+
   /**
    * \brief Get the number of packets stored by the queue disc
    * \return the number of packets stored by the queue disc.
@@ -191,6 +217,30 @@ public:
    */
   uint32_t GetTotalRequeuedBytes (void) const;
 
+  /**
+   * \brief Get the number of packets dropped for the given reason
+   * \param reason the drop reason
+   * \return the number of packets dropped for the given reason.
+   */
+  uint32_t GetDroppedPackets (DropReason reason) const;
+
+  /**
+   * \brief Get the amount of bytes dropped for the given reason
+   * \param reason the drop reason
+   * \return the amount of bytes dropped for the given reason.
+   */
+  uint32_t GetDroppedBytes (DropReason reason) const;
+
+  /**
+   * \brief Fire the Drop and DropBatch traces for the drops deferred so far
+   *
+   * Only needed if the DropTraceBatchSize attribute is not zero: deferred drops
+   * are traced when the batch is full, when this method is called and when the
+   * queue disc is disposed. Call this method before reading the results of
+   * the trace sinks, e.g., at the end of the simulation.
+   */
+  void FlushDropTrace (void);
+
   /**
    * \brief Set the NetDevice on which this queue discipline is installed.
    * \param device the NetDevice on which this queue discipline is installed.
@@ -232,6 +282,16 @@ public:
    */
   Ptr<QueueDiscItem> Dequeue (void);
 
+  /**
+   * Request the queue discipline to extract up to n packets. This function
+   * calls Dequeue until n packets are extracted or the queue disc returns no
+   * packet.
+   * \param n the maximum number of packets to extract
+   * \param items the vector the extracted items are appended to
+   * \return the number of extracted items
+   */
+  uint32_t DequeueBurst (uint32_t n, std::vector<Ptr<QueueDiscItem> > &items);
+
   /**
    * Get a copy of the next packet the queue discipline will extract, without
    * actually extracting the packet. This function only calls the (private)
@@ -269,6 +329,48 @@ public:
    */
   uint32_t GetNInternalQueues (void) const;
 
+  /**
+   * \brief Set the type of the internal queues created by CreateInternalQueue
+   * \param type the queue type (e.g., "ns3::RingBufferQueue"). The item type
+   *        is appended if not present
+   */
+  void SetInternalQueueType (std::string type);
+
+  /**
+   * \brief Check whether sojourn times are recorded in histograms
+   * \return the value of the SojournHistogram attribute
+   */
+  bool IsSojournHistogramEnabled (void) const;
+
+  /**
+   * \brief Get the histogram of the sojourn times of the packets dequeued
+   *        from the queue disc
+   *
+   * The sojourn time is the time elapsed since the packet was enqueued in the
+   * queue disc. Requires the SojournHistogram attribute to be true and the
+   * queue disc to be initialized.
+   *
+   * \return the histogram of the sojourn times.
+   */
+  const SojournHistogram& GetSojournHistogram (void) const;
+
+  /**
+   * \brief Get the histogram of the sojourn times of the packets dequeued
+   *        from the i-th internal queue
+   *
+   * Requires the SojournHistogram attribute to be true and the queue disc to
+   * be initialized.
+   *
+   * \param i the index of the internal queue
+   * \return the histogram of the sojourn times.
+   */
+  const SojournHistogram& GetInternalQueueSojournHistogram (uint32_t i) const;
+
+  /**
+   * \brief Discard the sojourn times recorded so far (e.g., at the end of a warm-up period)
+   */
+  void ResetSojournHistograms (void);
+
   /**
    * \brief Add a packet filter to the tail of the list of filters used to classify packets.
    * \param filter the packet filter to be added
@@ -371,9 +473,62 @@ protected:
   /**
    *  \brief Drop a packet
    *  \param item item that was dropped
+   *  \param reason the reason of the drop, counted separately
    *  This method is called by subclasses to notify parent (this class) of packet drops.
    */
-  void Drop (Ptr<const QueueDiscItem> item);
+  void Drop (Ptr<const QueueDiscItem> item, DropReason reason = DROP_UNSPECIFIED);
+
+  /**
+   * \brief Create an internal queue of the type set by the InternalQueueType attribute
+   * \return the internal queue, which is not added to the list of internal queues
+   */
+  Ptr<InternalQueue> CreateInternalQueue (void) const;
+
+  /**
+   * \brief Enqueue an item in the i-th internal queue
+   *
+   * The occupancy counters are updated by the traces of the internal queues,
+   * hence they are also correct if a subclass accesses its internal queues
+   * directly; this method additionally checks them in debug builds.
+   *
+   * \param i the index of the queue
+   * \param item the item to enqueue
+   * \return true if the item was enqueued, false if the queue dropped it
+   */
+  bool EnqueueInternalQueue (uint32_t i, Ptr<QueueDiscItem> item);
+
+  /**
+   * \brief Dequeue an item from the i-th internal queue and check its occupancy counters
+   * \param i the index of the queue
+   * \return the dequeued item, or 0 if the queue is empty
+   */
+  Ptr<QueueDiscItem> DequeueInternalQueue (uint32_t i);
+
+  /**
+   * \brief Get the number of packets in the i-th internal queue from the occupancy counters
+   * \param i the index of the queue
+   * \return the number of packets
+   */
+  uint32_t GetInternalQueueNPackets (uint32_t i) const;
+
+  /**
+   * \brief Get the number of bytes in the i-th internal queue from the occupancy counters
+   * \param i the index of the queue
+   * \return the number of bytes
+   */
+  uint32_t GetInternalQueueNBytes (uint32_t i) const;
+
+  /**
+   * \brief Get the number of packets in all the internal queues from the occupancy counters
+   * \return the number of packets
+   */
+  uint32_t GetInternalQueuesNPackets (void) const;
+
+  /**
+   * \brief Get the number of bytes in all the internal queues from the occupancy counters
+   * \return the number of bytes
+   */
+  uint32_t GetInternalQueuesNBytes (void) const;
 
 private:
   /**
@@ -399,6 +554,46 @@ private:
    */
   void NotifyParentDrop (Ptr<const QueueDiscItem> item);
 
+  /**
+   *  \brief Account for a packet dropped by an internal queue
+   *  \param item item that was dropped
+   */
+  void DropFromInternalQueue (Ptr<const QueueDiscItem> item);
+
+  /**
+   *  \brief Account for a packet dropped by a child queue disc
+   *  \param item item that was dropped
+   */
+  void DropFromChildQueueDisc (Ptr<const QueueDiscItem> item);
+
+  /**
+   * \brief Allocate the sojourn histograms and connect to the Dequeue trace of
+   *        the internal queue with the given index
+   * \param i the index of the internal queue
+   */
+  void AddInternalQueueSojournHistogram (uint32_t i);
+
+  /**
+   * \brief Record the sojourn time of a packet dequeued from an internal queue
+   * \param i the index of the internal queue
+   * \param item the dequeued item
+   */
+  void RecordInternalQueueSojourn (uint32_t i, Ptr<const QueueDiscItem> item);
+
+  /**
+   * \brief Update the occupancy counters for a packet enqueued in an internal queue
+   * \param i the index of the internal queue
+   * \param item the enqueued item
+   */
+  void InternalQueueEnqueued (uint32_t i, Ptr<const QueueDiscItem> item);
+
+  /**
+   * \brief Update the occupancy counters for a packet dequeued or removed from an internal queue
+   * \param i the index of the internal queue
+   * \param item the dequeued or removed item
+   */
+  void InternalQueueDequeued (uint32_t i, Ptr<const QueueDiscItem> item);
+
   /**
    * This function actually enqueues a packet into the queue disc.
    * \param item item to enqueue
@@ -450,6 +645,18 @@ private:
    */
   bool Restart (void);
 
+  /**
+   * Modelled after the bulk dequeue of the Linux function dequeue_skb (net/sched/sch_generic.c)
+   * Dequeue up to n packets (by calling DequeueBurst) and send them to the device
+   * at once (by calling NetDevice::SendBurst). The packets not consumed by the
+   * device are requeued. Devices with multiple transmission queues and requeued
+   * packets are served by Restart.
+   * \param n the maximum number of packets to send
+   * \param sent the number of packets sent to the device
+   * \return true if the device queue is not stopped and the queue disc is not empty
+   */
+  bool RestartBurst (uint32_t n, uint32_t &sent);
+
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
    * \return the requeued packet, if any, or the packet dequeued by the queue disc, otherwise.
@@ -474,9 +681,25 @@ private:
 
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
+  /// Occupancy of an internal queue
+  struct InternalQueueOccupancy
+  {
+    uint32_t nPackets;   //!< Number of packets
+    uint32_t nBytes;     //!< Number of bytes
+  };
+
   std::vector<Ptr<InternalQueue> > m_queues;    //!< Internal queues
   std::vector<Ptr<PacketFilter> > m_filters;    //!< Packet filters
   std::vector<Ptr<QueueDiscClass> > m_classes;  //!< Classes
+  std::vector<InternalQueueOccupancy> m_occupancy; //!< Occupancy of the internal queues
+  InternalQueueOccupancy m_totalOccupancy;      //!< Occupancy of all the internal queues
+
+  /// Packets and bytes dropped for a reason
+  struct DropCounters
+  {
+    uint32_t nPackets;   //!< Number of packets
+    uint32_t nBytes;     //!< Number of bytes
+  };
 
   TracedValue<uint32_t> m_nPackets; //!< Number of packets in the queue
   TracedValue<uint32_t> m_nBytes;   //!< Number of bytes in the queue
@@ -487,12 +710,21 @@ private:
   uint32_t m_nTotalDroppedBytes;    //!< Total dropped bytes
   uint32_t m_nTotalRequeuedPackets; //!< Total requeued packets
   uint32_t m_nTotalRequeuedBytes;   //!< Total requeued bytes
+  DropCounters m_dropCounters[DROP_N_REASONS]; //!< Dropped packets and bytes per reason
+  uint32_t m_dropTraceBatchSize;    //!< Number of drops traced at once (0 to trace each drop)
+  std::vector<Ptr<const QueueDiscItem> > m_dropBatch; //!< Drops not traced yet
   uint32_t m_quota;                 //!< Maximum number of packets dequeued in a qdisc run
+  uint32_t m_burstSize;             //!< Maximum number of packets sent to the device at once
+  ObjectFactory m_queueFactory;     //!< Factory of the internal queues
   Ptr<NetDevice> m_device;          //!< The NetDevice on which this queue discipline is installed
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
+  std::deque<Ptr<QueueDiscItem> > m_requeued;   //!< The packets that failed to be transmitted
+  std::vector<Ptr<QueueDiscItem> > m_burst;     //!< The burst being sent to the device
   ParentDropCallback m_parentDropCallback;   //!< Parent drop callback
+  bool m_useSojournHistogram;       //!< Record the sojourn times in histograms
+  /// Sojourn histograms: the queue disc one first, then one per internal queue
+  std::vector<SojournHistogram> m_sojournHistograms;
 
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const QueueDiscItem> > m_traceEnqueue;
@@ -502,8 +734,41 @@ private:
   TracedCallback<Ptr<const QueueDiscItem> > m_traceRequeue;
   /// Traced callback: fired when a packet is dropped
   TracedCallback<Ptr<const QueueDiscItem> > m_traceDrop;
+  /// Traced callback: fired with the batch of dropped items when drops are traced in batches
+  TracedCallback<const std::vector<Ptr<const QueueDiscItem> > &> m_traceDropBatch;
 };
 
+
+/**
+ * Implementation of the inline methods declared above.
+ */
+
+inline uint32_t
+QueueDisc::GetInternalQueueNPackets (uint32_t i) const
+{
+  NS_ASSERT (i < m_occupancy.size ());
+  return m_occupancy[i].nPackets;
+}
+
+inline uint32_t
+QueueDisc::GetInternalQueueNBytes (uint32_t i) const
+{
+  NS_ASSERT (i < m_occupancy.size ());
+  return m_occupancy[i].nBytes;
+}
+
+inline uint32_t
+QueueDisc::GetInternalQueuesNPackets (void) const
+{
+  return m_totalOccupancy.nPackets;
+}
+
+inline uint32_t
+QueueDisc::GetInternalQueuesNBytes (void) const
+{
+  return m_totalOccupancy.nBytes;
+}
+
 } // namespace ns3
 
 #endif /* QueueDisc */
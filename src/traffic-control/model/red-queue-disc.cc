@@ -362,6 +362,12 @@ RedQueueDisc::GetStats ()
   return m_stats;
 }
 
+double
+RedQueueDisc::GetAverageQueueSize (void) const
+{
+  return m_qAvg;
+}
+
 int64_t 
 RedQueueDisc::AssignStreams (int64_t stream)
 {
@@ -457,7 +463,7 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
         {
           NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
           m_stats.unforcedDrop++;
-          Drop (item);
+          Drop (item, DROP_UNFORCED);
           return false;
         }
       NS_LOG_DEBUG ("\t Marking due to Prob Mark " << m_qAvg);
@@ -469,7 +475,7 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
         {
           NS_LOG_DEBUG ("\t Dropping due to Hard Mark " << m_qAvg);
           m_stats.forcedDrop++;
-          Drop (item);
+          Drop (item, DROP_FORCED);
           if (m_isNs1Compat)
             {
               m_count = 0;
@@ -610,6 +616,15 @@ RedQueueDisc::InitializeParams (void)
       m_qW = 1.0 - std::exp (-10.0 / m_ptc);
     }
 
+  // Precompute the powers of (1 - m_qW) used by the estimator, so that no
+  // transcendental function is called per packet: m_decay[k] = (1 - m_qW)^(2^k)
+  m_decay[0] = 1.0 - m_qW;
+  for (uint32_t k = 1; k < DECAY_TABLE_SIZE; k++)
+    {
+      m_decay[k] = m_decay[k - 1] * m_decay[k - 1];
+    }
+  m_cautiousFraction = std::pow ((1 - m_qW), m_ptc * 0.05);
+
   if (m_bottom == 0)
     {
       m_bottom = 0.01;
@@ -690,7 +705,20 @@ RedQueueDisc::Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW)
 {
   NS_LOG_FUNCTION (this << nQueued << m << qAvg << qW);
 
-  double newAve = qAvg * pow(1.0-qW, m);
+  double newAve;
+  if (qW != m_qW)
+    {
+      newAve = qAvg * std::pow (1.0 - qW, m);
+    }
+  else if (m == 1)
+    {
+      // no idle period: the common case
+      newAve = qAvg * m_decay[0];
+    }
+  else
+    {
+      newAve = qAvg * Decay (m);
+    }
   newAve += qW * nQueued;
 
   Time now = Simulator::Now ();
@@ -706,6 +734,21 @@ RedQueueDisc::Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW)
   return newAve;
 }
 
+double
+RedQueueDisc::Decay (uint32_t m) const
+{
+  // square-and-multiply over the bits of m, using the precomputed squares;
+  // the factor is selected by indexing rather than by a branch, which would
+  // be mispredicted as the bits of m are irregular
+  double decay = 1.0;
+  for (uint32_t k = 0; m != 0; k++, m >>= 1)
+    {
+      const double factor[2] = { 1.0, m_decay[k] };
+      decay *= factor[m & 1];
+    }
+  return decay;
+}
+
 // Check if packet p needs to be dropped due to probability mark
 uint32_t
 RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
@@ -721,12 +764,9 @@ RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
       /*
        * Don't drop/mark if the instantaneous queue is much below the average.
        * For experimental purposes only.
-       * pkts: the number of packets arriving in 50 ms
+       * m_cautiousFraction: decay of the average over the packets arriving in 50 ms
        */
-      double pkts = m_ptc * 0.05;
-      double fraction = std::pow ((1 - m_qW), pkts);
-
-      if ((double) qSize < fraction * m_qAvg)
+      if ((double) qSize < m_cautiousFraction * m_qAvg)
         {
           // Queue could have been empty for 0.05 seconds
           return 0;
@@ -741,11 +781,9 @@ RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
        * Decrease the drop probability if the instantaneous
        * queue is much below the average.
        * For experimental purposes only.
-       * pkts: the number of packets arriving in 50 ms
+       * m_cautiousFraction: decay of the average over the packets arriving in 50 ms
        */
-      double pkts = m_ptc * 0.05;
-      double fraction = std::pow ((1 - m_qW), pkts);
-      double ratio = qSize / (fraction * m_qAvg);
+      double ratio = qSize / (m_cautiousFraction * m_qAvg);
 
       if (ratio < 1.0)
         {
@@ -947,8 +985,9 @@ RedQueueDisc::CheckConfig (void)
 
   if (GetNInternalQueues () == 0)
     {
-      // create a DropTail queue
-      Ptr<InternalQueue> queue = CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> > ("Mode", EnumValue (m_mode));
+      // create the internal queue (DropTail by default)
+      Ptr<InternalQueue> queue = CreateInternalQueue ();
+      queue->SetAttribute ("Mode", EnumValue (m_mode));
       if (m_mode == QUEUE_DISC_MODE_PACKETS)
         {
           queue->SetMaxPackets (m_queueLimit);
@@ -239,6 +239,13 @@ public:
    */
   Stats GetStats ();
 
+  /**
+   * \brief Get the average queue size computed by the EWMA estimator
+   *
+   * \returns The average queue size (bytes or packets).
+   */
+  double GetAverageQueueSize (void) const;
+
  /**
   * Assign a fixed random variable stream number to the random variables
   * used by this model.  Return the number of streams (possibly zero) that
@@ -279,6 +286,12 @@ private:
    * \returns new average queue size
    */
   double Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW);
+  /**
+   * \brief Compute (1 - m_qW)^m from the decay table, without calling pow
+   * \param m the exponent
+   * \returns (1 - m_qW)^m
+   */
+  double Decay (uint32_t m) const;
    /**
     * \brief Update m_curMaxP
     * \param newAve new average queue length
@@ -354,6 +367,9 @@ private:
   uint32_t m_idle;          //!< 0/1 idle status
   double m_ptc;             //!< packet time constant in packets/second
   double m_qAvg;            //!< Average queue length
+  static const uint32_t DECAY_TABLE_SIZE = 32; //!< One entry per bit of the exponent
+  double m_decay[DECAY_TABLE_SIZE]; //!< m_decay[k] = (1 - m_qW)^(2^k)
+  double m_cautiousFraction; //!< (1 - m_qW)^(packets arriving in 50 ms), used by m_cautious 1 and 2
   uint32_t m_count;         //!< Number of packets since last random number generation
   FengStatus m_fengStatus;  //!< For use in Feng's Adaptive RED
   /**
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "sojourn-histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ns3 {
+
+const uint32_t SojournHistogram::SUB_BUCKET_BITS;
+const uint32_t SojournHistogram::MAX_EXPONENT;
+const uint32_t SojournHistogram::SUB_BUCKETS;
+const uint32_t SojournHistogram::HALF_SUB_BUCKETS;
+const uint32_t SojournHistogram::N_BUCKETS;
+
+/**
+ * \brief Get the position of the most significant bit set
+ * \param value the value, which must not be zero
+ * \return the position of the most significant bit set
+ */
+static inline uint32_t
+MostSignificantBit (uint64_t value)
+{
+#if defined (__GNUC__)
+  return 63 - __builtin_clzll (value);
+#else
+  uint32_t msb = 0;
+  while (value >>= 1)
+    {
+      msb++;
+    }
+  return msb;
+#endif
+}
+
+SojournHistogram::SojournHistogram ()
+{
+  Reset ();
+}
+
+void
+SojournHistogram::Reset (void)
+{
+  std::memset (m_counts, 0, sizeof (m_counts));
+  m_count = 0;
+  m_sum = 0;
+  m_min = 0;
+  m_max = 0;
+}
+
+uint32_t
+SojournHistogram::GetBucketIndex (uint64_t value)
+{
+  if (value < SUB_BUCKETS)
+    {
+      return value;
+    }
+  uint32_t msb = MostSignificantBit (value);
+  if (msb > MAX_EXPONENT)
+    {
+      return N_BUCKETS - 1;
+    }
+  // keep the SUB_BUCKET_BITS most significant bits: the top one selects the
+  // power of two, the others the linear bucket within it
+  uint32_t shift = msb - (SUB_BUCKET_BITS - 1);
+  return SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + (value >> shift) - HALF_SUB_BUCKETS;
+}
+
+uint64_t
+SojournHistogram::GetBucketHighestValue (uint32_t index)
+{
+  NS_ASSERT (index < N_BUCKETS);
+  if (index < SUB_BUCKETS)
+    {
+      return index;
+    }
+  uint32_t shift = (index - SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+  uint64_t sub = (index - SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+  return ((sub + 1) << shift) - 1;
+}
+
+void
+SojournHistogram::Record (Time sojourn)
+{
+  int64_t ns = sojourn.GetNanoSeconds ();
+  uint64_t value = ns > 0 ? ns : 0;
+
+  m_counts[GetBucketIndex (value)]++;
+  if (m_count == 0 || value < m_min)
+    {
+      m_min = value;
+    }
+  if (value > m_max)
+    {
+      m_max = value;
+    }
+  m_count++;
+  m_sum += value;
+}
+
+uint64_t
+SojournHistogram::GetCount (void) const
+{
+  return m_count;
+}
+
+Time
+SojournHistogram::GetMin (void) const
+{
+  return NanoSeconds (m_min);
+}
+
+Time
+SojournHistogram::GetMax (void) const
+{
+  return NanoSeconds (m_max);
+}
+
+Time
+SojournHistogram::GetMean (void) const
+{
+  if (m_count == 0)
+    {
+      return Time (0);
+    }
+  return NanoSeconds (m_sum / m_count);
+}
+
+Time
+SojournHistogram::GetPercentile (double percentile) const
+{
+  NS_ASSERT (percentile >= 0 && percentile <= 100);
+  if (m_count == 0)
+    {
+      return Time (0);
+    }
+
+  // rank of the percentile among the recorded values, starting from 1
+  uint64_t rank = static_cast<uint64_t> (std::ceil (percentile / 100 * m_count));
+  rank = std::max<uint64_t> (rank, 1);
+
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < N_BUCKETS; i++)
+    {
+      seen += m_counts[i];
+      if (seen >= rank)
+        {
+          return NanoSeconds (std::min (GetBucketHighestValue (i), m_max));
+        }
+    }
+  return NanoSeconds (m_max);
+}
+
+} // namespace ns3
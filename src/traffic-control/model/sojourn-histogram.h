@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SOJOURN_HISTOGRAM_H
+#define SOJOURN_HISTOGRAM_H
+
+#include "ns3/nstime.h"
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Log-linear histogram of sojourn times
+ *
+ * Sojourn times are recorded in nanoseconds into a fixed array of buckets
+ * laid out as in HdrHistogram: values below 2^SUB_BUCKET_BITS have a bucket
+ * each, and every further power of two is split into 2^(SUB_BUCKET_BITS-1)
+ * linear buckets. Hence recording a value costs a bit scan and an increment,
+ * the memory is fixed and the value reported for a percentile exceeds the
+ * recorded value by less than 2^-(SUB_BUCKET_BITS-1) (about 3%). Values of
+ * 2^(MAX_EXPONENT+1) ns (about 73 minutes) or more are counted in the last
+ * bucket.
+ */
+class SojournHistogram
+{
+public:
+  static const uint32_t SUB_BUCKET_BITS = 6;   //!< Bits of precision of a bucket
+  static const uint32_t MAX_EXPONENT = 41;     //!< Exponent of the largest value with its own bucket
+  static const uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;       //!< Number of buckets below 2^SUB_BUCKET_BITS
+  static const uint32_t HALF_SUB_BUCKETS = SUB_BUCKETS / 2;       //!< Number of buckets per further power of two
+  static const uint32_t N_BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * HALF_SUB_BUCKETS; //!< Number of buckets
+
+  /**
+   * \brief SojournHistogram Constructor
+   */
+  SojournHistogram ();
+
+  /**
+   * \brief Record a sojourn time
+   * \param sojourn the sojourn time (negative values are recorded as zero)
+   */
+  void Record (Time sojourn);
+
+  /**
+   * \brief Discard all the recorded sojourn times
+   */
+  void Reset (void);
+
+  /**
+   * \brief Get the number of recorded sojourn times
+   * \return the number of recorded sojourn times
+   */
+  uint64_t GetCount (void) const;
+
+  /**
+   * \brief Get the smallest recorded sojourn time
+   * \return the smallest recorded sojourn time, or zero if none was recorded
+   */
+  Time GetMin (void) const;
+
+  /**
+   * \brief Get the largest recorded sojourn time
+   * \return the largest recorded sojourn time, or zero if none was recorded
+   */
+  Time GetMax (void) const;
+
+  /**
+   * \brief Get the mean of the recorded sojourn times
+   * \return the mean of the recorded sojourn times, or zero if none was recorded
+   */
+  Time GetMean (void) const;
+
+  /**
+   * \brief Get a percentile of the recorded sojourn times
+   *
+   * The percentile is computed by scanning the buckets, hence this method is
+   * meant to be called at the end of (or sporadically during) a simulation.
+   *
+   * \param percentile the percentile, in [0, 100] (e.g., 99.9)
+   * \return the largest value of the bucket holding the percentile, capped at
+   *         the largest recorded sojourn time, or zero if none was recorded
+   */
+  Time GetPercentile (double percentile) const;
+
+  /**
+   * \brief Get the index of the bucket counting a value
+   * \param value the value, in nanoseconds
+   * \return the index of the bucket
+   */
+  static uint32_t GetBucketIndex (uint64_t value);
+
+  /**
+   * \brief Get the largest value counted by a bucket
+   * \param index the index of the bucket
+   * \return the largest value counted by the bucket, in nanoseconds
+   */
+  static uint64_t GetBucketHighestValue (uint32_t index);
+
+private:
+  uint64_t m_counts[N_BUCKETS];   //!< Number of values recorded per bucket
+  uint64_t m_count;               //!< Number of recorded values
+  uint64_t m_sum;                 //!< Sum of the recorded values (ns)
+  uint64_t m_min;                 //!< Smallest recorded value (ns)
+  uint64_t m_max;                 //!< Largest recorded value (ns)
+};
+
+} // namespace ns3
+
+#endif /* SOJOURN_HISTOGRAM_H */
@@ -23,12 +23,21 @@
 
 #include "ns3/test.h"
 #include "ns3/dual-q-coupled-curvy-red-queue-disc.h"
+#include "ns3/dual-q-coupled-curvy-red-sampler.h"
+#include "ns3/mq-queue-disc.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/data-rate.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include <cmath>
+#include <fstream>
 
 using namespace ns3;
 
@@ -124,7 +133,7 @@ private:
   void EnqueueWithDelay (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t size, uint32_t nPkt, StringValue trafficType);
   void Dequeue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt);
   void DequeueWithDelay (Ptr<DualQCoupledCurvyRedQueueDisc> queue, double delay, uint32_t nPkt);
-  void RunCurvyRedTest (StringValue mode);
+  void RunCurvyRedTest (StringValue mode, bool fixedPoint);
 };
 
 DualQCoupledCurvyRedQueueDiscTestCase::DualQCoupledCurvyRedQueueDiscTestCase ()
@@ -133,7 +142,7 @@ DualQCoupledCurvyRedQueueDiscTestCase::DualQCoupledCurvyRedQueueDiscTestCase ()
 }
 
 void
-DualQCoupledCurvyRedQueueDiscTestCase::RunCurvyRedTest (StringValue mode)
+DualQCoupledCurvyRedQueueDiscTestCase::RunCurvyRedTest (StringValue mode, bool fixedPoint)
 {
   uint32_t pktSize = 0;
 
@@ -147,6 +156,8 @@ DualQCoupledCurvyRedQueueDiscTestCase::RunCurvyRedTest (StringValue mode)
   // test 1: simple enqueue/dequeue with defaults, no drops
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
 
   Address dest;
 
@@ -213,6 +224,8 @@ DualQCoupledCurvyRedQueueDiscTestCase::RunCurvyRedTest (StringValue mode)
   pktSize = 1000;  // pktSize != 0 because DequeueThreshold always works in bytes
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
                          "Verify that we can actually set the attribute QueueLimit");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("K0", UintegerValue (1)), true,
@@ -242,6 +255,8 @@ DualQCoupledCurvyRedQueueDiscTestCase::RunCurvyRedTest (StringValue mode)
   queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
                          "Verify that we can actually set the attribute QueueLimit");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("K0", UintegerValue (1)), true,
@@ -268,6 +283,8 @@ DualQCoupledCurvyRedQueueDiscTestCase::RunCurvyRedTest (StringValue mode)
   queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
                          "Verify that we can actually set the attribute QueueLimit");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("K0", UintegerValue (1)), true,
@@ -340,8 +357,906 @@ DualQCoupledCurvyRedQueueDiscTestCase::DequeueWithDelay (Ptr<DualQCoupledCurvyRe
 void
 DualQCoupledCurvyRedQueueDiscTestCase::DoRun (void)
 {
-  RunCurvyRedTest (StringValue ("QUEUE_DISC_MODE_PACKETS"));
-  RunCurvyRedTest (StringValue ("QUEUE_DISC_MODE_BYTES"));
+  RunCurvyRedTest (StringValue ("QUEUE_DISC_MODE_PACKETS"), false);
+  RunCurvyRedTest (StringValue ("QUEUE_DISC_MODE_BYTES"), false);
+  RunCurvyRedTest (StringValue ("QUEUE_DISC_MODE_PACKETS"), true);
+  RunCurvyRedTest (StringValue ("QUEUE_DISC_MODE_BYTES"), true);
+  Simulator::Destroy ();
+}
+
+class DualQCoupledCurvyRedMarkingEngineTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedMarkingEngineTestCase ();
+  virtual void DoRun (void);
+private:
+  double GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MarkingEngine engine, double prob, uint32_t u, bool fixedPoint = false);
+};
+
+DualQCoupledCurvyRedMarkingEngineTestCase::DualQCoupledCurvyRedMarkingEngineTestCase ()
+  : TestCase ("Check that the single draw marking engine matches the MaxRand engine")
+{
+}
+
+double
+DualQCoupledCurvyRedMarkingEngineTestCase::GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MarkingEngine engine, double prob, uint32_t u, bool fixedPoint)
+{
+  uint32_t nSamples = 20000;
+  uint32_t nHits = 0;
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("MarkingEngine", EnumValue (engine));
+  queue->AssignStreams (1);
+  for (uint32_t i = 0; i < nSamples; i++)
+    {
+      bool hit;
+      if (fixedPoint)
+        {
+          hit = queue->CurvyRedDecisionFixed ((uint64_t) (prob * 4294967296.0), u);
+        }
+      else
+        {
+          hit = queue->CurvyRedDecision (prob, u);
+        }
+      if (hit)
+        {
+          nHits++;
+        }
+    }
+  return (double) nHits / nSamples;
+}
+
+void
+DualQCoupledCurvyRedMarkingEngineTestCase::DoRun (void)
+{
+  uint32_t curviness[] = { 1, 2, 4, 8 };
+  double probs[] = { 0.3, 0.6, 0.9 };
+
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      for (uint32_t j = 0; j < 3; j++)
+        {
+          // L4S marks use Curviness random numbers, Classic drops use twice as many
+          for (uint32_t u = curviness[i]; u <= 2 * curviness[i]; u += curviness[i])
+            {
+              double expected = std::pow (probs[j], (int) u);
+              double maxRandRate = GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_MAXRAND, probs[j], u);
+              double singleDrawRate = GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_SINGLE_DRAW, probs[j], u);
+              NS_TEST_EXPECT_MSG_EQ_TOL (maxRandRate, expected, 0.02, "MaxRand rate does not match prob^U");
+              NS_TEST_EXPECT_MSG_EQ_TOL (singleDrawRate, expected, 0.02, "Single draw rate does not match prob^U");
+              NS_TEST_EXPECT_MSG_EQ_TOL (singleDrawRate, maxRandRate, 0.03, "Single draw and MaxRand rates should match");
+              double maxRandFixedRate = GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_MAXRAND, probs[j], u, true);
+              double singleDrawFixedRate = GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_SINGLE_DRAW, probs[j], u, true);
+              NS_TEST_EXPECT_MSG_EQ_TOL (maxRandFixedRate, expected, 0.02, "Fixed point MaxRand rate does not match prob^U");
+              NS_TEST_EXPECT_MSG_EQ_TOL (singleDrawFixedRate, expected, 0.02, "Fixed point single draw rate does not match prob^U");
+            }
+        }
+    }
+
+  // Boundary probabilities are decided without randomness by both engines
+  NS_TEST_EXPECT_MSG_EQ (GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_SINGLE_DRAW, 0, 4), 0, "Zero probability should never mark");
+  NS_TEST_EXPECT_MSG_EQ (GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_MAXRAND, 0, 4), 0, "Zero probability should never mark");
+  NS_TEST_EXPECT_MSG_EQ (GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_SINGLE_DRAW, 1.5, 4), 1, "Saturated probability should always mark");
+  NS_TEST_EXPECT_MSG_EQ (GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_MAXRAND, 1.5, 4), 1, "Saturated probability should always mark");
+  NS_TEST_EXPECT_MSG_EQ (GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_SINGLE_DRAW, 0, 4, true), 0, "Zero probability should never mark");
+  NS_TEST_EXPECT_MSG_EQ (GetDecisionRate (DualQCoupledCurvyRedQueueDisc::MARKING_ENGINE_SINGLE_DRAW, 1.5, 4, true), 1, "Saturated probability should always mark");
+}
+
+class DualQCoupledCurvyRedSchedulerTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedSchedulerTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<DualQCoupledCurvyRedQueueDisc> CreateQueue (DualQCoupledCurvyRedQueueDisc::Scheduler scheduler);
+  void Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, StringValue trafficType);
+  void Dequeue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt);
+};
+
+DualQCoupledCurvyRedSchedulerTestCase::DualQCoupledCurvyRedSchedulerTestCase ()
+  : TestCase ("Check the schedulers between the L4S and Classic queues")
+{
+}
+
+Ptr<DualQCoupledCurvyRedQueueDisc>
+DualQCoupledCurvyRedSchedulerTestCase::CreateQueue (DualQCoupledCurvyRedQueueDisc::Scheduler scheduler)
+{
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (100));
+  // avoid unforced Classic drops, so that every dequeue returns a packet
+  queue->SetAttribute ("ClassicQueueScalingFactor", DoubleValue (30));
+  queue->SetAttribute ("Scheduler", EnumValue (scheduler));
+  queue->SetAttribute ("TimeShift", TimeValue (Seconds (0.01)));
+  queue->SetAttribute ("L4SWeight", UintegerValue (3));
+  queue->SetAttribute ("ClassicWeight", UintegerValue (1));
+  queue->Initialize ();
+  return queue;
+}
+
+void
+DualQCoupledCurvyRedSchedulerTestCase::Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, StringValue trafficType)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      if (trafficType.Get () == "L4S")
+        {
+          queue->Enqueue (Create<DualQueueL4SQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+      else
+        {
+          queue->Enqueue (Create<DualQueueClassicQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+    }
+}
+
+void
+DualQCoupledCurvyRedSchedulerTestCase::Dequeue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "A packet should have been dequeued");
+    }
+}
+
+void
+DualQCoupledCurvyRedSchedulerTestCase::DoRun (void)
+{
+  // Strict priority: the Classic queue is starved while the L4S queue is backlogged
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateQueue (DualQCoupledCurvyRedQueueDisc::SCHEDULER_STRICT_PRIORITY);
+  Enqueue (queue, 20, StringValue ("Classic"));
+  Enqueue (queue, 20, StringValue ("L4S"));
+  Dequeue (queue, 20);
+  DualQCoupledCurvyRedQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedL4SPackets, 20, "Strict priority should only serve the L4S queue");
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedClassicPackets, 0, "Strict priority should starve the Classic queue");
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedL4SBytes, 20000, "Wrong number of L4S bytes dequeued");
+
+  // WRR with weights 3:1
+  queue = CreateQueue (DualQCoupledCurvyRedQueueDisc::SCHEDULER_WRR);
+  Enqueue (queue, 20, StringValue ("Classic"));
+  Enqueue (queue, 20, StringValue ("L4S"));
+  Dequeue (queue, 20);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedL4SPackets, 15, "WRR should serve three L4S packets per Classic packet");
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedClassicPackets, 5, "WRR should serve one Classic packet per three L4S packets");
+
+  // WRR is work conserving: the L4S queue is served when the Classic queue is empty
+  Dequeue (queue, 20);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedL4SPackets + st.dequeuedClassicPackets, 40, "All the packets should have been dequeued");
+
+  // Time-shifted FIFO: Classic packets waiting longer than the L4S ones plus the shift are served first
+  queue = CreateQueue (DualQCoupledCurvyRedQueueDisc::SCHEDULER_TIME_SHIFTED_FIFO);
+  Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedSchedulerTestCase::Enqueue, this, queue, 5, StringValue ("Classic"));
+  Simulator::Schedule (Seconds (0.08), &DualQCoupledCurvyRedSchedulerTestCase::Enqueue, this, queue, 5, StringValue ("L4S"));
+  Simulator::Schedule (Seconds (0.1), &DualQCoupledCurvyRedSchedulerTestCase::Dequeue, this, queue, 5);
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedClassicPackets, 5, "The older Classic packets should be served first");
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedL4SPackets, 0, "The L4S packets should wait for the older Classic packets");
+  NS_TEST_EXPECT_MSG_EQ (st.totalClassicSojourn, Seconds (0.5), "Wrong cumulative Classic sojourn time");
+  NS_TEST_EXPECT_MSG_EQ (st.maxClassicSojourn, Seconds (0.1), "Wrong maximum Classic sojourn time");
+
+  // with a large shift the L4S packets are served first
+  queue = CreateQueue (DualQCoupledCurvyRedQueueDisc::SCHEDULER_TIME_SHIFTED_FIFO);
+  queue->SetAttribute ("TimeShift", TimeValue (Seconds (0.1)));
+  Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedSchedulerTestCase::Enqueue, this, queue, 5, StringValue ("Classic"));
+  Simulator::Schedule (Seconds (0.08), &DualQCoupledCurvyRedSchedulerTestCase::Enqueue, this, queue, 5, StringValue ("L4S"));
+  Simulator::Schedule (Seconds (0.1), &DualQCoupledCurvyRedSchedulerTestCase::Dequeue, this, queue, 5);
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.dequeuedL4SPackets, 5, "The shifted L4S packets should be served first");
+  NS_TEST_EXPECT_MSG_EQ (st.maxL4SSojourn, Seconds (0.02), "Wrong maximum L4S sojourn time");
+
+  // a null weight would never let the WRR scheduler switch queues
+  queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("L4SWeight", UintegerValue (0)), false,
+                         "A null L4S weight should be rejected");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("ClassicWeight", UintegerValue (0)), false,
+                         "A null Classic weight should be rejected");
+
+  Simulator::Destroy ();
+}
+
+// Identifies the flows by the protocol number of the test items
+class DualQueueTestFlowFilter : public PacketFilter
+{
+private:
+  virtual bool CheckProtocol (Ptr<QueueDiscItem> item) const
+  {
+    return true;
+  }
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const
+  {
+    return item->GetProtocol ();
+  }
+};
+
+class DualQCoupledCurvyRedQueueProtectionTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedQueueProtectionTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<DualQCoupledCurvyRedQueueDisc> CreateQueue (bool qProt, DualQCoupledCurvyRedQueueDisc::QueueProtectionSanction sanction);
+  void RunFlows (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+  void Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint16_t flow);
+  void DropTrace (Ptr<const QueueDiscItem> item);
+  uint32_t m_drops[3];           //!< drops per flow
+};
+
+DualQCoupledCurvyRedQueueProtectionTestCase::DualQCoupledCurvyRedQueueProtectionTestCase ()
+  : TestCase ("Check the queue protection of the L4S queue")
+{
+}
+
+Ptr<DualQCoupledCurvyRedQueueDisc>
+DualQCoupledCurvyRedQueueProtectionTestCase::CreateQueue (bool qProt, DualQCoupledCurvyRedQueueDisc::QueueProtectionSanction sanction)
+{
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (200));
+  queue->SetAttribute ("QueueProtection", BooleanValue (qProt));
+  queue->SetAttribute ("QueueProtectionSanction", EnumValue (sanction));
+  if (qProt)
+    {
+      queue->AddPacketFilter (CreateObject<DualQueueTestFlowFilter> ());
+    }
+  queue->TraceConnectWithoutContext ("Drop", MakeCallback (&DualQCoupledCurvyRedQueueProtectionTestCase::DropTrace, this));
+  queue->Initialize ();
+  return queue;
+}
+
+void
+DualQCoupledCurvyRedQueueProtectionTestCase::Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint16_t flow)
+{
+  Address dest;
+  queue->Enqueue (Create<DualQueueL4SQueueDiscTestItem1> (Create<Packet> (1000), dest, flow));
+}
+
+void
+DualQCoupledCurvyRedQueueProtectionTestCase::DropTrace (Ptr<const QueueDiscItem> item)
+{
+  m_drops[item->GetProtocol ()]++;
+}
+
+void
+DualQCoupledCurvyRedQueueProtectionTestCase::RunFlows (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  // Nothing is dequeued, hence the L4S queue exceeds the marking threshold after
+  // 8 packets. Flow 1 sends a packet every ms, flow 2 every 10 ms. With the default
+  // aging rate, each marked 1000 byte packet adds 2 ms to the queuing score.
+  m_drops[1] = m_drops[2] = 0;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &DualQCoupledCurvyRedQueueProtectionTestCase::Enqueue, this, queue, 1);
+      if (i % 10 == 5)
+        {
+          Simulator::Schedule (MilliSeconds (i), &DualQCoupledCurvyRedQueueProtectionTestCase::Enqueue, this, queue, 2);
+        }
+    }
+  Simulator::Run ();
+}
+
+void
+DualQCoupledCurvyRedQueueProtectionTestCase::DoRun (void)
+{
+  // without queue protection all the packets are stored in the L4S queue
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateQueue (false, DualQCoupledCurvyRedQueueDisc::QPROT_SANCTION_DROP);
+  RunFlows (queue);
+  NS_TEST_EXPECT_MSG_EQ (m_drops[1] + m_drops[2], 0, "There should be no drops without queue protection");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueue (1)->GetNPackets (), 55, "All the packets should be in the L4S queue");
+
+  // the packets of the flow building the queue are dropped
+  queue = CreateQueue (true, DualQCoupledCurvyRedQueueDisc::QPROT_SANCTION_DROP);
+  RunFlows (queue);
+  DualQCoupledCurvyRedQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (m_drops[1], 30, "The packets of the unresponsive flow should be dropped");
+  NS_TEST_EXPECT_MSG_EQ (m_drops[2], 0, "The packets of the light flow should not be dropped");
+  NS_TEST_EXPECT_MSG_EQ (st.qProtDropped, m_drops[1], "Wrong number of drops due to queue protection");
+
+  // the packets of the flow building the queue are redirected to the Classic queue
+  queue = CreateQueue (true, DualQCoupledCurvyRedQueueDisc::QPROT_SANCTION_REDIRECT);
+  RunFlows (queue);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (m_drops[1] + m_drops[2], 0, "There should be no drops when redirecting");
+  NS_TEST_EXPECT_MSG_GT (st.qProtRedirected, 30, "The packets of the unresponsive flow should be redirected");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueue (0)->GetNPackets (), st.qProtRedirected, "The redirected packets should be in the Classic queue");
+
+  Simulator::Destroy ();
+}
+
+class DualQCoupledCurvyRedOverloadTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedOverloadTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<DualQCoupledCurvyRedQueueDisc> CreateQueue (bool overload, bool fixedPoint);
+  void Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s);
+  void DequeueOne (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+  void DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+  void CheckDequeueL4S (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+  void OverloadTrace (bool oldValue, bool newValue);
+  std::vector<bool> m_transitions;   //!< overload state changes
+};
+
+DualQCoupledCurvyRedOverloadTestCase::DualQCoupledCurvyRedOverloadTestCase ()
+  : TestCase ("Check the overload mode of the L4S queue")
+{
+}
+
+Ptr<DualQCoupledCurvyRedQueueDisc>
+DualQCoupledCurvyRedOverloadTestCase::CreateQueue (bool overload, bool fixedPoint)
+{
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (100));
+  queue->SetAttribute ("Overload", BooleanValue (overload));
+  queue->SetAttribute ("FixedPoint", BooleanValue (fixedPoint));
+  queue->TraceConnectWithoutContext ("Overload", MakeCallback (&DualQCoupledCurvyRedOverloadTestCase::OverloadTrace, this));
+  queue->Initialize ();
+  m_transitions.clear ();
+  return queue;
+}
+
+void
+DualQCoupledCurvyRedOverloadTestCase::Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      if (l4s)
+        {
+          queue->Enqueue (Create<DualQueueL4SQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+      else
+        {
+          queue->Enqueue (Create<DualQueueClassicQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+    }
+}
+
+void
+DualQCoupledCurvyRedOverloadTestCase::DequeueOne (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  queue->Dequeue ();
+}
+
+void
+DualQCoupledCurvyRedOverloadTestCase::DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  while (queue->Dequeue () != 0)
+    {
+    }
+}
+
+void
+DualQCoupledCurvyRedOverloadTestCase::CheckDequeueL4S (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "The L4S packet should be dequeued after leaving overload");
+}
+
+void
+DualQCoupledCurvyRedOverloadTestCase::OverloadTrace (bool oldValue, bool newValue)
+{
+  m_transitions.push_back (newValue);
+}
+
+void
+DualQCoupledCurvyRedOverloadTestCase::DoRun (void)
+{
+  for (uint32_t fixedPoint = 0; fixedPoint < 2; fixedPoint++)
+    {
+      // Classic packets waiting for 2 seconds saturate the L4S probability (the
+      // L4S scaling factor is 1 second), hence all the L4S packets are marked
+      Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateQueue (false, fixedPoint);
+      Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedOverloadTestCase::Enqueue, this, queue, 5, false);
+      Simulator::Schedule (Seconds (2), &DualQCoupledCurvyRedOverloadTestCase::Enqueue, this, queue, 5, true);
+      Simulator::Schedule (Seconds (2), &DualQCoupledCurvyRedOverloadTestCase::DequeueOne, this, queue);
+      Simulator::Run ();
+      DualQCoupledCurvyRedQueueDisc::Stats st = queue->GetStats ();
+      NS_TEST_EXPECT_MSG_EQ (st.unforcedL4SMark, 1, "The L4S packet should be marked");
+      NS_TEST_EXPECT_MSG_EQ (st.overloadL4SDrop, 0, "There should be no overload drops if overload is disabled");
+      NS_TEST_EXPECT_MSG_EQ (m_transitions.size (), 0, "The L4S queue should not enter overload if disabled");
+
+      // In overload the L4S packets are dropped instead of marked, until the
+      // probability falls below the exit threshold
+      queue = CreateQueue (true, fixedPoint);
+      Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedOverloadTestCase::Enqueue, this, queue, 5, false);
+      Simulator::Schedule (Seconds (2), &DualQCoupledCurvyRedOverloadTestCase::Enqueue, this, queue, 5, true);
+      Simulator::Schedule (Seconds (2), &DualQCoupledCurvyRedOverloadTestCase::DequeueOne, this, queue);
+      Simulator::Run ();
+      st = queue->GetStats ();
+      NS_TEST_EXPECT_MSG_EQ (st.overloadL4SDrop, 5, "All the L4S packets should be dropped in overload");
+      NS_TEST_EXPECT_MSG_EQ (st.unforcedL4SMark, 0, "No L4S packet should be marked in overload");
+      NS_TEST_EXPECT_MSG_EQ (m_transitions.size (), 1, "The L4S queue should have entered overload");
+
+      Simulator::Schedule (Seconds (3), &DualQCoupledCurvyRedOverloadTestCase::DequeueAll, this, queue);
+      Simulator::Schedule (Seconds (3), &DualQCoupledCurvyRedOverloadTestCase::Enqueue, this, queue, 1, true);
+      Simulator::Schedule (Seconds (3), &DualQCoupledCurvyRedOverloadTestCase::CheckDequeueL4S, this, queue);
+      Simulator::Run ();
+      st = queue->GetStats ();
+      NS_TEST_EXPECT_MSG_EQ (st.overloadL4SDrop, 5, "No L4S packet should be dropped after leaving overload");
+      NS_TEST_ASSERT_MSG_EQ (m_transitions.size (), 2, "The L4S queue should have left overload");
+      NS_TEST_EXPECT_MSG_EQ (m_transitions[0], true, "The first transition should enter overload");
+      NS_TEST_EXPECT_MSG_EQ (m_transitions[1], false, "The second transition should leave overload");
+    }
+
+  Simulator::Destroy ();
+}
+
+class DualQCoupledCurvyRedSamplerTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedSamplerTestCase ();
+  virtual void DoRun (void);
+private:
+  void Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt);
+  void Dequeue (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+  void AvgQueuingTimeTrace (Time oldValue, Time newValue);
+  uint32_t m_avgUpdates;    //!< number of changes of the averaged queuing time
+};
+
+DualQCoupledCurvyRedSamplerTestCase::DualQCoupledCurvyRedSamplerTestCase ()
+  : TestCase ("Check the traced state and the sampler of the queue disc")
+{
+}
+
+void
+DualQCoupledCurvyRedSamplerTestCase::Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<DualQueueClassicQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+    }
+}
+
+void
+DualQCoupledCurvyRedSamplerTestCase::Dequeue (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "A packet should have been dequeued");
+}
+
+void
+DualQCoupledCurvyRedSamplerTestCase::AvgQueuingTimeTrace (Time oldValue, Time newValue)
+{
+  m_avgUpdates++;
+}
+
+void
+DualQCoupledCurvyRedSamplerTestCase::DoRun (void)
+{
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (100));
+  // avoid unforced Classic drops, so that every dequeue returns a packet
+  queue->SetAttribute ("ClassicQueueScalingFactor", DoubleValue (30));
+  queue->TraceConnectWithoutContext ("AvgQueuingTime", MakeCallback (&DualQCoupledCurvyRedSamplerTestCase::AvgQueuingTimeTrace, this));
+  queue->Initialize ();
+  m_avgUpdates = 0;
+
+  Ptr<DualQCoupledCurvyRedSampler> sampler = CreateObject<DualQCoupledCurvyRedSampler> ();
+  sampler->SetAttribute ("Interval", TimeValue (MilliSeconds (1)));
+  // a null interval would reschedule the sampling at the same time forever
+  NS_TEST_EXPECT_MSG_EQ (sampler->SetAttributeFailSafe ("Interval", TimeValue (Seconds (0))), false,
+                         "A null sampling interval should be rejected");
+  NS_TEST_EXPECT_MSG_EQ (sampler->SetAttributeFailSafe ("Interval", TimeValue (MilliSeconds (-1))), false,
+                         "A negative sampling interval should be rejected");
+  sampler->SetAttribute ("Capacity", UintegerValue (8));
+  sampler->Install (queue);
+
+  // 20 samples are taken (at 0, 1, ..., 19 ms), the last 8 are retained
+  Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedSamplerTestCase::Enqueue, this, queue, 10);
+  Simulator::Schedule (MilliSeconds (5) + MicroSeconds (500), &DualQCoupledCurvyRedSamplerTestCase::Dequeue, this, queue);
+  Simulator::Schedule (MilliSeconds (19) + MicroSeconds (500), &DualQCoupledCurvyRedSampler::Stop, sampler);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_avgUpdates, 1, "The averaged queuing time should have been updated by the dequeue");
+  NS_TEST_EXPECT_MSG_EQ (sampler->GetNSamples (), 8, "The sampler should retain Capacity samples");
+  NS_TEST_EXPECT_MSG_EQ (sampler->GetNOverwritten (), 12, "The oldest samples should have been overwritten");
+  for (uint32_t i = 0; i < sampler->GetNSamples (); i++)
+    {
+      const DualQCoupledCurvyRedSampler::Sample &sample = sampler->GetSample (i);
+      NS_TEST_EXPECT_MSG_EQ (sample.timeNs, MilliSeconds (12 + i).GetNanoSeconds (), "Samples should be ordered from the oldest");
+      NS_TEST_EXPECT_MSG_EQ (sample.classicBytes, 9000, "Wrong number of bytes in the Classic queue");
+      NS_TEST_EXPECT_MSG_EQ (sample.avgQueuingTimeNs, queue->GetAvgQueuingTime ().GetNanoSeconds (), "Wrong averaged queuing time");
+      NS_TEST_EXPECT_MSG_EQ (sample.classicSqrtProb, queue->GetClassicSqrtProb (), "Wrong Classic probability");
+    }
+  NS_TEST_EXPECT_MSG_GT (sampler->GetSample (0).avgQueuingTimeNs, 0, "The averaged queuing time should be positive");
+
+  std::string csv = CreateTempDirFilename ("dual-q-coupled-curvy-red-sampler.csv");
+  sampler->Write (csv, DualQCoupledCurvyRedSampler::FORMAT_CSV);
+  std::ifstream in (csv.c_str ());
+  std::string line;
+  uint32_t lines = 0;
+  while (std::getline (in, line))
+    {
+      lines++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (lines, 9, "The CSV file should have a header and one line per sample");
+
+  std::string bin = CreateTempDirFilename ("dual-q-coupled-curvy-red-sampler.bin");
+  sampler->Write (bin, DualQCoupledCurvyRedSampler::FORMAT_BINARY);
+  std::ifstream binIn (bin.c_str (), std::ios::binary | std::ios::ate);
+  NS_TEST_EXPECT_MSG_EQ (binIn.tellg (), 16 + 8 * 44, "Wrong size of the binary file");
+
+  Simulator::Destroy ();
+}
+
+class DualQCoupledCurvyRedCouplingTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedCouplingTestCase ();
+  virtual void DoRun (void);
+private:
+  void Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s);
+  void DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+  void RunQueues (Ptr<DualQCoupledCurvyRedQueueDisc> classicQueue, Ptr<DualQCoupledCurvyRedQueueDisc> l4sQueue);
+};
+
+DualQCoupledCurvyRedCouplingTestCase::DualQCoupledCurvyRedCouplingTestCase ()
+  : TestCase ("Check the coupled state shared by the children of an mq queue disc")
+{
+}
+
+void
+DualQCoupledCurvyRedCouplingTestCase::Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      if (l4s)
+        {
+          queue->Enqueue (Create<DualQueueL4SQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+      else
+        {
+          queue->Enqueue (Create<DualQueueClassicQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+    }
+}
+
+void
+DualQCoupledCurvyRedCouplingTestCase::DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  while (queue->Dequeue () != 0)
+    {
+    }
+}
+
+void
+DualQCoupledCurvyRedCouplingTestCase::RunQueues (Ptr<DualQCoupledCurvyRedQueueDisc> classicQueue,
+                                                 Ptr<DualQCoupledCurvyRedQueueDisc> l4sQueue)
+{
+  // Classic packets wait for 2 seconds in the first queue disc, while the
+  // second queue disc only holds an L4S packet, which is dequeued afterwards
+  Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedCouplingTestCase::Enqueue, this, classicQueue, 5, false);
+  Simulator::Schedule (Seconds (2), &DualQCoupledCurvyRedCouplingTestCase::DequeueAll, this, classicQueue);
+  Simulator::Schedule (Seconds (2), &DualQCoupledCurvyRedCouplingTestCase::Enqueue, this, l4sQueue, 1, true);
+  Simulator::Schedule (Seconds (2), &DualQCoupledCurvyRedCouplingTestCase::DequeueAll, this, l4sQueue);
+  Simulator::Run ();
+}
+
+void
+DualQCoupledCurvyRedCouplingTestCase::DoRun (void)
+{
+  for (uint32_t fixedPoint = 0; fixedPoint < 2; fixedPoint++)
+    {
+      for (uint32_t coupled = 0; coupled < 2; coupled++)
+        {
+          // an mq queue disc with a DualQ Coupled Curvy RED child per transmission queue
+          Ptr<MqQueueDisc> mq = CreateObject<MqQueueDisc> ();
+          Ptr<DualQCoupledCurvyRedCoupling> coupling = CreateObject<DualQCoupledCurvyRedCoupling> ();
+          for (uint32_t i = 0; i < 2; i++)
+            {
+              // with Fc = 0 the EWMA is the last Classic queuing time
+              Ptr<DualQCoupledCurvyRedQueueDisc> child = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+              child->SetAttribute ("QueueLimit", UintegerValue (100));
+              child->SetAttribute ("Fc", UintegerValue (0));
+              child->SetAttribute ("FixedPoint", BooleanValue (fixedPoint));
+              if (coupled)
+                {
+                  child->SetAttribute ("Coupling", PointerValue (coupling));
+                }
+              Ptr<QueueDiscClass> cls = CreateObject<QueueDiscClass> ();
+              cls->SetQueueDisc (child);
+              mq->AddQueueDiscClass (cls);
+            }
+          mq->Initialize ();
+
+          Ptr<DualQCoupledCurvyRedQueueDisc> classicQueue = DynamicCast<DualQCoupledCurvyRedQueueDisc> (mq->GetQueueDiscClass (0)->GetQueueDisc ());
+          Ptr<DualQCoupledCurvyRedQueueDisc> l4sQueue = DynamicCast<DualQCoupledCurvyRedQueueDisc> (mq->GetQueueDiscClass (1)->GetQueueDisc ());
+          RunQueues (classicQueue, l4sQueue);
+
+          DualQCoupledCurvyRedQueueDisc::Stats st = l4sQueue->GetStats ();
+          NS_TEST_EXPECT_MSG_EQ (st.dequeuedL4SPackets, 1, "The L4S packet should be dequeued");
+          NS_TEST_EXPECT_MSG_EQ (l4sQueue->GetAvgQueuingTime (), Seconds (0), "The second queue disc has no Classic traffic");
+          if (coupled)
+            {
+              // the L4S probability is coupled to the Classic queuing time of the first queue disc
+              NS_TEST_EXPECT_MSG_EQ (coupling->GetNQueueDiscs (), 2, "Both the children should share the coupled state");
+              NS_TEST_EXPECT_MSG_EQ (coupling->GetAvgQueuingTime (), Seconds (2), "Unexpected aggregated queuing time");
+              NS_TEST_EXPECT_MSG_EQ (st.unforcedL4SMark, 1, "The L4S packet should be marked");
+            }
+          else
+            {
+              NS_TEST_EXPECT_MSG_EQ (classicQueue->GetAvgQueuingTime (), Seconds (2), "Unexpected queuing time");
+              NS_TEST_EXPECT_MSG_EQ (st.unforcedL4SMark, 0, "The L4S packet should not be marked");
+            }
+        }
+    }
+
+  Simulator::Destroy ();
+}
+
+class DualQCoupledCurvyRedUpdateIntervalTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedUpdateIntervalTestCase ();
+  virtual void DoRun (void);
+private:
+  void Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s);
+  void CheckDequeueL4S (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t marks);
+  void DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+};
+
+DualQCoupledCurvyRedUpdateIntervalTestCase::DualQCoupledCurvyRedUpdateIntervalTestCase ()
+  : TestCase ("Check the periodic update of the probabilities")
+{
+}
+
+void
+DualQCoupledCurvyRedUpdateIntervalTestCase::Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      if (l4s)
+        {
+          queue->Enqueue (Create<DualQueueL4SQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+      else
+        {
+          queue->Enqueue (Create<DualQueueClassicQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+    }
+}
+
+void
+DualQCoupledCurvyRedUpdateIntervalTestCase::CheckDequeueL4S (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t marks)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "The L4S packet should be dequeued");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().unforcedL4SMark, marks, "Unexpected number of L4S marks");
+}
+
+void
+DualQCoupledCurvyRedUpdateIntervalTestCase::DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  while (queue->Dequeue () != 0)
+    {
+    }
+}
+
+void
+DualQCoupledCurvyRedUpdateIntervalTestCase::DoRun (void)
+{
+  for (uint32_t fixedPoint = 0; fixedPoint < 2; fixedPoint++)
+    {
+      // with Fc = 0 the EWMA is the last sampled Classic queuing time
+      Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+      queue->SetAttribute ("QueueLimit", UintegerValue (100));
+      queue->SetAttribute ("Fc", UintegerValue (0));
+      queue->SetAttribute ("FixedPoint", BooleanValue (fixedPoint));
+      queue->SetAttribute ("UpdateInterval", TimeValue (Seconds (1)));
+      queue->Initialize ();
+
+      Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedUpdateIntervalTestCase::Enqueue, this, queue, 5, false);
+      Simulator::Schedule (Seconds (0), &DualQCoupledCurvyRedUpdateIntervalTestCase::Enqueue, this, queue, 2, true);
+      // before the first update the probabilities are zero, although the
+      // Classic packets have been waiting for 0.5 seconds
+      Simulator::Schedule (Seconds (0.5), &DualQCoupledCurvyRedUpdateIntervalTestCase::CheckDequeueL4S, this, queue, 0);
+      // the update at 1 second samples a Classic queuing time of 1 second,
+      // which saturates both the L4S and the Classic probabilities
+      Simulator::Schedule (Seconds (1.5), &DualQCoupledCurvyRedUpdateIntervalTestCase::CheckDequeueL4S, this, queue, 1);
+      Simulator::Schedule (Seconds (1.5), &DualQCoupledCurvyRedUpdateIntervalTestCase::DequeueAll, this, queue);
+      Simulator::Stop (Seconds (1.6));
+      Simulator::Run ();
+
+      DualQCoupledCurvyRedQueueDisc::Stats st = queue->GetStats ();
+      NS_TEST_EXPECT_MSG_EQ (st.unforcedClassicDrop, 5, "All the Classic packets should be dropped");
+      // the dequeues do not update the averaged queuing time
+      NS_TEST_EXPECT_MSG_EQ (queue->GetAvgQueuingTime (), Seconds (1), "Unexpected averaged queuing time");
+      NS_TEST_EXPECT_MSG_EQ (queue->GetL4SProb (), 1, "Unexpected L4S probability");
+      queue->Dispose ();
+    }
+
+  Simulator::Destroy ();
+}
+
+class DualQCoupledCurvyRedAutoTuneTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedAutoTuneTestCase ();
+  virtual void DoRun (void);
+private:
+  void CheckParams (Ptr<DualQCoupledCurvyRedQueueDisc> queue, double scalingFactor, uint32_t fc, uint32_t threshold);
+};
+
+DualQCoupledCurvyRedAutoTuneTestCase::DualQCoupledCurvyRedAutoTuneTestCase ()
+  : TestCase ("Check the parameters derived from the link bandwidth")
+{
+}
+
+void
+DualQCoupledCurvyRedAutoTuneTestCase::CheckParams (Ptr<DualQCoupledCurvyRedQueueDisc> queue, double scalingFactor, uint32_t fc, uint32_t threshold)
+{
+  DoubleValue scalingFactorValue;
+  UintegerValue fcValue;
+  UintegerValue thresholdValue;
+  queue->GetAttribute ("ClassicQueueScalingFactor", scalingFactorValue);
+  queue->GetAttribute ("Fc", fcValue);
+  queue->GetAttribute ("L4SQueueSizeThreshold", thresholdValue);
+  NS_TEST_EXPECT_MSG_EQ (scalingFactorValue.Get (), scalingFactor, "Unexpected ClassicQueueScalingFactor");
+  NS_TEST_EXPECT_MSG_EQ (fcValue.Get (), fc, "Unexpected Fc");
+  NS_TEST_EXPECT_MSG_EQ (thresholdValue.Get (), threshold, "Unexpected L4SQueueSizeThreshold");
+}
+
+void
+DualQCoupledCurvyRedAutoTuneTestCase::DoRun (void)
+{
+  // 10 Mbps read from the device: 12.5 packets are served in 15 ms, the L4S
+  // threshold is raised to 2 packets
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+  Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("AutoTune", BooleanValue (true));
+  queue->SetNetDevice (device);
+  queue->Initialize ();
+  CheckParams (queue, -1, 5, 3000);
+
+  // 40 Gbps set explicitly: 50000 packets are served in 15 ms, 5 MB in 1 ms
+  queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("AutoTune", BooleanValue (true));
+  queue->SetAttribute ("LinkBandwidth", DataRateValue (DataRate ("40Gbps")));
+  queue->SetNetDevice (device);
+  queue->Initialize ();
+  CheckParams (queue, -1, 17, 5000000);
+
+  // a smaller target delay scales the range of the Classic probability
+  queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  queue->SetAttribute ("AutoTune", BooleanValue (true));
+  queue->SetAttribute ("LinkBandwidth", DataRateValue (DataRate ("40Gbps")));
+  queue->SetAttribute ("TargetDelay", TimeValue (MicroSeconds (500)));
+  queue->Initialize ();
+  CheckParams (queue, -6, 12, 5000000);
+
+  // the scaling factors are logarithms of the target delays, which must be positive
+  queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("TargetDelay", TimeValue (Seconds (0))), false,
+                         "A null target delay should be rejected");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("L4STargetDelay", TimeValue (MilliSeconds (-1))), false,
+                         "A negative L4S target delay should be rejected");
+
+  Simulator::Destroy ();
+}
+
+class DualQCoupledCurvyRedSojournHistogramTestCase : public TestCase
+{
+public:
+  DualQCoupledCurvyRedSojournHistogramTestCase ();
+  virtual void DoRun (void);
+private:
+  void Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s);
+  void DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue);
+};
+
+DualQCoupledCurvyRedSojournHistogramTestCase::DualQCoupledCurvyRedSojournHistogramTestCase ()
+  : TestCase ("Check the sojourn time histograms")
+{
+}
+
+void
+DualQCoupledCurvyRedSojournHistogramTestCase::Enqueue (Ptr<DualQCoupledCurvyRedQueueDisc> queue, uint32_t nPkt, bool l4s)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      if (l4s)
+        {
+          queue->Enqueue (Create<DualQueueL4SQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+      else
+        {
+          queue->Enqueue (Create<DualQueueClassicQueueDiscTestItem1> (Create<Packet> (1000), dest, 0));
+        }
+    }
+}
+
+void
+DualQCoupledCurvyRedSojournHistogramTestCase::DequeueAll (Ptr<DualQCoupledCurvyRedQueueDisc> queue)
+{
+  while (queue->Dequeue () != 0)
+    {
+    }
+}
+
+void
+DualQCoupledCurvyRedSojournHistogramTestCase::DoRun (void)
+{
+  // the value reported for a bucket exceeds the recorded values by less than 1/32
+  uint32_t lastIndex = 0;
+  for (uint64_t value = 1; value < (1ull << 45); value += value / 7 + 1)
+    {
+      uint32_t index = SojournHistogram::GetBucketIndex (value);
+      NS_TEST_EXPECT_MSG_EQ ((index >= lastIndex), true, "The bucket index should not decrease with the value");
+      lastIndex = index;
+      if (index < SojournHistogram::N_BUCKETS - 1)
+        {
+          uint64_t highest = SojournHistogram::GetBucketHighestValue (index);
+          NS_TEST_EXPECT_MSG_EQ ((highest >= value && highest - value <= value / 32), true,
+                                 "Unexpected highest value " << highest << " for " << value);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (lastIndex, SojournHistogram::N_BUCKETS - 1, "Large values should be counted in the last bucket");
+
+  SojournHistogram histogram;
+  for (uint32_t us = 1; us <= 1000; us++)
+    {
+      histogram.Record (MicroSeconds (us));
+    }
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (), 1000, "Unexpected number of values");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetMin (), MicroSeconds (1), "Unexpected minimum");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetMax (), MicroSeconds (1000), "Unexpected maximum");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetMean (), NanoSeconds (500500), "Unexpected mean");
+  NS_TEST_EXPECT_MSG_EQ_TOL (histogram.GetPercentile (50).GetMicroSeconds (), 500, 16, "Unexpected median");
+  NS_TEST_EXPECT_MSG_EQ_TOL (histogram.GetPercentile (99).GetMicroSeconds (), 990, 31, "Unexpected 99th percentile");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetPercentile (99.9), MicroSeconds (1000), "Unexpected 99.9th percentile");
+  histogram.Reset ();
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (), 0, "The histogram should be empty");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetPercentile (99), Time (0), "The percentile of an empty histogram should be zero");
+
+  // Classic packets wait 2 ms, L4S packets wait 1 ms
+  for (uint32_t enabled = 0; enabled < 2; enabled++)
+    {
+      Ptr<DualQCoupledCurvyRedQueueDisc> queue = CreateObject<DualQCoupledCurvyRedQueueDisc> ();
+      queue->SetAttribute ("QueueLimit", UintegerValue (100));
+      queue->SetAttribute ("SojournHistogram", BooleanValue (enabled));
+      queue->Initialize ();
+
+      Simulator::Schedule (MilliSeconds (0), &DualQCoupledCurvyRedSojournHistogramTestCase::Enqueue, this, queue, 10, false);
+      Simulator::Schedule (MilliSeconds (1), &DualQCoupledCurvyRedSojournHistogramTestCase::Enqueue, this, queue, 10, true);
+      Simulator::Schedule (MilliSeconds (2), &DualQCoupledCurvyRedSojournHistogramTestCase::DequeueAll, this, queue);
+      Simulator::Run ();
+
+      DualQCoupledCurvyRedQueueDisc::Stats st = queue->GetStats ();
+      if (!enabled)
+        {
+          NS_TEST_EXPECT_MSG_EQ (queue->IsSojournHistogramEnabled (), false, "Histograms should be disabled by default");
+          NS_TEST_EXPECT_MSG_EQ (st.p99ClassicSojourn, Time (0), "No percentile without histograms");
+          NS_TEST_EXPECT_MSG_EQ (st.p999L4SSojourn, Time (0), "No percentile without histograms");
+          queue->Dispose ();
+          continue;
+        }
+
+      NS_TEST_EXPECT_MSG_EQ (st.p99ClassicSojourn, MilliSeconds (2), "Unexpected Classic 99th percentile");
+      NS_TEST_EXPECT_MSG_EQ (st.p999ClassicSojourn, MilliSeconds (2), "Unexpected Classic 99.9th percentile");
+      NS_TEST_EXPECT_MSG_EQ (st.p99L4SSojourn, MilliSeconds (1), "Unexpected L4S 99th percentile");
+      NS_TEST_EXPECT_MSG_EQ (st.p999L4SSojourn, MilliSeconds (1), "Unexpected L4S 99.9th percentile");
+      // the internal queues count the Classic packets dropped at dequeue, the
+      // queue disc only the packets it returned
+      NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueueSojournHistogram (0).GetCount (), 10, "Unexpected number of Classic sojourn times");
+      NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueueSojournHistogram (1).GetCount (), 10, "Unexpected number of L4S sojourn times");
+      NS_TEST_EXPECT_MSG_EQ (queue->GetSojournHistogram ().GetCount (), 20 - st.unforcedClassicDrop, "Unexpected number of sojourn times");
+      NS_TEST_EXPECT_MSG_EQ (queue->GetSojournHistogram ().GetMax (), MilliSeconds (2), "Unexpected maximum sojourn time");
+      queue->ResetSojournHistograms ();
+      NS_TEST_EXPECT_MSG_EQ (queue->GetSojournHistogram ().GetCount (), 0, "The histograms should be empty");
+      NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().p99L4SSojourn, Time (0), "The histograms should be empty");
+      queue->Dispose ();
+    }
+
   Simulator::Destroy ();
 }
 
@@ -352,5 +1267,14 @@ public:
     : TestSuite ("dual-q-coupled-curvy-red-queue-disc", UNIT)
   {
     AddTestCase (new DualQCoupledCurvyRedQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedMarkingEngineTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedSchedulerTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedQueueProtectionTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedOverloadTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedSamplerTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedCouplingTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedUpdateIntervalTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedAutoTuneTestCase (), TestCase::QUICK);
+    AddTestCase (new DualQCoupledCurvyRedSojournHistogramTestCase (), TestCase::QUICK);
   }
 } g_DualQCoupledCurvyRedQueueTestSuite;
@@ -25,6 +25,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
@@ -122,7 +123,7 @@ private:
   void EnqueueWithDelay (Ptr<DualQCoupledPiSquareQueueDisc> queue, uint32_t size, uint32_t nPkt, StringValue trafficType);
   void Dequeue (Ptr<DualQCoupledPiSquareQueueDisc> queue, uint32_t nPkt);
   void DequeueWithDelay (Ptr<DualQCoupledPiSquareQueueDisc> queue, double delay, uint32_t nPkt);
-  void RunPiSquareTest (StringValue mode);
+  void RunPiSquareTest (StringValue mode, bool fixedPoint);
 };
 
 DualQCoupledPiSquareQueueDiscTestCase::DualQCoupledPiSquareQueueDiscTestCase ()
@@ -131,7 +132,7 @@ DualQCoupledPiSquareQueueDiscTestCase::DualQCoupledPiSquareQueueDiscTestCase ()
 }
 
 void
-DualQCoupledPiSquareQueueDiscTestCase::RunPiSquareTest (StringValue mode)
+DualQCoupledPiSquareQueueDiscTestCase::RunPiSquareTest (StringValue mode, bool fixedPoint)
 {
   uint32_t pktSize = 0;
 
@@ -145,6 +146,8 @@ DualQCoupledPiSquareQueueDiscTestCase::RunPiSquareTest (StringValue mode)
   // test 1: simple enqueue/dequeue with defaults, no drops
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
 
   Address dest;
 
@@ -212,6 +215,8 @@ DualQCoupledPiSquareQueueDiscTestCase::RunPiSquareTest (StringValue mode)
   pktSize = 1000;  // pktSize != 0 because DequeueThreshold always works in bytes
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
                          "Verify that we can actually set the attribute QueueLimit");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (10)), true,
@@ -246,6 +251,8 @@ DualQCoupledPiSquareQueueDiscTestCase::RunPiSquareTest (StringValue mode)
   queue = CreateObject<DualQCoupledPiSquareQueueDisc> ();
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
                          "Verify that we can actually set the attribute QueueLimit");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (10)), true,
@@ -276,6 +283,8 @@ DualQCoupledPiSquareQueueDiscTestCase::RunPiSquareTest (StringValue mode)
   queue = CreateObject<DualQCoupledPiSquareQueueDisc> ();
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
                          "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("FixedPoint", BooleanValue (fixedPoint)), true,
+                         "Verify that we can actually set the attribute FixedPoint");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
                          "Verify that we can actually set the attribute QueueLimit");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (10)), true,
@@ -352,8 +361,10 @@ DualQCoupledPiSquareQueueDiscTestCase::DequeueWithDelay (Ptr<DualQCoupledPiSquar
 void
 DualQCoupledPiSquareQueueDiscTestCase::DoRun (void)
 {
-  RunPiSquareTest (StringValue ("QUEUE_DISC_MODE_PACKETS"));
-  RunPiSquareTest (StringValue ("QUEUE_DISC_MODE_BYTES"));
+  RunPiSquareTest (StringValue ("QUEUE_DISC_MODE_PACKETS"), false);
+  RunPiSquareTest (StringValue ("QUEUE_DISC_MODE_BYTES"), false);
+  RunPiSquareTest (StringValue ("QUEUE_DISC_MODE_PACKETS"), true);
+  RunPiSquareTest (StringValue ("QUEUE_DISC_MODE_BYTES"), true);
   Simulator::Destroy ();
 }
 
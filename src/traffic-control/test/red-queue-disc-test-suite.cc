@@ -22,12 +22,16 @@
 
 #include "ns3/test.h"
 #include "ns3/red-queue-disc.h"
+#include "ns3/queue.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include <cmath>
 
 using namespace ns3;
 
@@ -523,6 +527,345 @@ RedQueueDiscTestCase::DoRun (void)
 
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Check the average queue size computed with the decay table against
+ * the EWMA computed with std::pow
+ */
+class RedQueueDiscEstimatorTestCase : public TestCase
+{
+public:
+  RedQueueDiscEstimatorTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue packets, updating the reference average queue size before each one
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   */
+  void Enqueue (Ptr<RedQueueDisc> queue, uint32_t nPkt);
+  /**
+   * Dequeue all the packets, which starts an idle period
+   * \param queue the queue disc
+   */
+  void DequeueAll (Ptr<RedQueueDisc> queue);
+  /**
+   * Run the test with the given attributes
+   * \param ared true to enable adaptive RED
+   */
+  void RunEstimatorTest (bool ared);
+
+  double m_qW;          //!< Queue weight of the queue disc
+  double m_ptc;         //!< Packet time constant of the queue disc
+  double m_refAvg;      //!< Reference average queue size
+  bool m_idle;          //!< The queue disc is idle
+  Time m_idleTime;      //!< Start of the idle period
+};
+
+RedQueueDiscEstimatorTestCase::RedQueueDiscEstimatorTestCase ()
+  : TestCase ("Check the RED average queue size estimator against std::pow"),
+    m_qW (0),
+    m_ptc (0),
+    m_refAvg (0),
+    m_idle (false)
+{
+}
+
+void
+RedQueueDiscEstimatorTestCase::Enqueue (Ptr<RedQueueDisc> queue, uint32_t nPkt)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      // reference implementation of RedQueueDisc::Estimator
+      uint32_t m = 0;
+      if (m_idle)
+        {
+          m = uint32_t (m_ptc * (Simulator::Now () - m_idleTime).GetSeconds ());
+          m_idle = false;
+        }
+      m_refAvg = m_refAvg * std::pow (1.0 - m_qW, m + 1) + m_qW * queue->GetQueueSize ();
+
+      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (500), dest, 0, false));
+      NS_TEST_EXPECT_MSG_EQ_TOL (queue->GetAverageQueueSize (), m_refAvg, 1e-9 * std::max (1.0, m_refAvg),
+                                 "Unexpected average queue size after an idle period of " << m << " packets");
+    }
+}
+
+void
+RedQueueDiscEstimatorTestCase::DequeueAll (Ptr<RedQueueDisc> queue)
+{
+  while (queue->Dequeue () != 0)
+    {
+    }
+  m_idle = true;
+  m_idleTime = Simulator::Now ();
+}
+
+void
+RedQueueDiscEstimatorTestCase::RunEstimatorTest (bool ared)
+{
+  Ptr<RedQueueDisc> queue = CreateObject<RedQueueDisc> ();
+  queue->SetAttribute ("MeanPktSize", UintegerValue (500));
+  queue->SetAttribute ("LinkBandwidth", DataRateValue (DataRate ("1Mbps")));
+  queue->SetAttribute ("QueueLimit", UintegerValue (1000));
+  queue->SetAttribute ("ARED", BooleanValue (ared));
+  if (!ared)
+    {
+      queue->SetAttribute ("QW", DoubleValue (0.002));
+      queue->SetTh (100, 200);
+    }
+  queue->Initialize ();
+
+  // ARED derives the queue weight from the link bandwidth
+  DoubleValue qW;
+  queue->GetAttribute ("QW", qW);
+  m_qW = qW.Get ();
+  m_ptc = 1e6 / (8.0 * 500);
+  m_refAvg = 0;
+  m_idle = false;
+
+  // bursts separated by idle periods of 0 to more than 2^31 packet times (250
+  // packets per second), so that m spans all of its 32 bits; with these weights
+  // the decay underflows to 0 beyond about 2^18 packets, as std::pow does
+  Time t = Seconds (0);
+  double idle[] = { 0, 0.001, 0.004, 0.1, 0.5, 3.3, 17, 130, 1000, 40000, 9e6 };
+  for (uint32_t i = 0; i < sizeof (idle) / sizeof (idle[0]); i++)
+    {
+      Simulator::Schedule (t, &RedQueueDiscEstimatorTestCase::Enqueue, this, queue, 20 + 3 * i);
+      t += MilliSeconds (1);
+      Simulator::Schedule (t, &RedQueueDiscEstimatorTestCase::DequeueAll, this, queue);
+      t += Seconds (idle[i]);
+    }
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().unforcedDrop + queue->GetStats ().forcedDrop, 0, "No packet should be dropped");
+  queue->Dispose ();
+}
+
+void
+RedQueueDiscEstimatorTestCase::DoRun (void)
+{
+  RunEstimatorTest (false);
+  RunEstimatorTest (true);
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Check the per-reason drop counters and the batched drop traces
+ */
+class RedQueueDiscDropTestCase : public TestCase
+{
+public:
+  RedQueueDiscDropTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Drop trace sink
+   * \param item the dropped item
+   */
+  void DropTrace (Ptr<const QueueDiscItem> item);
+  /**
+   * DropBatch trace sink
+   * \param items the dropped items
+   */
+  void DropBatchTrace (const std::vector<Ptr<const QueueDiscItem> > &items);
+
+  uint32_t m_drops;         //!< Number of items traced by the Drop trace
+  uint32_t m_batches;       //!< Number of batches traced by the DropBatch trace
+  uint32_t m_batchedDrops;  //!< Number of items traced by the DropBatch trace
+  uint32_t m_batchSize;     //!< Size of the last batch
+  Ptr<RedQueueDisc> m_queue; //!< Queue disc to drop from within the Drop sink, if not null
+};
+
+RedQueueDiscDropTestCase::RedQueueDiscDropTestCase ()
+  : TestCase ("Check the RED drop counters and batched drop traces"),
+    m_drops (0),
+    m_batches (0),
+    m_batchedDrops (0),
+    m_batchSize (0)
+{
+}
+
+void
+RedQueueDiscDropTestCase::DropTrace (Ptr<const QueueDiscItem> item)
+{
+  m_drops++;
+  if (m_queue)
+    {
+      // drop once more and flush, from within the flush of the outer batch
+      Ptr<RedQueueDisc> queue = m_queue;
+      m_queue = 0;
+      Address dest;
+      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (item->GetSize ()), dest, 0, false));
+      queue->FlushDropTrace ();
+    }
+}
+
+void
+RedQueueDiscDropTestCase::DropBatchTrace (const std::vector<Ptr<const QueueDiscItem> > &items)
+{
+  m_batches++;
+  m_batchedDrops += items.size ();
+  m_batchSize = items.size ();
+}
+
+void
+RedQueueDiscDropTestCase::DoRun (void)
+{
+  const uint32_t batchSize = 16;
+  const uint32_t pktSize = 500;
+  Ptr<RedQueueDisc> queue = CreateObject<RedQueueDisc> ();
+  queue->SetAttribute ("Mode", StringValue ("QUEUE_DISC_MODE_PACKETS"));
+  queue->SetAttribute ("MinTh", DoubleValue (5));
+  queue->SetAttribute ("MaxTh", DoubleValue (15));
+  queue->SetAttribute ("QueueLimit", UintegerValue (50));
+  queue->SetAttribute ("QW", DoubleValue (0.020));
+  queue->SetAttribute ("DropTraceBatchSize", UintegerValue (batchSize));
+  queue->TraceConnectWithoutContext ("Drop", MakeCallback (&RedQueueDiscDropTestCase::DropTrace, this));
+  queue->TraceConnectWithoutContext ("DropBatch", MakeCallback (&RedQueueDiscDropTestCase::DropBatchTrace, this));
+  queue->Initialize ();
+
+  Address dest;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (pktSize), dest, 0, false));
+    }
+
+  RedQueueDisc::Stats st = queue->GetStats ();
+  uint32_t dropped = queue->GetTotalDroppedPackets ();
+  NS_TEST_EXPECT_MSG_NE (st.unforcedDrop, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_NE (st.forcedDrop, 0, "There should be some forced drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDroppedPackets (QueueDisc::DROP_UNFORCED), st.unforcedDrop,
+                         "The unforced drops should be counted as DROP_UNFORCED");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDroppedPackets (QueueDisc::DROP_FORCED), st.forcedDrop,
+                         "The forced drops should be counted as DROP_FORCED");
+  uint32_t total = 0;
+  for (uint32_t r = 0; r < QueueDisc::DROP_N_REASONS; r++)
+    {
+      total += queue->GetDroppedPackets (QueueDisc::DropReason (r));
+      NS_TEST_EXPECT_MSG_EQ (queue->GetDroppedBytes (QueueDisc::DropReason (r)),
+                             queue->GetDroppedPackets (QueueDisc::DropReason (r)) * pktSize,
+                             "Unexpected amount of bytes dropped for reason " << r);
+    }
+  NS_TEST_EXPECT_MSG_EQ (total, dropped, "The drop reasons should add up to the total drops");
+
+  // only full batches have been traced so far
+  NS_TEST_EXPECT_MSG_EQ (m_batches, dropped / batchSize, "Unexpected number of batches");
+  NS_TEST_EXPECT_MSG_EQ (m_batchSize, batchSize, "Unexpected size of a batch");
+  NS_TEST_EXPECT_MSG_EQ (m_drops, m_batchedDrops, "The Drop trace should be fired for each batched item");
+  NS_TEST_EXPECT_MSG_EQ (m_drops, dropped - dropped % batchSize, "Unexpected number of traced drops");
+
+  queue->FlushDropTrace ();
+  NS_TEST_EXPECT_MSG_EQ (m_drops, dropped, "All the drops should be traced after a flush");
+  NS_TEST_EXPECT_MSG_EQ (m_batchedDrops, dropped, "All the drops should be batched after a flush");
+
+  // a sink dropping and flushing from within a flush: each drop is traced once
+  // (the queue is still full, and the batch is flushed below, not when full)
+  for (uint32_t i = 0; i < batchSize - 1; i++)
+    {
+      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (pktSize), dest, 0, false));
+    }
+  m_queue = queue;
+  queue->FlushDropTrace ();
+  NS_TEST_EXPECT_MSG_EQ (m_queue, 0, "The Drop sink should have dropped again");
+  dropped = queue->GetTotalDroppedPackets ();
+  NS_TEST_EXPECT_MSG_EQ (m_drops, dropped, "Each drop should be traced once by the Drop trace");
+  NS_TEST_EXPECT_MSG_EQ (m_batchedDrops, dropped, "Each drop should be traced once by the DropBatch trace");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Red Queue Disc exposing the occupancy counters of its internal queue
+ */
+class RedQueueDiscOccupancy : public RedQueueDisc
+{
+public:
+  using QueueDisc::GetInternalQueueNPackets;
+  using QueueDisc::GetInternalQueueNBytes;
+  using QueueDisc::GetInternalQueuesNPackets;
+  using QueueDisc::GetInternalQueuesNBytes;
+};
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Red Queue Disc Occupancy Test Case
+ *
+ * RED accesses its internal queue directly, not through EnqueueInternalQueue
+ * and DequeueInternalQueue: check that the occupancy counters follow it.
+ */
+class RedQueueDiscOccupancyTestCase : public TestCase
+{
+public:
+  RedQueueDiscOccupancyTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Check the occupancy counters against the internal queue
+   * \param queue the queue disc
+   * \param nPackets the expected number of packets
+   */
+  void CheckOccupancy (Ptr<RedQueueDiscOccupancy> queue, uint32_t nPackets);
+};
+
+RedQueueDiscOccupancyTestCase::RedQueueDiscOccupancyTestCase ()
+  : TestCase ("Check the occupancy counters of a queue disc accessing its internal queue directly")
+{
+}
+
+void
+RedQueueDiscOccupancyTestCase::CheckOccupancy (Ptr<RedQueueDiscOccupancy> queue, uint32_t nPackets)
+{
+  Ptr<QueueDisc::InternalQueue> internal = queue->GetInternalQueue (0);
+  NS_TEST_EXPECT_MSG_EQ (internal->GetNPackets (), nPackets, "Unexpected number of packets in the internal queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueueNPackets (0), internal->GetNPackets (),
+                         "The packet counter should match the internal queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueueNBytes (0), internal->GetNBytes (),
+                         "The byte counter should match the internal queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueuesNPackets (), internal->GetNPackets (),
+                         "The total packet counter should match the internal queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueuesNBytes (), internal->GetNBytes (),
+                         "The total byte counter should match the internal queue");
+}
+
+void
+RedQueueDiscOccupancyTestCase::DoRun (void)
+{
+  Ptr<RedQueueDiscOccupancy> queue = CreateObject<RedQueueDiscOccupancy> ();
+  queue->SetAttribute ("Mode", StringValue ("QUEUE_DISC_MODE_PACKETS"));
+  queue->SetAttribute ("MinTh", DoubleValue (20));
+  queue->SetAttribute ("MaxTh", DoubleValue (40));
+  queue->SetAttribute ("QueueLimit", UintegerValue (50));
+  queue->Initialize ();
+
+  Address dest;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (100 + i), dest, 0, false));
+    }
+  CheckOccupancy (queue, 10);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      queue->Dequeue ();
+    }
+  CheckOccupancy (queue, 7);
+  queue->GetInternalQueue (0)->Remove ();
+  CheckOccupancy (queue, 6);
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -536,5 +879,8 @@ public:
     : TestSuite ("red-queue-disc", UNIT)
   {
     AddTestCase (new RedQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new RedQueueDiscEstimatorTestCase (), TestCase::QUICK);
+    AddTestCase (new RedQueueDiscDropTestCase (), TestCase::QUICK);
+    AddTestCase (new RedQueueDiscOccupancyTestCase (), TestCase::QUICK);
   }
 } g_redQueueTestSuite; ///< the test suite
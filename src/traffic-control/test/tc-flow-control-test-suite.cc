@@ -110,8 +110,9 @@ public:
    * Constructor
    *
    * \param tt the test type
+   * \param burstSize the maximum number of packets sent to the device at once
    */
-  TcFlowControlTestCase (TestType tt);
+  TcFlowControlTestCase (TestType tt, uint32_t burstSize);
   virtual ~TcFlowControlTestCase ();
 private:
   virtual void DoRun (void);
@@ -143,11 +144,13 @@ private:
    */
   void CheckPacketsInQueueDisc (Ptr<NetDevice> dev, uint16_t nPackets, const char* msg);
   TestType m_type;       //!< the test type
+  uint32_t m_burstSize;  //!< the burst size of the queue disc
 };
 
-TcFlowControlTestCase::TcFlowControlTestCase (TestType tt)
+TcFlowControlTestCase::TcFlowControlTestCase (TestType tt, uint32_t burstSize)
   : TestCase ("Test the operation of the flow control mechanism"),
-    m_type (tt)
+    m_type (tt),
+    m_burstSize (burstSize)
 {
 }
 
@@ -226,7 +229,8 @@ TcFlowControlTestCase::DoRun (void)
   txDev->SetMtu (2500);
 
   TrafficControlHelper tch = TrafficControlHelper::Default ();
-  tch.Install (txDev);
+  QueueDiscContainer qdiscs = tch.Install (txDev);
+  qdiscs.Get (0)->SetAttribute ("BurstSize", UintegerValue (m_burstSize));
 
   // transmit 10 packets at time 0
   Simulator::Schedule (Time (Seconds (0)), &TcFlowControlTestCase::SendPackets,
@@ -395,7 +399,10 @@ public:
   TcFlowControlTestSuite ()
     : TestSuite ("tc-flow-control", UNIT)
   {
-    AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::PACKET_MODE), TestCase::QUICK);
-    AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::BYTE_MODE), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::PACKET_MODE, 1), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::BYTE_MODE, 1), TestCase::QUICK);
+    // the packets must be handed to the device in the same way when sent in bursts
+    AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::PACKET_MODE, 8), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::BYTE_MODE, 8), TestCase::QUICK);
   }
 } g_tcFlowControlTestSuite; ///< the test suite
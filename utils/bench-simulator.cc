@@ -23,6 +23,8 @@
 #include <fstream>
 #include <vector>
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include "ns3/core-module.h"
 
@@ -84,6 +86,11 @@ public:
 
   /// Run function
   void RunBench (void);
+  /**
+   * Run the hold model on a scheduler alone, without the simulator.
+   * \param factory the scheduler factory
+   */
+  void RunRaw (ObjectFactory factory);
 private:
   /// callback function
   void Cb (void);
@@ -130,6 +137,52 @@ Bench::RunBench (void)
 
 }
 
+void
+Bench::RunRaw (ObjectFactory factory)
+{
+  SystemWallClockMs time;
+  double init, simu;
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_context = 0;
+  uint32_t uid = 0;
+
+  DEB ("initializing");
+  time.Start ();
+  for (uint32_t i = 0; i < m_population; ++i)
+    {
+      ev.key.m_ts = (uint64_t) m_rand->GetValue ();
+      ev.key.m_uid = uid++;
+      scheduler->Insert (ev);
+    }
+  init = time.End ();
+  init /= 1000;
+
+  DEB ("running");
+  time.Start ();
+  for (uint32_t i = 0; i < m_total; ++i)
+    {
+      Scheduler::Event next = scheduler->RemoveNext ();
+      ev.key.m_ts = next.key.m_ts + (uint64_t) m_rand->GetValue ();
+      ev.key.m_uid = uid++;
+      scheduler->Insert (ev);
+    }
+  simu = time.End ();
+  simu /= 1000;
+  while (!scheduler->IsEmpty ())
+    {
+      scheduler->RemoveNext ();
+    }
+
+  LOG (std::setw (g_fwidth) << init <<
+       std::setw (g_fwidth) << (m_population / init) <<
+       std::setw (g_fwidth) << (init / m_population) <<
+       std::setw (g_fwidth) << simu <<
+       std::setw (g_fwidth) << (m_total / simu) <<
+       std::setw (g_fwidth) << (simu / m_total));
+}
+
 void
 Bench::Cb (void)
 {
@@ -145,12 +198,64 @@ Bench::Cb (void)
 }
 
 
+/**
+ * Read the event delays recorded by DesMetrics.
+ *
+ * Every event line of the DES Metrics json file is
+ * ["send_ctx","send_ts","recv_ctx","recv_ts"], with the times
+ * in time steps (ns with the default resolution); the delay of
+ * the event is recv_ts - send_ts.
+ *
+ * \param filename the DES Metrics json file
+ * \returns the event delays, in ns
+ */
+std::vector<double>
+ReadDesMetrics (std::string filename)
+{
+  std::ifstream input (filename.c_str ());
+  if (!input.is_open ())
+    {
+      LOGME ("cannot open " << filename);
+      exit (1);
+    }
+  std::vector<double> nsValues;
+  std::string line;
+  while (std::getline (input, line))
+    {
+      std::string::size_type start = line.find ("[\"");
+      if (start == std::string::npos)
+        {
+          continue;
+        }
+      long long send, sendTs, recv, recvTs;
+      if (sscanf (line.c_str () + start, "[\"%lld\",\"%lld\",\"%lld\",\"%lld\"]",
+                  &send, &sendTs, &recv, &recvTs) == 4 && recvTs >= sendTs)
+        {
+          nsValues.push_back (recvTs - sendTs);
+        }
+    }
+  return nsValues;
+}
+
 Ptr<RandomVariableStream>
-GetRandomStream (std::string filename)
+GetRandomStream (std::string filename, std::string desFilename)
 {
   Ptr<RandomVariableStream> stream = 0;
 
-  if (filename == "")
+  if (desFilename != "")
+    {
+      LOGME ("using event delays recorded by DesMetrics in " << desFilename);
+      std::vector<double> nsValues = ReadDesMetrics (desFilename);
+      LOGME ("found " << nsValues.size () << " events");
+      if (nsValues.empty ())
+        {
+          exit (1);
+        }
+      Ptr<DeterministicRandomVariable> drv = CreateObject<DeterministicRandomVariable> ();
+      drv->SetValueArray (&nsValues[0], nsValues.size ());
+      stream = drv;
+    }
+  else if (filename == "")
     {
       LOGME ("using default exponential distribution");
       Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
@@ -204,14 +309,19 @@ int main (int argc, char *argv[])
 {
 
   bool schedCal  = false;
+  bool schedDary = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool schedAll  = false;
+  bool raw       = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  std::string desFilename = "";
 
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
@@ -220,85 +330,143 @@ int main (int argc, char *argv[])
              "  an exponential distribution, with mean 100 ns,\n"
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
+             "  or the events of a real run recorded by DES Metrics\n"
+             "  (see ./waf configure --enable-des-metrics), given by\n"
+             "  the --des=\"<ns-3-trace.json>\" argument.\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "With --all, every scheduler is run in turn.\n"
+             "With --raw, the schedulers are driven directly, without\n"
+             "the simulator and the allocation of the events.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
+  cmd.AddValue ("dary",  "use DaryHeapScheduler",         schedDary);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("all",   "run all the schedulers",        schedAll);
+  cmd.AddValue ("raw",   "benchmark the schedulers alone", raw);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
+  cmd.AddValue ("des",   "DES Metrics file of a real run", desFilename);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
-  ObjectFactory factory ("ns3::MapScheduler");
-  if (schedCal)
+  std::vector<std::string> schedulers;
+  if (schedAll)
+    {
+      schedulers.push_back ("ns3::MapScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::DaryHeapScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::LadderScheduler");
+      schedulers.push_back ("ns3::ListScheduler");
+    }
+  else if (schedCal)
+    {
+      schedulers.push_back ("ns3::CalendarScheduler");
+    }
+  else if (schedDary)
+    {
+      schedulers.push_back ("ns3::DaryHeapScheduler");
+    }
+  else if (schedHeap)
+    {
+      schedulers.push_back ("ns3::HeapScheduler");
+    }
+  else if (schedLadder)
     {
-      factory.SetTypeId ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::LadderScheduler");
     }
-  if (schedHeap)
+  else if (schedList)
     {
-      factory.SetTypeId ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::ListScheduler");
     }
-  if (schedList)
+  else
     {
-      factory.SetTypeId ("ns3::ListScheduler");
+      schedulers.push_back ("ns3::MapScheduler");
     }
-  Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
 
   Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetRandomStream (GetRandomStream (filename, desFilename));
 
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
-
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (std::vector<std::string>::const_iterator s = schedulers.begin (); s != schedulers.end (); s++)
     {
-      std::cout << std::setw (g_fwidth) << i;
+      ObjectFactory factory (*s);
+      Simulator::SetScheduler (factory);
+
+      LOG ("");
+      LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+
+      // table header
+      LOG ("");
+      LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+           std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+           std::left << std::setw (3 * g_fwidth) << "Simulation:");
+      LOG (std::left << std::setw (g_fwidth) << "" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+      LOG (std::setfill ('-') <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::setfill (' ')
+           );
+
+      // prime
+      DEB ("priming");
+      std::cout << std::left << std::setw (g_fwidth) << "(prime)";
+      if (raw)
+        {
+          bench->RunRaw (factory);
+        }
+      else
+        {
+          bench->RunBench ();
+        }
+
+      bench->SetPopulation (pop);
+      bench->SetTotal (total);
+      for (uint32_t i = 0; i < runs; i++)
+        {
+          std::cout << std::setw (g_fwidth) << i;
 
-      bench->RunBench ();
+          if (raw)
+            {
+              bench->RunRaw (factory);
+            }
+          else
+            {
+              bench->RunBench ();
+            }
+        }
     }
 
+  LOG ("");
+  std::cout << g_me;
+  EventAllocator::PrintStats (std::cout);
+  LOG ("");
+
   LOG ("");
   Simulator::Destroy ();
   delete bench;